@@ -0,0 +1,123 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include "commandCodes.h"
+#include "ConflictDetector.h"
+#include "ThreadPool.h"
+
+/**
+ * Compares brute-force and spatial-hash conflict detection on synthetic
+ * traffic at a constant density (about 1000 aircraft per 100 km x 100 km
+ * sector), checks that both report the same conflict set, and prints the
+ * time per detection pass. The spatial-hash pass is also run on a thread
+ * pool, whose result must match the single-threaded one exactly.
+ *
+ * Usage: ConflictDetectionBench [maxAircraft] [bruteForceLimit] [threads]
+ */
+
+static std::vector<RadarTrack> generateTraffic(size_t n, std::mt19937& rng)
+{
+    const double sectorsPerSide = std::sqrt(n / 1000.0);
+    const double side = 100000.0 * std::max(1.0, sectorsPerSide);
+    const double pi = std::acos(-1.0);
+
+    std::uniform_real_distribution<double> pos(0.0, side);
+    std::uniform_real_distribution<double> alt(0.0, 25000.0);
+    std::uniform_real_distribution<double> speed(60.0, 250.0);
+    std::uniform_real_distribution<double> heading(0.0, 2 * pi);
+    std::uniform_real_distribution<double> climb(-10.0, 10.0);
+
+    std::vector<RadarTrack> tracks(n);
+    for (size_t i = 0; i < n; i++) {
+        double s = speed(rng), h = heading(rng);
+        tracks[i] = { (int)i + 1, pos(rng), pos(rng), alt(rng),
+                      s * std::cos(h), s * std::sin(h), climb(rng), 0, 0 };
+    }
+    return tracks;
+}
+
+static bool sameConflicts(const std::vector<Conflict>& a, const std::vector<Conflict>& b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].plane1 != b[i].plane1 || a[i].plane2 != b[i].plane2 ||
+            a[i].timeToClosestApproach != b[i].timeToClosestApproach) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename F>
+static double timeMs(F fn, int repeats)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        fn();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::milli>(elapsed).count() / repeats;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t maxAircraft = (argc > 1) ? (size_t)atol(argv[1]) : 20000;
+    size_t bruteForceLimit = (argc > 2) ? (size_t)atol(argv[2]) : 10000;
+    size_t threads = (argc > 3) ? (size_t)atol(argv[3]) : 0;
+
+    std::mt19937 rng(320);
+    ConflictDetector detector(3000.0, 1000.0, 120.0);
+    ThreadPool pool(threads);
+    ConflictDetector parallelDetector(3000.0, 1000.0, 120.0);
+    parallelDetector.setThreadPool(&pool);
+    int mismatches = 0;
+
+    std::cout << "Parallel pass uses " << pool.size() << " threads" << std::endl;
+    std::cout << std::setw(8) << "aircraft" << std::setw(12) << "conflicts"
+              << std::setw(12) << "candidates" << std::setw(14) << "brute ms"
+              << std::setw(14) << "grid ms" << std::setw(10) << "speedup"
+              << std::setw(14) << "parallel ms" << std::setw(10) << "speedup" << std::endl;
+
+    for (size_t n = 100; n <= maxAircraft; n *= 2) {
+        std::vector<RadarTrack> tracks = generateTraffic(n, rng);
+        std::vector<Conflict> grid, brute, parallel;
+
+        int repeats = n < 2000 ? 20 : 3;
+        double gridMs = timeMs([&]() { detector.detect(tracks, grid); }, repeats);
+        size_t candidateCount = detector.getCandidateCount();
+        double parallelMs = timeMs([&]() { parallelDetector.detect(tracks, parallel); }, repeats);
+        bool parallelMatches = sameConflicts(grid, parallel);
+
+        std::cout << std::setw(8) << n << std::setw(12) << grid.size()
+                  << std::setw(12) << candidateCount;
+
+        if (n <= bruteForceLimit) {
+            double bruteMs = timeMs([&]() { detector.detectBruteForce(tracks, brute); },
+                                    n < 2000 ? repeats : 1);
+            std::cout << std::setw(14) << std::fixed << std::setprecision(3) << bruteMs
+                      << std::setw(14) << gridMs
+                      << std::setw(9) << std::setprecision(1) << bruteMs / gridMs << "x";
+            if (!sameConflicts(grid, brute)) {
+                parallelMatches = false;
+            }
+        } else {
+            std::cout << std::setw(14) << "-" << std::setw(14) << std::fixed
+                      << std::setprecision(3) << gridMs << std::setw(10) << "-";
+        }
+        std::cout << std::setw(14) << std::setprecision(3) << parallelMs
+                  << std::setw(9) << std::setprecision(1) << gridMs / parallelMs << "x";
+        if (!parallelMatches) {
+            std::cout << "  MISMATCH";
+            mismatches++;
+        }
+        std::cout << std::endl;
+    }
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include "CpaKernel.h"
+
+/**
+ * Measures pair throughput of the scalar and AVX2 closest-point-of-approach
+ * kernels on random aircraft states and checks that both produce
+ * bit-identical results.
+ *
+ * Measure the release build. On the dev box AVX2 runs about 4x faster than
+ * scalar on 64-pair blocks, where the per-call broadcasts weigh most, 7x on
+ * the default 4099 and 5.5x on 100k-pair blocks that no longer fit in L2.
+ * The debug build (-O0) shows only about 2x: every intrinsic's operands go
+ * through the stack, so both kernels are bound by loads and stores rather
+ * than arithmetic.
+ *
+ * Usage: CpaKernelBench [blockSize] [iterations]
+ */
+
+typedef std::vector<double> Column;
+
+struct Block {
+    Column x, y, z, vx, vy, vz;
+};
+
+static Block generateBlock(size_t n, std::mt19937& rng)
+{
+    std::uniform_real_distribution<double> pos(0.0, 100000.0);
+    std::uniform_real_distribution<double> alt(0.0, 25000.0);
+    std::uniform_real_distribution<double> speed(-250.0, 250.0);
+    std::uniform_real_distribution<double> climb(-10.0, 10.0);
+
+    Block b;
+    b.x.resize(n);  b.y.resize(n);  b.z.resize(n);
+    b.vx.resize(n); b.vy.resize(n); b.vz.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        b.x[i] = pos(rng);    b.y[i] = pos(rng);    b.z[i] = alt(rng);
+        b.vx[i] = speed(rng); b.vy[i] = speed(rng); b.vz[i] = climb(rng);
+    }
+
+    // A few parallel tracks to exercise the zero relative velocity branch
+    for (size_t i = 0; i < n; i += 17) {
+        b.vx[i] = 100.0; b.vy[i] = 0.0; b.vz[i] = 0.0;
+    }
+    return b;
+}
+
+static double runKernel(CpaKernelFn kernel, const Block& b, size_t iterations,
+                        Column& t, Column& h, Column& v)
+{
+    const size_t n = b.x.size();
+    CpaCandidates cand = { b.x.data(), b.y.data(), b.z.data(),
+                           b.vx.data(), b.vy.data(), b.vz.data() };
+    CpaResults out = { t.data(), h.data(), v.data() };
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t it = 0; it < iterations; it++) {
+        size_t r = it % n;
+        CpaReference ref = { b.x[r], b.y[r], b.z[r], 100.0, 0.0, 0.0 };
+        kernel(ref, cand, n, out);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    return (double)(n * iterations) / seconds / 1e6;
+}
+
+static bool sameBits(const Column& a, const Column& b)
+{
+    return memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t blockSize = (argc > 1) ? (size_t)atol(argv[1]) : 4099;
+    size_t iterations = (argc > 2) ? (size_t)atol(argv[2]) : 20000;
+    if (blockSize == 0 || iterations == 0) {
+        std::cerr << "Usage: " << argv[0] << " [blockSize] [iterations]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(42);
+    Block b = generateBlock(blockSize, rng);
+    Column st(blockSize), sh(blockSize), sv(blockSize);
+
+    std::cout << "Block size: " << blockSize << ", iterations: " << iterations
+              << ", selected kernel: " << cpaKernelName() << std::endl;
+#ifndef __OPTIMIZE__
+    std::cout << "Unoptimized build: the AVX2 speedup is far below release (BUILD_PROFILE=release)" << std::endl;
+#endif
+
+    double scalarRate = runKernel(cpaBatchScalar, b, iterations, st, sh, sv);
+    std::cout << std::setw(8) << "scalar" << std::fixed << std::setprecision(1)
+              << std::setw(10) << scalarRate << " Mpairs/s" << std::endl;
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (!cpaAvx2Supported()) {
+        std::cout << std::setw(8) << "avx2" << "  not supported on this CPU" << std::endl;
+        return 0;
+    }
+
+    Column at(blockSize), ah(blockSize), av(blockSize);
+    double avxRate = runKernel(cpaBatchAvx2, b, iterations, at, ah, av);
+    std::cout << std::setw(8) << "avx2" << std::setw(10) << avxRate << " Mpairs/s"
+              << std::setw(8) << std::setprecision(2) << avxRate / scalarRate << "x"
+              << std::endl;
+
+    if (!sameBits(st, at) || !sameBits(sh, ah) || !sameBits(sv, av)) {
+        std::cout << "MISMATCH between scalar and AVX2 results" << std::endl;
+        return 1;
+    }
+    std::cout << "Scalar and AVX2 results are bit-identical" << std::endl;
+#endif
+
+    return 0;
+}
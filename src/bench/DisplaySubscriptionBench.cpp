@@ -0,0 +1,141 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include "DisplaySubscriptions.h"
+
+/**
+ * Splits the 100 km sector among sector displays and finds the aircraft
+ * each one is sent, as ComputerSystem does for every grid: once through
+ * DisplaySubscriptions (index and select, which builds the bucket index
+ * or scans the frame) and once by checking every aircraft against every
+ * viewport. Checks both pick the same aircraft, and compares the time per
+ * frame and the bytes each display is sent with sending it the whole
+ * airspace.
+ *
+ * Usage: DisplaySubscriptionBench [frames]
+ */
+
+static std::vector<AircraftDisplayEntry> traffic(size_t aircraft, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> pos(0.0, 100000.0);
+    std::uniform_real_distribution<double> altitude(0.0, 25000.0);
+    std::vector<AircraftDisplayEntry> out(aircraft);
+    for (size_t i = 0; i < aircraft; i++) {
+        double x = pos(rng), y = pos(rng);
+        out[i] = { (int)i + 1, 0, { x, y, altitude(rng) }, { 0.0, 0.0, 0.0 } };
+    }
+    return out;
+}
+
+/** `side` x `side` sector displays over the sector, each shown in `bands` altitude bands */
+static std::vector<DisplayViewport> sectors(int side, int bands) {
+    std::vector<DisplayViewport> out;
+    double width = 100000.0 / side, height = 25000.0 / bands;
+    for (int b = 0; b < bands; b++) {
+        for (int r = 0; r < side; r++) {
+            for (int c = 0; c < side; c++) {
+                out.push_back({ { c * width, r * width, b * height },
+                                { (c + 1) * width, (r + 1) * width, (b + 1) * height } });
+            }
+        }
+    }
+    return out;
+}
+
+static void scan(const std::vector<AircraftDisplayEntry>& aircraft, const DisplayViewport& v,
+                 std::vector<AircraftDisplayEntry>& out) {
+    out.clear();
+    for (const AircraftDisplayEntry& a : aircraft) {
+        if (a.position.x >= v.min[0] && a.position.x <= v.max[0] && a.position.y >= v.min[1] &&
+            a.position.y <= v.max[1] && a.position.z >= v.min[2] && a.position.z <= v.max[2]) {
+            out.push_back(a);
+        }
+    }
+}
+
+/** The index sends aircraft by bucket, the scan in frame order */
+static bool same(const std::vector<AircraftDisplayEntry>& a, const std::vector<AircraftDisplayEntry>& b) {
+    std::vector<int> idsA, idsB;
+    for (const AircraftDisplayEntry& e : a) {
+        idsA.push_back(e.planeId);
+    }
+    for (const AircraftDisplayEntry& e : b) {
+        idsB.push_back(e.planeId);
+    }
+    std::sort(idsA.begin(), idsA.end());
+    std::sort(idsB.begin(), idsB.end());
+    return idsA == idsB;
+}
+
+int main(int argc, char* argv[]) {
+    int frames = (argc > 1) ? std::max(1, atoi(argv[1])) : 200;
+
+    struct Case {
+        const char* name;
+        std::vector<DisplayViewport> viewports;
+    } cases[] = {
+        { "1 display, whole sector", sectors(1, 1) },
+        { "4 displays of 50 km", sectors(2, 1) },
+        { "16 displays of 25 km", sectors(4, 1) },
+        { "16 displays of 50 km x 6 km", sectors(2, 4) },
+    };
+
+    std::cout << std::left << std::setw(30) << "Displays" << std::right << std::setw(10) << "aircraft"
+              << std::setw(12) << "index us" << std::setw(12) << "scan us" << std::setw(10) << "speedup"
+              << std::setw(16) << "sent each" << std::setw(14) << "KiB each" << std::setw(14) << "KiB whole"
+              << std::endl;
+    bool match = true;
+    for (size_t aircraft : { 1000, 10000 }) {
+        std::vector<AircraftDisplayEntry> frame = traffic(aircraft, 42);
+        for (const Case& c : cases) {
+            // Subscribed as ComputerSystem has them; nothing is sent
+            DisplaySubscriptions displays;
+            for (size_t v = 0; v < c.viewports.size(); v++) {
+                displays.subscribe(1, (int)v + 1, c.viewports[v]);
+            }
+            std::vector<AircraftDisplayEntry> selected, scanned;
+            size_t sent = 0;
+
+            auto begin = std::chrono::steady_clock::now();
+            for (int f = 0; f < frames; f++) {
+                displays.index(frame.data(), frame.size());
+                for (size_t v = 0; v < displays.size(); v++) {
+                    displays.select(displays.at(v).viewport, selected);
+                    sent += selected.size();
+                }
+            }
+            double indexUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+
+            begin = std::chrono::steady_clock::now();
+            for (int f = 0; f < frames; f++) {
+                for (const DisplayViewport& v : c.viewports) {
+                    scan(frame, v, scanned);
+                }
+            }
+            double scanUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+
+            for (const DisplayViewport& v : c.viewports) {
+                displays.select(v, selected);
+                scan(frame, v, scanned);
+                match = match && same(selected, scanned);
+            }
+
+            double perDisplay = (double)sent / frames / c.viewports.size();
+            std::cout << std::left << std::setw(30) << c.name << std::right << std::setw(10) << aircraft
+                      << std::fixed << std::setprecision(1) << std::setw(12) << indexUs / frames
+                      << std::setw(12) << scanUs / frames << std::setw(9) << scanUs / indexUs << "x"
+                      << std::setw(16) << perDisplay
+                      << std::setw(14) << perDisplay * sizeof(AircraftDisplayEntry) / 1024
+                      << std::setw(14) << (double)aircraft * sizeof(AircraftDisplayEntry) / 1024 << std::endl;
+        }
+    }
+    if (!match) {
+        std::cout << "MISMATCH: the index and the scan send different aircraft" << std::endl;
+    }
+    return match ? 0 : 1;
+}
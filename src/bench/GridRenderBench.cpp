@@ -0,0 +1,393 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <new>
+#include "GridRenderer.h"
+
+/**
+ * Renders the DataDisplay plan-view grid for growing traffic with the
+ * GridRenderer and with the renderer it replaced, which scanned every row
+ * and column for each aircraft and built the cells with stringstreams.
+ * Checks both print the same grid while every cell's ids fit, and counts
+ * heap allocations per frame once the renderer has warmed up. Also times
+ * a zoomed-in view and a 200 x 200 grid.
+ *
+ * Times the level-of-detail modes on busy traffic (ids, counts, density
+ * shading) with 1% of the aircraft flagged in conflict, checking every
+ * cell holding one of those shows it by id over the summary.
+ *
+ * Renders five 5 km altitude bands and a side profile in one pass, and
+ * each band with a renderer of its own, checking both draw the same bands.
+ *
+ * Then refreshes a live terminal at 10 Hz and compares the bytes written
+ * per frame by the ANSI updates (GridRenderer::terminalUpdate) with
+ * printing every grid in full, applying the updates to a model of the
+ * screen to check it always shows the latest grid.
+ *
+ * Usage: GridRenderBench [frames]
+ */
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+static std::string centerText(const std::string& text, int width) {
+    if ((int)text.size() >= width)
+        return text;
+    int totalPadding = width - text.size();
+    int leftPadding = totalPadding / 2;
+    int rightPadding = totalPadding - leftPadding;
+    return std::string(leftPadding, ' ') + text + std::string(rightPadding, ' ');
+}
+
+/** DataDisplay::generateGrid as it was */
+static std::string legacyGrid(const std::vector<AircraftDisplayEntry>& aircraft) {
+    constexpr int rowSize = 25;
+    constexpr int colSize = 25;
+    constexpr int cell = 4000;
+    constexpr int cellWidth = 5;
+    std::string grid[rowSize][colSize];
+
+    for (size_t i = 0; i < aircraft.size(); i++) {
+        if (!std::isfinite(aircraft[i].position.x) || !std::isfinite(aircraft[i].position.y)) {
+            continue;
+        }
+        double px = aircraft[i].position.x;
+        double py = aircraft[i].position.y;
+        int planeId = aircraft[i].planeId;
+        for (int r = 0; r < rowSize; r++) {
+            double yMin = cell * r, yMax = cell * (r + 1);
+            if (py >= yMin && py < yMax) {
+                for (int c = 0; c < colSize; c++) {
+                    double xMin = cell * c, xMax = cell * (c + 1);
+                    if (px >= xMin && px < xMax) {
+                        if (!grid[r][c].empty())
+                            grid[r][c] += ",";
+                        std::stringstream ss;
+                        ss << std::setw(2) << std::setfill(' ') << planeId;
+                        grid[r][c] += ss.str();
+                    }
+                }
+            }
+        }
+    }
+
+    std::stringstream out;
+    for (int r = 0; r < rowSize; r++) {
+        out << "\n";
+        for (int c = 0; c < colSize; c++) {
+            std::string cellContent = grid[r][c].empty() ? " " : grid[r][c];
+            out << "|" << centerText(cellContent, cellWidth);
+        }
+    }
+    out << "\n";
+    return out.str();
+}
+
+/** Aircraft spread over the 100 km sector up to 25 km, moving a little each frame */
+static std::vector<std::vector<AircraftDisplayEntry>> traffic(size_t aircraft, int frames, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> pos(0.0, 100000.0);
+    std::uniform_real_distribution<double> speed(-250.0, 250.0);
+    std::uniform_real_distribution<double> altitude(0.0, 25000.0);
+    std::vector<AircraftDisplayEntry> now(aircraft);
+    for (size_t i = 0; i < aircraft; i++) {
+        double x = pos(rng), y = pos(rng);
+        now[i] = { (int)i + 1, 0, { x, y, altitude(rng) }, { speed(rng), speed(rng), 0.0 } };
+    }
+    std::vector<std::vector<AircraftDisplayEntry>> out;
+    for (int f = 0; f < frames; f++) {
+        out.push_back(now);
+        for (AircraftDisplayEntry& a : now) {
+            a.position = a.position.sum(a.velocity);
+        }
+    }
+    return out;
+}
+
+/** Enough of a terminal to apply terminalUpdate(): cursor moves, clear to end, text */
+struct Screen {
+    std::vector<std::string> lines;
+
+    void apply(const std::string& ansi) {
+        size_t line = 0, column = 0;
+        for (size_t i = 0; i < ansi.size();) {
+            if (ansi[i] == '\x1b') {
+                size_t end = ansi.find_first_of("HJ", i);
+                if (ansi[end] == 'H') {
+                    line = std::strtoul(ansi.c_str() + i + 2, nullptr, 10) - 1;
+                    column = std::strtoul(ansi.c_str() + ansi.find(';', i) + 1, nullptr, 10) - 1;
+                } else {
+                    lines.resize(std::min(lines.size(), line + 1));
+                    if (line < lines.size()) {
+                        lines[line].resize(std::min(lines[line].size(), column));
+                    }
+                }
+                i = end + 1;
+                continue;
+            }
+            if (lines.size() <= line) {
+                lines.resize(line + 1);
+            }
+            if (lines[line].size() <= column) {
+                lines[line].resize(column + 1, ' ');
+            }
+            lines[line][column++] = ansi[i++];
+        }
+    }
+
+    /** The grid as the renderer prints it, read back from line `first` */
+    std::string grid(size_t first, size_t rows) const {
+        std::string out;
+        for (size_t r = 0; r < rows; r++) {
+            out += '\n';
+            out += (first - 1 + r < lines.size()) ? lines[first - 1 + r] : "";
+        }
+        return out + '\n';
+    }
+};
+
+template <typename Render>
+static double timeFrames(const std::vector<std::vector<AircraftDisplayEntry>>& frames, Render render,
+                         size_t& allocationsPerFrame) {
+    render(frames[0]);      // Warm up
+    size_t before = allocations;
+    auto begin = std::chrono::steady_clock::now();
+    for (const auto& frame : frames) {
+        render(frame);
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+    allocationsPerFrame = (allocations - before) / frames.size();
+    return us / frames.size();
+}
+
+int main(int argc, char* argv[]) {
+    int frames = (argc > 1) ? std::max(1, atoi(argv[1])) : 200;
+
+    // Sparse traffic. The old renderer let crowded cells overflow and break the
+    // row, where the new one marks them with '+'; compare the other frames.
+    bool match = true;
+    int compared = 0;
+    {
+        GridRenderer renderer;
+        for (const auto& frame : traffic(60, 200, 7)) {
+            const std::string& rendered = renderer.render(frame.data(), frame.size());
+            std::string legacy = legacyGrid(frame);
+            if (legacy.size() == rendered.size()) {
+                match = match && legacy == rendered;
+                compared++;
+            }
+        }
+    }
+
+    std::cout << "Plan-view grid, 25 x 25 cells of 4 km; " << compared << " sparse frames "
+              << (match ? "match" : "DO NOT MATCH") << " the old renderer" << std::endl
+              << std::setw(10) << "aircraft" << std::setw(14) << "old us" << std::setw(12) << "allocs"
+              << std::setw(14) << "new us" << std::setw(12) << "allocs" << std::setw(10) << "speedup" << std::endl;
+    for (size_t aircraft : { 10, 100, 1000, 5000, 10000 }) {
+        auto scenario = traffic(aircraft, frames, 42);
+        GridRenderer renderer;
+        size_t oldAllocs, newAllocs;
+        int oldFrames = std::max(1, frames * 10 / (int)aircraft);
+        std::vector<std::vector<AircraftDisplayEntry>> fewer(scenario.begin(), scenario.begin() +
+                                                             std::min<size_t>(scenario.size(), oldFrames));
+        size_t sink = 0;
+        double oldUs = timeFrames(fewer, [&sink](const std::vector<AircraftDisplayEntry>& f) {
+            sink += legacyGrid(f).size();
+        }, oldAllocs);
+        double newUs = timeFrames(scenario, [&](const std::vector<AircraftDisplayEntry>& f) {
+            sink += renderer.render(f.data(), f.size()).size();
+        }, newAllocs);
+        std::cout << std::setw(10) << aircraft << std::fixed << std::setprecision(1) << std::setw(14) << oldUs
+                  << std::setw(12) << oldAllocs << std::setw(14) << newUs << std::setw(12) << newAllocs
+                  << std::setw(9) << oldUs / newUs << "x" << (sink ? "" : " ") << std::endl;
+    }
+
+    auto scenario = traffic(10000, frames, 42);
+    GridView zoomed;
+    zoomed.zoom = 8;
+    zoomed.centerX = 30000;
+    zoomed.centerY = 70000;
+    GridView fine;
+    fine.columns = fine.rows = 200;
+    fine.cellSize = 500;
+    fine.cellWidth = 3;
+    struct Case {
+        const char* name;
+        GridView view;
+    } cases[] = { { "zoom 8 on (30 km, 70 km)", zoomed }, { "200 x 200 cells of 500 m", fine } };
+    for (const Case& c : cases) {
+        GridRenderer renderer(c.view);
+        size_t allocs;
+        double us = timeFrames(scenario, [&renderer](const std::vector<AircraftDisplayEntry>& f) {
+            renderer.render(f.data(), f.size());
+        }, allocs);
+        std::cout << "10000 aircraft, " << std::left << std::setw(26) << c.name << std::right
+                  << std::setprecision(1) << std::setw(8) << us << " us per frame, " << allocs
+                  << " allocations, " << renderer.getPlotted() << " aircraft in view, "
+                  << renderer.render(scenario[0].data(), scenario[0].size()).size() << " bytes" << std::endl;
+    }
+
+    // Level of detail: the same busy frames listed, counted and shaded
+    std::cout << "Level of detail, 25 x 25 grid, 1% of aircraft in conflict" << std::endl
+              << std::setw(10) << "aircraft" << std::setw(10) << "ids us" << std::setw(12) << "counts us"
+              << std::setw(12) << "density us" << std::setw(10) << "auto" << std::setw(16) << "overlay cells"
+              << std::endl;
+    bool overlaid = true;
+    for (size_t aircraft : { 100, 1000, 5000, 10000 }) {
+        auto scenario = traffic(aircraft, frames, 42);
+        for (auto& frame : scenario) {
+            for (size_t i = 0; i < frame.size(); i += 100) {
+                frame[i].flags = AIRCRAFT_IN_CONFLICT;
+            }
+        }
+        double us[3];
+        const GridDetail details[3] = { GRID_DETAIL_IDS, GRID_DETAIL_COUNTS, GRID_DETAIL_DENSITY };
+        size_t overlayCells = 0;
+        for (int d = 0; d < 3; d++) {
+            GridView view;
+            view.detail = details[d];
+            GridRenderer renderer(view);
+            size_t allocs;
+            us[d] = timeFrames(scenario, [&renderer](const std::vector<AircraftDisplayEntry>& f) {
+                renderer.render(f.data(), f.size());
+            }, allocs);
+            if (details[d] == GRID_DETAIL_IDS) {
+                continue;
+            }
+            // Each cell holding a flagged aircraft starts with '!' (cells are wide enough for one id)
+            std::vector<bool> expected(25 * 25, false);
+            for (const AircraftDisplayEntry& a : scenario[0]) {
+                if ((a.flags & AIRCRAFT_IN_CONFLICT) && a.position.x >= 0 && a.position.x < 100000 &&
+                    a.position.y >= 0 && a.position.y < 100000) {
+                    expected[(int)(a.position.y / 4000) * 25 + (int)(a.position.x / 4000)] = true;
+                }
+            }
+            const std::string& text = renderer.render(scenario[0].data(), scenario[0].size());
+            overlayCells = 0;
+            for (int cell = 0; cell < 25 * 25; cell++) {
+                const char* shown = text.c_str() + (cell / 25) * (1 + 25 * 6) + (cell % 25) * 6 + 2;
+                bool marked = std::string(shown, 5).find('!') != std::string::npos;
+                overlaid = overlaid && marked == expected[cell];
+                overlayCells += marked;
+            }
+        }
+        GridRenderer automatic;
+        automatic.render(scenario[0].data(), scenario[0].size());
+        std::cout << std::setw(10) << aircraft << std::setprecision(1) << std::setw(10) << us[0] << std::setw(12)
+                  << us[1] << std::setw(12) << us[2] << std::setw(10)
+                  << (automatic.getDetail() == GRID_DETAIL_DENSITY ? "density" : "ids") << std::setw(16)
+                  << overlayCells << std::endl;
+    }
+    if (!overlaid) {
+        std::cout << "MISMATCH: conflict overlay does not mark the cells of flagged aircraft" << std::endl;
+    }
+
+    // Altitude: every view from one pass, or one renderer per band
+    std::cout << "Altitude views, 25 x 25 grid, 5 bands of 5 km and a profile of 25 rows of 1 km" << std::endl
+              << std::setw(10) << "aircraft" << std::setw(12) << "plan us" << std::setw(16) << "one pass us"
+              << std::setw(16) << "per band us" << std::setw(10) << "lines" << std::endl;
+    bool sliced = true;
+    for (size_t aircraft : { 100, 1000, 10000 }) {
+        auto scenario = traffic(aircraft, frames, 42);
+        GridView all;
+        all.detail = GRID_DETAIL_IDS;
+        all.bands = 5;
+        all.profileRows = 25;
+        GridRenderer combined(all);
+        std::vector<GridRenderer> perBand;
+        for (int b = 0; b < all.bands; b++) {
+            GridView one;
+            one.detail = GRID_DETAIL_IDS;
+            one.bands = 1;
+            one.altitudeFloor = b * all.bandHeight;
+            perBand.emplace_back(one);
+        }
+        GridRenderer plan;
+        size_t allocs;
+        double planUs = timeFrames(scenario, [&plan](const std::vector<AircraftDisplayEntry>& f) {
+            plan.render(f.data(), f.size());
+        }, allocs);
+        double combinedUs = timeFrames(scenario, [&combined](const std::vector<AircraftDisplayEntry>& f) {
+            combined.render(f.data(), f.size());
+        }, allocs);
+        double perBandUs = timeFrames(scenario, [&perBand](const std::vector<AircraftDisplayEntry>& f) {
+            for (GridRenderer& r : perBand) {
+                r.render(f.data(), f.size());
+            }
+        }, allocs);
+
+        // The highest band comes first; each is a title line and 25 rows
+        const std::string& text = combined.render(scenario[0].data(), scenario[0].size());
+        size_t bandBytes = 26 * (1 + 25 * 6);
+        for (int b = 0; b < all.bands; b++) {
+            const std::string& own = perBand[b].render(scenario[0].data(), scenario[0].size());
+            sliced = sliced && text.compare((all.bands - 1 - b) * bandBytes, bandBytes, own, 0, bandBytes) == 0;
+        }
+        std::cout << std::setw(10) << aircraft << std::setprecision(1) << std::setw(12) << planUs
+                  << std::setw(16) << combinedUs << std::setw(16) << perBandUs << std::setw(10)
+                  << combined.getLines() << std::endl;
+    }
+    if (!sliced) {
+        std::cout << "MISMATCH: the bands drawn in one pass differ from those drawn one at a time" << std::endl;
+    }
+
+    // Live terminal at 10 Hz: aircraft move a tenth of their speed per frame
+    std::cout << "Live terminal at 10 Hz, 25 x 25 grid" << std::endl
+              << std::setw(10) << "aircraft" << std::setw(14) << "full bytes" << std::setw(14) << "update bytes"
+              << std::setw(16) << "cells changed" << std::setw(12) << "update us" << std::endl;
+    bool shown = true;
+    for (size_t aircraft : { 10, 100, 1000, 5000 }) {
+        auto scenario = traffic(aircraft, frames, 42);
+        for (size_t f = 0; f < scenario.size(); f++) {
+            for (size_t i = 0; i < aircraft; i++) {
+                scenario[f][i].position = scenario[0][i].position.sum(scenario[0][i].velocity.scalarMultiplication(f * 0.1));
+            }
+        }
+        GridRenderer renderer;
+        Screen screen;
+        size_t fullBytes = 0, updateBytes = 0, changed = 0;
+        double updateUs = 0;
+        for (size_t f = 0; f < scenario.size(); f++) {
+            const std::string& frame = renderer.render(scenario[f].data(), scenario[f].size());
+            auto begin = std::chrono::steady_clock::now();
+            const std::string& update = renderer.terminalUpdate(2);
+            updateUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+            screen.apply(update);
+            shown = shown && screen.grid(2, 25) == frame;
+            if (f > 0) {    // The first update draws the whole grid
+                fullBytes += frame.size();
+                updateBytes += update.size();
+                changed += renderer.getCellsChanged();
+            }
+        }
+        size_t n = std::max<size_t>(1, scenario.size() - 1);
+        std::cout << std::setw(10) << aircraft << std::setw(14) << fullBytes / n << std::setw(14) << updateBytes / n
+                  << std::setw(16) << changed / n << std::setprecision(2) << std::setw(12) << updateUs / scenario.size()
+                  << std::endl;
+    }
+    if (!shown) {
+        std::cout << "MISMATCH: the terminal does not show the latest grid" << std::endl;
+    }
+    return (match && overlaid && sliced && shown) ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "utils.h"
+#include "AirspaceHistory.h"
+
+/**
+ * Records a cruise scenario at 1 s radar frames, where 1% of the aircraft
+ * turn each frame, into an airspace history with residual blocks and with
+ * column blocks, and compares size and cost per frame with the former
+ * text log, which opened airspacelog.txt, fprintf'd one line per aircraft
+ * and closed it. Then reads every frame back, checking residual frames
+ * are within half a quantum of what was recorded and column frames are
+ * exact, and times seeking to random instants and decoding from there.
+ *
+ * Usage: HistoryBench [aircraft] [frames]
+ */
+
+static const char* RESIDUAL_DIR = "/tmp/atc/logs/history_bench";
+static const char* COLUMNS_DIR = "/tmp/atc/logs/history_bench_columns";
+static const char* BASELINE_LOG = "/tmp/atc/logs/history_bench_baseline.txt";
+
+static std::vector<RadarTrack> generateTraffic(size_t n, std::mt19937& rng)
+{
+    const double pi = std::acos(-1.0);
+    std::uniform_real_distribution<double> pos(0.0, 100000.0);
+    std::uniform_real_distribution<double> alt(0.0, 25000.0);
+    std::uniform_real_distribution<double> speed(60.0, 250.0);
+    std::uniform_real_distribution<double> heading(0.0, 2 * pi);
+
+    std::vector<RadarTrack> tracks(n);
+    for (size_t i = 0; i < n; i++) {
+        double s = speed(rng), h = heading(rng);
+        tracks[i] = { (int)i + 1, pos(rng), pos(rng), alt(rng),
+                      s * std::cos(h), s * std::sin(h), 0.0, 0, (uint32_t)i + 1 };
+    }
+    return tracks;
+}
+
+static void advance(std::vector<RadarTrack>& tracks, int frame)
+{
+    for (size_t i = 0; i < tracks.size(); i++) {
+        RadarTrack& t = tracks[i];
+        t.x += t.vx;
+        t.y += t.vy;
+        t.z += t.vz;
+        if ((i + frame) % 100 == 0) {
+            double c = std::cos(0.1), s = std::sin(0.1);
+            double vx = t.vx * c - t.vy * s;
+            t.vy = t.vx * s + t.vy * c;
+            t.vx = vx;
+        }
+    }
+}
+
+static std::vector<std::vector<RadarTrack>> generateFrames(size_t aircraft, int frames)
+{
+    std::mt19937 rng(42);
+    std::vector<std::vector<RadarTrack>> out;
+    std::vector<RadarTrack> tracks = generateTraffic(aircraft, rng);
+    for (int f = 0; f < frames; f++) {
+        out.push_back(tracks);
+        advance(tracks, f);
+    }
+    return out;
+}
+
+static std::string resetDir(const char* dir)
+{
+    std::string d = dir;
+    unlink((d + "/" HISTORY_INDEX_FILE).c_str());
+    unlink((d + "/" HISTORY_TRACKS_FILE).c_str());
+    unlink((d + "/" HISTORY_BLOCKS_FILE).c_str());
+    return d;
+}
+
+/** Microseconds per frame to record `frames`, and the resulting size */
+static double record(const std::string& dir, HistoryBlockEncoding encoding, int64_t t0,
+                     const std::vector<std::vector<RadarTrack>>& frames, uint64_t& bytes)
+{
+    AirspaceHistoryWriter writer;
+    if (!writer.open(dir, encoding)) {
+        return -1;
+    }
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < frames.size(); f++) {
+        writer.append(t0 + (int64_t)f * 1000000000LL, (double)f, 2 * (uint64_t)(f + 1),
+                      frames[f].data(), frames[f].size());
+    }
+    double us = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - begin).count() / frames.size();
+    bytes = writer.bytesUsed();
+    return us;
+}
+
+static void textLog(const std::vector<RadarTrack>& tracks, double t)
+{
+    FILE* fp = fopen(BASELINE_LOG, "a");
+    if (!fp) {
+        return;
+    }
+    fprintf(fp, "%s Logging at t=%.1f\n", printTimeStamp().c_str(), t);
+    for (const RadarTrack& r : tracks) {
+        fprintf(fp, " Plane %d => (%.1f,%.1f,%.1f) / vel(%.1f,%.1f,%.1f)\n",
+                r.planeId, r.x, r.y, r.z, r.vx, r.vy, r.vz);
+    }
+    fprintf(fp, "------------------------\n");
+    fclose(fp);
+}
+
+static bool sameFrame(const HistoryFrame& f, const std::vector<RadarTrack>& tracks, double tolerance)
+{
+    if (f.size() != tracks.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < tracks.size(); i++) {
+        const RadarTrack& t = tracks[i];
+        if (f.ids[i] != t.planeId ||
+            std::fabs(f.x[i] - t.x) > tolerance || std::fabs(f.y[i] - t.y) > tolerance ||
+            std::fabs(f.z[i] - t.z) > tolerance || std::fabs(f.vx[i] - t.vx) > tolerance ||
+            std::fabs(f.vy[i] - t.vy) > tolerance || std::fabs(f.vz[i] - t.vz) > tolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Microseconds per frame to read every frame in order; `match` tells if all compared equal */
+static double readBack(const std::string& dir, const std::vector<std::vector<RadarTrack>>& frames,
+                       double tolerance, bool& match)
+{
+    AirspaceHistoryReader reader;
+    match = reader.open(dir) && reader.tickCount() == frames.size();
+    HistoryFrame frame;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t f = 0; match && f < frames.size(); f++) {
+        match = reader.readFrame(f, frame) && sameFrame(frame, frames[f], tolerance);
+    }
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - begin).count() / frames.size();
+}
+
+int main(int argc, char* argv[])
+{
+    size_t aircraft = (argc > 1) ? (size_t)atol(argv[1]) : 1000;
+    int frames = (argc > 2) ? std::max(1, atoi(argv[2])) : 600;
+
+    ensureLogDirectories();
+    std::string residualDir = resetDir(RESIDUAL_DIR);
+    std::string columnsDir = resetDir(COLUMNS_DIR);
+    unlink(BASELINE_LOG);
+
+    const std::vector<std::vector<RadarTrack>> recorded = generateFrames(aircraft, frames);
+    const int64_t t0 = 1700000000LL * 1000000000LL;
+
+    uint64_t residualBytes = 0, columnsBytes = 0;
+    double residualUs = record(residualDir, HISTORY_BLOCK_RESIDUAL, t0, recorded, residualBytes);
+    double columnsUs = record(columnsDir, HISTORY_BLOCK_COLUMNS, t0, recorded, columnsBytes);
+    if (residualUs < 0 || columnsUs < 0) {
+        std::cerr << "Cannot open history in " << RESIDUAL_DIR << " or " << COLUMNS_DIR << std::endl;
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        textLog(recorded[f], f);
+    }
+    double textUs = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - begin).count() / frames;
+    long textBytes = 0;
+    if (FILE* fp = fopen(BASELINE_LOG, "r")) {
+        fseek(fp, 0, SEEK_END);
+        textBytes = ftell(fp);
+        fclose(fp);
+    }
+
+    bool residualMatch, columnsMatch;
+    double tolerance = std::max(HISTORY_POSITION_QUANTUM, HISTORY_VELOCITY_QUANTUM) / 2 + 1e-9;
+    double residualReadUs = readBack(residualDir, recorded, tolerance, residualMatch);
+    double columnsReadUs = readBack(columnsDir, recorded, 0.0, columnsMatch);
+
+    // Random access: seek to an instant, then decode that frame from its keyframe
+    AirspaceHistoryReader reader;
+    reader.open(residualDir);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int64_t> when(t0, t0 + (frames - 1) * 1000000000LL);
+    const int seeks = 100000, randomReads = std::max(1, std::min(200, frames));
+    volatile uint64_t sink = 0;
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < seeks; i++) {
+        sink += reader.seek(when(rng));
+    }
+    double seekNs = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - begin).count() / seeks;
+    HistoryFrame frame;
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < randomReads; i++) {
+        reader.readFrame(reader.seek(when(rng)), frame);
+    }
+    double randomUs = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - begin).count() / randomReads;
+
+    bool match = residualMatch && columnsMatch;
+    std::cout << "Airspace history, " << aircraft << " aircraft x " << frames << " frames" << std::endl
+              << std::fixed << std::setprecision(1)
+              << "  residual blocks  " << std::setw(9) << residualUs << " us per frame, "
+              << std::setw(8) << residualBytes / 1048576.0 << " MiB ("
+              << (double)columnsBytes / std::max<uint64_t>(1, residualBytes) << "x smaller than columns, "
+              << (double)textBytes / std::max<uint64_t>(1, residualBytes) << "x smaller than text)" << std::endl
+              << "  column blocks    " << std::setw(9) << columnsUs << " us per frame, "
+              << std::setw(8) << columnsBytes / 1048576.0 << " MiB" << std::endl
+              << "  text log         " << std::setw(9) << textUs << " us per frame, "
+              << std::setw(8) << textBytes / 1048576.0 << " MiB" << std::endl
+              << "Read back" << std::endl
+              << "  residual, in order   " << std::setw(9) << residualReadUs << " us per frame ("
+              << (residualMatch ? "within half a quantum" : "MISMATCH") << ")" << std::endl
+              << "  residual, random     " << std::setw(9) << randomUs << " us per frame (from keyframe)" << std::endl
+              << "  columns, in order    " << std::setw(9) << columnsReadUs << " us per frame ("
+              << (columnsMatch ? "exact" : "MISMATCH") << ")" << std::endl
+              << "  seek by time         " << std::setw(9) << seekNs << " ns per lookup" << std::endl;
+    return match ? 0 : 1;
+}
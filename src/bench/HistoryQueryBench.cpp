@@ -0,0 +1,232 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <unistd.h>
+#include "utils.h"
+#include "HistoryQuery.h"
+
+/**
+ * Records hours of dense traffic at 1 s radar frames into an airspace
+ * history: aircraft cruise in a 100 km sector, 1% turn each frame, they
+ * turn back at the sector edges and now and then one lands and a new one
+ * takes its place. Then answers range queries through the block and
+ * aircraft indexes (HistoryQuery.h) and by decoding every frame in the
+ * time range, checks both give the same positions, and compares times.
+ *
+ * Usage: HistoryQueryBench [aircraft] [hours]
+ */
+
+static const char* BENCH_DIR = "/tmp/atc/logs/history_query_bench";
+static const double SECTOR = 100000.0;
+static const double CEILING = 12000.0;
+
+struct Traffic {
+    std::mt19937 rng;
+    std::vector<RadarTrack> tracks;
+    int32_t nextId;
+
+    explicit Traffic(size_t n) : rng(42), tracks(n), nextId(1) {
+        for (RadarTrack& t : tracks) {
+            spawn(t);
+        }
+    }
+
+    void spawn(RadarTrack& t) {
+        const double pi = std::acos(-1.0);
+        std::uniform_real_distribution<double> pos(0.0, SECTOR);
+        std::uniform_real_distribution<double> alt(1000.0, CEILING);
+        std::uniform_real_distribution<double> speed(60.0, 250.0);
+        std::uniform_real_distribution<double> heading(0.0, 2 * pi);
+        double s = speed(rng), h = heading(rng);
+        t = { nextId++, pos(rng), pos(rng), alt(rng), s * std::cos(h), s * std::sin(h), 0.0, 0, 0 };
+    }
+
+    void advance(int frame) {
+        std::uniform_int_distribution<size_t> pick(0, tracks.size() - 1);
+        for (size_t i = 0; i < tracks.size(); i++) {
+            RadarTrack& t = tracks[i];
+            t.x += t.vx;
+            t.y += t.vy;
+            if ((t.x < 0 && t.vx < 0) || (t.x > SECTOR && t.vx > 0)) {
+                t.vx = -t.vx;
+            }
+            if ((t.y < 0 && t.vy < 0) || (t.y > SECTOR && t.vy > 0)) {
+                t.vy = -t.vy;
+            }
+            if ((i + frame) % 100 == 0) {
+                double c = std::cos(0.1), s = std::sin(0.1);
+                double vx = t.vx * c - t.vy * s;
+                t.vy = t.vx * s + t.vy * c;
+                t.vx = vx;
+            }
+        }
+        if (frame % 4 == 0) {
+            spawn(tracks[pick(rng)]);
+        }
+    }
+};
+
+/** The same query without the indexes: decode every frame in range and filter */
+static void scan(const AirspaceHistoryReader& reader, const HistoryQuery& query,
+                 std::vector<HistoryTrackPoint>& points)
+{
+    points.clear();
+    uint64_t first = reader.seek(query.fromNs);
+    uint64_t end = (query.toNs == INT64_MAX) ? reader.tickCount() : reader.seek(query.toNs + 1);
+    HistoryFrame frame;
+    for (uint64_t i = first; i < end; i++) {
+        if (!reader.readFrame(i, frame)) {
+            continue;
+        }
+        for (size_t k = 0; k < frame.size(); k++) {
+            if (!query.ids.empty() && frame.ids[k] != query.ids[0]) {
+                continue;
+            }
+            HistoryTrackPoint p = { i, frame.ids[k], frame.x[k], frame.y[k], frame.z[k],
+                                    frame.vx[k], frame.vy[k], frame.vz[k] };
+            if (!query.boxed || (p.x >= query.min[0] && p.x <= query.max[0] && p.y >= query.min[1] &&
+                                 p.y <= query.max[1] && p.z >= query.min[2] && p.z <= query.max[2])) {
+                points.push_back(p);
+            }
+        }
+    }
+    std::sort(points.begin(), points.end(), [](const HistoryTrackPoint& a, const HistoryTrackPoint& b) {
+        return a.tick != b.tick ? a.tick < b.tick : a.id < b.id;
+    });
+}
+
+static bool samePoints(const std::vector<HistoryTrackPoint>& a, const std::vector<HistoryTrackPoint>& b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].tick != b[i].tick || a[i].id != b[i].id || a[i].x != b[i].x || a[i].y != b[i].y ||
+            a[i].z != b[i].z || a[i].vx != b[i].vx || a[i].vy != b[i].vy || a[i].vz != b[i].vz) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static HistoryQuery boxQuery(int64_t from, int64_t to, double x, double y, double side, double zMin, double zMax)
+{
+    HistoryQuery q;
+    q.fromNs = from;
+    q.toNs = to;
+    q.boxed = true;
+    q.min[0] = x;
+    q.min[1] = y;
+    q.min[2] = zMin;
+    q.max[0] = x + side;
+    q.max[1] = y + side;
+    q.max[2] = zMax;
+    return q;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t aircraft = (argc > 1) ? std::max(1L, atol(argv[1])) : 1000;
+    double hours = (argc > 2) ? atof(argv[2]) : 6.0;
+    int frames = std::max(60, (int)(hours * 3600));
+
+    ensureLogDirectories();
+    std::string dir = BENCH_DIR;
+    unlink((dir + "/" HISTORY_INDEX_FILE).c_str());
+    unlink((dir + "/" HISTORY_TRACKS_FILE).c_str());
+    unlink((dir + "/" HISTORY_BLOCKS_FILE).c_str());
+
+    const int64_t t0 = 1700000000LL * 1000000000LL;
+    const int64_t second = 1000000000LL;
+    double recordUs;
+    {
+        AirspaceHistoryWriter writer;
+        if (!writer.open(dir)) {
+            std::cerr << "Cannot open history in " << dir << std::endl;
+            return 1;
+        }
+        Traffic traffic(aircraft);
+        double spent = 0;
+        for (int f = 0; f < frames; f++) {
+            auto begin = std::chrono::steady_clock::now();
+            writer.append(t0 + f * second, (double)f, 2 * (uint64_t)(f + 1),
+                          traffic.tracks.data(), traffic.tracks.size());
+            spent += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+            traffic.advance(f);
+        }
+        recordUs = spent / frames;
+    }
+
+    AirspaceHistoryReader reader;
+    if (!reader.open(dir)) {
+        std::cerr << "Cannot read history in " << dir << std::endl;
+        return 1;
+    }
+    uint64_t indexBytes = sizeof(HistoryFileHeader) + reader.blockCount() * sizeof(HistoryBlockSummary);
+    for (uint64_t b = 0; b < reader.blockCount(); b++) {
+        if (const HistoryAircraftSpan* spans = reader.spans(reader.block(b))) {
+            indexBytes += (reinterpret_cast<const HistoryBlockHeader*>(spans) - 1)->bytes;
+        }
+    }
+
+    const int64_t last = t0 + (frames - 1) * second;
+    const int64_t hour = 3600 * second;
+    struct Case {
+        const char* name;
+        HistoryQuery query;
+    };
+    std::vector<Case> cases;
+    HistoryQuery track;
+    track.ids.push_back(42);
+    cases.push_back({ "track of plane 42, whole history", track });
+    cases.push_back({ "10 km box, all levels, 1 h", boxQuery(t0 + hour / 2, t0 + hour / 2 + hour,
+                                                             40000, 40000, 10000, 0, CEILING) });
+    cases.push_back({ "2 km box, 1 km band, whole history", boxQuery(INT64_MIN, INT64_MAX,
+                                                                     70000, 20000, 2000, 5000, 6000) });
+    HistoryQuery slice;
+    slice.fromNs = last - 60 * second;
+    slice.toNs = last;
+    cases.push_back({ "every aircraft, last minute", slice });
+
+    std::cout << "Airspace history, " << aircraft << " aircraft x " << frames << " frames ("
+              << std::fixed << std::setprecision(1) << frames / 3600.0 << " h): "
+              << reader.bytesUsed() / 1048576.0 << " MiB, of which index "
+              << indexBytes / 1048576.0 << " MiB; " << recordUs << " us per frame to record" << std::endl
+              << std::left << std::setw(38) << "Query" << std::right << std::setw(10) << "positions"
+              << std::setw(12) << "indexed ms" << std::setw(12) << "scan ms" << std::setw(10) << "speedup"
+              << "  read" << std::endl;
+
+    bool match = true;
+    std::vector<HistoryTrackPoint> indexed, scanned;
+    for (const Case& c : cases) {
+        HistoryQueryStats stats;
+        int runs = 0;
+        double indexedMs = 0;
+        auto begin = std::chrono::steady_clock::now();
+        do {
+            queryHistory(reader, c.query, indexed, &stats);
+            runs++;
+            indexedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        } while (indexedMs < 200 && runs < 1000);
+        indexedMs /= runs;
+
+        begin = std::chrono::steady_clock::now();
+        scan(reader, c.query, scanned);
+        double scanMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        bool same = samePoints(indexed, scanned);
+        match = match && same;
+        std::cout << std::left << std::setw(38) << c.name << std::right << std::setw(10) << indexed.size()
+                  << std::setprecision(3) << std::setw(12) << indexedMs << std::setprecision(1)
+                  << std::setw(12) << scanMs << std::setw(9) << scanMs / indexedMs << "x"
+                  << "  " << stats.blocks - stats.blocksSkipped << "/" << stats.blocks << " blocks, "
+                  << stats.spansRead << " tracks" << (same ? "" : "  MISMATCH") << std::endl;
+    }
+    return match ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include "commandCodes.h"
+#include "ConflictDetector.h"
+#include "IncrementalConflictDetector.h"
+
+/**
+ * Runs a cruise scenario at 1 s radar frames where a few aircraft change
+ * velocity each frame, and compares a full spatial-hash pass per frame with
+ * incremental detection. Both must report the same conflicting pairs; times
+ * to closest approach may differ by rounding since cached ones are aged.
+ * The incremental side must also evaluate fewer pairs than the full pass,
+ * rebuilds included; pairs per frame between rebuilds are shown apart.
+ *
+ * Usage: IncrementalDetectionBench [aircraft] [frames] [changesPerFrame]
+ */
+
+static const double TIME_TOLERANCE = 1e-6;
+
+static std::vector<RadarTrack> generateTraffic(size_t n, std::mt19937& rng)
+{
+    const double sectorsPerSide = std::sqrt(n / 1000.0);
+    const double side = 100000.0 * std::max(1.0, sectorsPerSide);
+    const double pi = std::acos(-1.0);
+
+    std::uniform_real_distribution<double> pos(0.0, side);
+    std::uniform_real_distribution<double> alt(0.0, 25000.0);
+    std::uniform_real_distribution<double> speed(60.0, 250.0);
+    std::uniform_real_distribution<double> heading(0.0, 2 * pi);
+    std::uniform_real_distribution<double> climb(-10.0, 10.0);
+
+    std::vector<RadarTrack> tracks(n);
+    for (size_t i = 0; i < n; i++) {
+        double s = speed(rng), h = heading(rng);
+        tracks[i] = { (int)i + 1, pos(rng), pos(rng), alt(rng),
+                      s * std::cos(h), s * std::sin(h), climb(rng), 0, (uint32_t)i + 1 };
+    }
+    return tracks;
+}
+
+static bool sameConflicts(const std::vector<Conflict>& a, const std::vector<Conflict>& b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].plane1 != b[i].plane1 || a[i].plane2 != b[i].plane2 ||
+            std::fabs(a[i].timeToClosestApproach - b[i].timeToClosestApproach) > TIME_TOLERANCE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t aircraft = (argc > 1) ? (size_t)atol(argv[1]) : 10000;
+    size_t frames = (argc > 2) ? (size_t)atol(argv[2]) : 120;
+    size_t changesPerFrame = (argc > 3) ? (size_t)atol(argv[3]) : 10;
+    if (aircraft < 2 || frames == 0) {
+        std::cerr << "Usage: " << argv[0] << " [aircraft] [frames] [changesPerFrame]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(320);
+    std::vector<RadarTrack> tracks = generateTraffic(aircraft, rng);
+    std::uniform_int_distribution<size_t> pick(0, aircraft - 1);
+    std::uniform_real_distribution<double> turn(-0.5, 0.5);
+    uint32_t nextEpoch = (uint32_t)aircraft + 1;
+
+    ConflictDetector full(3000.0, 1000.0, 120.0);
+    IncrementalConflictDetector incremental(3000.0, 1000.0, 120.0);
+    std::vector<Conflict> fullConflicts, incrementalConflicts;
+
+    double fullMs = 0, incrementalMs = 0;
+    size_t fullPairs = 0, incrementalPairs = 0, rebuilds = 0, mismatches = 0;
+    size_t betweenPairs = 0;    // Incremental pairs on frames without a rebuild
+
+    for (size_t f = 0; f < frames; f++) {
+        double frameTime = (double)f;
+        if (f > 0) {
+            for (RadarTrack& t : tracks) {
+                t.x += t.vx; t.y += t.vy; t.z += t.vz;
+            }
+            for (size_t c = 0; c < changesPerFrame; c++) {
+                RadarTrack& t = tracks[pick(rng)];
+                double a = turn(rng);
+                double nvx = t.vx * std::cos(a) - t.vy * std::sin(a);
+                double nvy = t.vx * std::sin(a) + t.vy * std::cos(a);
+                t.vx = nvx; t.vy = nvy;
+                t.velocityEpoch = nextEpoch++;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        full.detect(tracks, fullConflicts);
+        auto mid = std::chrono::steady_clock::now();
+        incremental.detect(tracks, frameTime, incrementalConflicts);
+        auto end = std::chrono::steady_clock::now();
+
+        fullMs += std::chrono::duration<double, std::milli>(mid - start).count();
+        incrementalMs += std::chrono::duration<double, std::milli>(end - mid).count();
+        fullPairs += full.getCandidateCount();
+        incrementalPairs += incremental.getPairsEvaluated();
+        if (incremental.wasRebuilt()) {
+            rebuilds++;
+        } else {
+            betweenPairs += incremental.getPairsEvaluated();
+        }
+
+        if (!sameConflicts(fullConflicts, incrementalConflicts)) {
+            std::cout << "MISMATCH at frame " << f << ": full " << fullConflicts.size()
+                      << " conflicts, incremental " << incrementalConflicts.size() << std::endl;
+            mismatches++;
+        }
+    }
+
+    std::cout << "Aircraft: " << aircraft << ", frames: " << frames
+              << ", velocity changes per frame: " << changesPerFrame
+              << ", full rebuilds: " << rebuilds << std::endl;
+    std::cout << std::fixed << std::setprecision(3)
+              << std::setw(12) << "" << std::setw(14) << "ms/frame" << std::setw(16) << "pairs/frame" << std::endl
+              << std::setw(12) << "full" << std::setw(14) << fullMs / frames
+              << std::setw(16) << fullPairs / frames << std::endl
+              << std::setw(12) << "incremental" << std::setw(14) << incrementalMs / frames
+              << std::setw(16) << incrementalPairs / frames << std::endl
+              << std::setw(12) << "  between" << std::setw(14) << ""
+              << std::setw(16) << (frames > rebuilds ? betweenPairs / (frames - rebuilds) : 0)
+              << "  (frames without a rebuild)" << std::endl
+              << "Speedup: " << std::setprecision(1) << fullMs / incrementalMs << "x, pairs: "
+              << (double)fullPairs / std::max<size_t>(incrementalPairs, 1) << "x fewer, cached pairs: "
+              << incremental.getCachedPairs() << std::endl;
+
+    if (incrementalPairs >= fullPairs) {
+        std::cout << "FAIL: incremental detection evaluated " << incrementalPairs << " pairs, the full pass "
+                  << fullPairs << std::endl;
+    }
+    return (mismatches == 0 && incrementalPairs < fullPairs) ? 0 : 1;
+}
@@ -0,0 +1,245 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "Ipc.h"
+
+/**
+ * Measures request/reply round-trip latency between two processes through
+ * the messaging backend this build uses (Ipc.h) and through a Unix domain
+ * socket pair, for the same message and reply sizes. The server echoes the
+ * first replySize bytes of every request.
+ *
+ * Usage: IpcLatencyBench [iterations] [messageBytes] [replyBytes]
+ */
+
+static const int BENCH_EXIT = -1;
+
+struct LatencyStats {
+    double meanNs;
+    double p50Ns;
+    double p99Ns;
+    double maxNs;
+};
+
+static LatencyStats summarize(std::vector<double>& samples)
+{
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : samples) {
+        sum += s;
+    }
+    size_t n = samples.size();
+    return { sum / n, samples[n / 2], samples[std::min(n - 1, n * 99 / 100)], samples[n - 1] };
+}
+
+static void printStats(const char* name, const LatencyStats& s)
+{
+    std::cout << "  " << std::left << std::setw(22) << name << std::right << std::fixed
+              << std::setprecision(0)
+              << " mean " << std::setw(8) << s.meanNs << " ns"
+              << "  p50 " << std::setw(8) << s.p50Ns << " ns"
+              << "  p99 " << std::setw(8) << s.p99Ns << " ns"
+              << "  max " << std::setw(8) << s.maxNs << " ns" << std::endl;
+}
+
+static bool readFully(int fd, void* buf, size_t size)
+{
+    char* p = static_cast<char*>(buf);
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const void* buf, size_t size)
+{
+    const char* p = static_cast<const char*>(buf);
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static void runIpcServer(int readyFd, size_t messageBytes, size_t replyBytes)
+{
+    int chid = ipcChannelCreate();
+    writeFully(readyFd, &chid, sizeof(chid));
+    close(readyFd);
+    if (chid == -1) {
+        _exit(1);
+    }
+
+    std::vector<char> buf(std::max(messageBytes, replyBytes));
+    for (;;) {
+        int rcvid = ipcReceive(chid, buf.data(), messageBytes, nullptr);
+        if (rcvid <= 0) {
+            continue;
+        }
+        int command;
+        memcpy(&command, buf.data(), sizeof(command));
+        ipcReply(rcvid, EOK, buf.data(), replyBytes);
+        if (command == BENCH_EXIT) {
+            break;
+        }
+    }
+    ipcChannelDestroy(chid);
+    _exit(0);
+}
+
+static bool benchIpc(int iterations, size_t messageBytes, size_t replyBytes,
+                     std::vector<double>& samples)
+{
+    int ready[2];
+    if (pipe(ready) == -1) {
+        return false;
+    }
+
+    pid_t server = fork();
+    if (server == 0) {
+        close(ready[0]);
+        runIpcServer(ready[1], messageBytes, replyBytes);
+    }
+    close(ready[1]);
+
+    int chid = -1;
+    bool ok = readFully(ready[0], &chid, sizeof(chid)) && chid != -1;
+    close(ready[0]);
+
+    int coid = ok ? ipcConnect(server, chid) : -1;
+    if (coid == -1) {
+        std::cerr << "Failed to connect to IPC server: " << strerror(errno) << std::endl;
+        kill(server, SIGKILL);
+        waitpid(server, nullptr, 0);
+        return false;
+    }
+
+    std::vector<char> msg(messageBytes, 'm');
+    std::vector<char> reply(replyBytes);
+    int command = 0;
+    memcpy(msg.data(), &command, sizeof(command));
+
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        if (ipcSend(coid, msg.data(), messageBytes, reply.data(), replyBytes) == -1) {
+            std::cerr << "ipcSend failed: " << strerror(errno) << std::endl;
+            ok = false;
+            break;
+        }
+        samples.push_back(std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+    command = BENCH_EXIT;
+    memcpy(msg.data(), &command, sizeof(command));
+    ipcSend(coid, msg.data(), messageBytes, reply.data(), replyBytes);
+    ipcDisconnect(coid);
+    waitpid(server, nullptr, 0);
+    return ok;
+}
+
+static bool benchUnixSocket(int iterations, size_t messageBytes, size_t replyBytes,
+                            std::vector<double>& samples)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+        return false;
+    }
+
+    pid_t server = fork();
+    if (server == 0) {
+        close(sv[0]);
+        std::vector<char> buf(std::max(messageBytes, replyBytes));
+        for (;;) {
+            if (!readFully(sv[1], buf.data(), messageBytes)) {
+                break;
+            }
+            int command;
+            memcpy(&command, buf.data(), sizeof(command));
+            if (!writeFully(sv[1], buf.data(), replyBytes) || command == BENCH_EXIT) {
+                break;
+            }
+        }
+        _exit(0);
+    }
+    close(sv[1]);
+
+    std::vector<char> msg(messageBytes, 'm');
+    std::vector<char> reply(replyBytes);
+    int command = 0;
+    memcpy(msg.data(), &command, sizeof(command));
+    bool ok = true;
+
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        if (!writeFully(sv[0], msg.data(), messageBytes) ||
+            !readFully(sv[0], reply.data(), replyBytes)) {
+            std::cerr << "Unix socket round trip failed: " << strerror(errno) << std::endl;
+            ok = false;
+            break;
+        }
+        samples.push_back(std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+    command = BENCH_EXIT;
+    memcpy(msg.data(), &command, sizeof(command));
+    if (writeFully(sv[0], msg.data(), messageBytes)) {
+        readFully(sv[0], reply.data(), replyBytes);
+    }
+    close(sv[0]);
+    waitpid(server, nullptr, 0);
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = (argc > 1) ? atoi(argv[1]) : 100000;
+    size_t messageBytes = (argc > 2) ? (size_t)atol(argv[2]) : 64;
+    size_t replyBytes = (argc > 3) ? (size_t)atol(argv[3]) : 64;
+
+    if (iterations <= 0) {
+        iterations = 1;
+    }
+    messageBytes = std::max(messageBytes, sizeof(int));
+    replyBytes = std::max(replyBytes, sizeof(int));
+
+    std::vector<double> ipcSamples, socketSamples;
+    ipcSamples.reserve(iterations);
+    socketSamples.reserve(iterations);
+
+    if (!benchIpc(iterations, messageBytes, replyBytes, ipcSamples) ||
+        !benchUnixSocket(iterations, messageBytes, replyBytes, socketSamples)) {
+        return 1;
+    }
+
+    LatencyStats ipc = summarize(ipcSamples);
+    LatencyStats uds = summarize(socketSamples);
+
+    std::cout << "Round-trip latency, " << iterations << " iterations, "
+              << messageBytes << " byte request, " << replyBytes << " byte reply" << std::endl;
+    printStats("ipcSend (Ipc.h)", ipc);
+    printStats("Unix domain socket", uds);
+    if (ipc.p50Ns > 0) {
+        std::cout << "  median speedup: " << std::setprecision(2) << uds.p50Ns / ipc.p50Ns
+                  << "x" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include "utils.h"
+#include "EventLog.h"
+
+/**
+ * Measures the caller-side cost of one log line through the asynchronous
+ * backend (AsyncLog.h) against the former synchronous path, which locked
+ * a mutex, echoed to stdout and opened, appended to and closed the log
+ * file for every message. Also measures a disabled LOG_DEBUG line built
+ * eagerly as a std::string versus through the lazy LOG_PLANE macro, and a
+ * position report formatted as text versus recorded as a binary event.
+ * Console output goes to /dev/null while timing.
+ *
+ * Usage: LogBench [threads] [messagesPerThread]
+ */
+
+static const char* BENCH_LOG = "/tmp/atc/logs/log_bench.log";
+static const char* BASELINE_LOG = "/tmp/atc/logs/log_bench_baseline.log";
+static const char* EVENT_LOG_FILE = "/tmp/atc/logs/log_bench_events.bin";
+
+static void synchronousLog(const std::string& subsystem, const std::string& message,
+                           const std::string& logPath) {
+    static std::mutex logMutex;
+    std::lock_guard<std::mutex> lock(logMutex);
+    std::string line = printTimeStamp() + " [" + subsystem + "] [INFO] " + message;
+    std::cout << line << std::endl;
+    FILE* fp = fopen(logPath.c_str(), "a");
+    if (fp) {
+        fprintf(fp, "%s\n", line.c_str());
+        fclose(fp);
+    }
+}
+
+/** Mean cost of one call, timed inside each thread after a warm-up call */
+template <typename LogFn>
+static double nsPerCall(int threads, int messages, LogFn log) {
+    std::vector<double> perThread(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([t, messages, &log, &perThread] {
+            std::string message = "Plane " + std::to_string(t) +
+                                  " position (51234.5, 48211.0, 12000.0) velocity (120.0, -35.5, 0.0)";
+            log(message);
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 1; i < messages; i++) {
+                log(message);
+            }
+            perThread[t] = std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - start).count() / std::max(1, messages - 1);
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    double sum = 0;
+    for (double ns : perThread) {
+        sum += ns;
+    }
+    return sum / threads;
+}
+
+int main(int argc, char* argv[]) {
+    int threads = (argc > 1) ? std::max(1, atoi(argv[1])) : 4;
+    int messages = (argc > 2) ? std::max(1, atoi(argv[2])) : 20000;
+
+    mkdir("/tmp/atc", 0777);
+    mkdir("/tmp/atc/logs", 0777);
+    unlink(BENCH_LOG);
+    unlink(BASELINE_LOG);
+
+    int console = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    dup2(devNull, STDOUT_FILENO);
+
+    int file = asyncLogOpen(BENCH_LOG);
+    double asyncNs = nsPerCall(threads, messages, [file](const std::string& m) {
+        asyncLogWrite(file, LOG_INFO, "Plane-1", m.data(), m.size());
+    });
+    auto flushStart = std::chrono::steady_clock::now();
+    asyncLogFlush();
+    double flushMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - flushStart).count();
+
+    double syncNs = nsPerCall(threads, messages, [](const std::string& m) {
+        synchronousLog("Plane-1", m, BASELINE_LOG);
+    });
+
+    // One position report, formatted as text versus recorded as a binary event
+    double formattedNs = nsPerCall(threads, messages, [](const std::string&) {
+        double x = 51234.5, y = 48211.0, z = 12000.0;
+        LOG_PLANE(1, LOG_INFO, "Position updated to (", x, ",", y, ",", z, ")");
+    });
+    asyncLogFlush();
+    double eventNs = -1;
+    if (eventLogCreate(EVENT_LOG_FILE, (uint64_t)threads * messages) && eventLogOpen(EVENT_LOG_FILE)) {
+        eventNs = nsPerCall(threads, messages, [](const std::string&) {
+            double x = 51234.5, y = 48211.0, z = 12000.0;
+            EVENT_LOG(EVSUB_RADAR, EVT_TRACK_POSITION, 1, x, y, z);
+        });
+    }
+
+    // Disabled DEBUG lines: built then discarded, versus never built
+    setLogLevel(LOG_INFO);
+    double eagerNs = nsPerCall(threads, messages, [](const std::string&) {
+        double x = 51234.5, y = 48211.0, z = 12000.0;
+        logPlaneMessage(1, "Position updated to (" + std::to_string(x) + "," +
+                        std::to_string(y) + "," + std::to_string(z) + ")", LOG_DEBUG);
+    });
+    double lazyNs = nsPerCall(threads, messages, [](const std::string&) {
+        double x = 51234.5, y = 48211.0, z = 12000.0;
+        LOG_PLANE(1, LOG_DEBUG, "Position updated to (", x, ",", y, ",", z, ")");
+    });
+
+    std::cout.flush();
+    dup2(console, STDOUT_FILENO);
+    close(devNull);
+
+    long written = 0;
+    if (FILE* fp = fopen(BENCH_LOG, "r")) {
+        for (int c; (c = fgetc(fp)) != EOF; ) {
+            written += (c == '\n');
+        }
+        fclose(fp);
+    }
+
+    std::cout << "Log call cost, " << threads << " threads x " << messages << " messages" << std::endl;
+    std::cout << std::fixed << std::setprecision(0)
+              << "  asynchronous queue     " << std::setw(8) << asyncNs << " ns per call"
+              << "  (final flush " << std::setprecision(1) << flushMs << " ms, "
+              << written << " of " << (long)threads * messages << " lines kept)" << std::endl
+              << std::setprecision(0)
+              << "  fopen/fclose per line  " << std::setw(8) << syncNs << " ns per call" << std::endl
+              << "Position report" << std::endl
+              << "  LOG_PLANE text line    " << std::setw(8) << formattedNs << " ns per call" << std::endl
+              << "  EVENT_LOG record       " << std::setw(8) << eventNs << " ns per call" << std::endl
+              << "Disabled LOG_DEBUG line" << std::endl << std::setprecision(1)
+              << "  string built eagerly   " << std::setw(8) << eagerNs << " ns per call" << std::endl
+              << "  LOG_PLANE macro        " << std::setw(8) << lazyNs << " ns per call" << std::endl;
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "commandCodes.h"
+#include "AirspaceHistory.h"
+#include "IncrementalConflictDetector.h"
+#include "ThreadPool.h"
+
+/**
+ * Replays a recorded airspace history through the conflict detection
+ * ComputerSystem runs on every radar frame (IncrementalConflictDetector on
+ * a ThreadPool, 3000 m / 1000 m separation, 120 s horizon), as fast as
+ * possible, and reports the throughput on that traffic. Frames are turned
+ * back into radar tracks as Radar does in replay mode, so velocity epochs
+ * change where the recorded velocities do.
+ *
+ * Record a history by running the system, or with HistoryBench, then:
+ *
+ * Usage: ReplayBench [dir] [passes]
+ */
+
+int main(int argc, char* argv[])
+{
+    std::string dir = (argc > 1) ? argv[1] : DEFAULT_AIRSPACE_HISTORY_PATH;
+    int passes = (argc > 2) ? std::max(1, atoi(argv[2])) : 1;
+
+    AirspaceHistoryReader history;
+    if (!history.open(dir) || history.tickCount() == 0) {
+        std::cerr << dir << " holds no airspace history; run the system or HistoryBench first" << std::endl;
+        return 1;
+    }
+    const uint64_t frames = history.tickCount();
+
+    // Decode up front so the timing covers detection only
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::vector<RadarTrack>> recorded(frames);
+    std::vector<double> simTimes(frames);
+    HistoryReplayTracks replayTracks;
+    HistoryFrame frame;
+    size_t tracks = 0, damaged = 0;
+    for (uint64_t i = 0; i < frames; i++) {
+        if (!history.readFrame(i, frame)) {
+            damaged++;
+            continue;
+        }
+        recorded[i].resize(frame.size());
+        replayTracks.build(frame, recorded[i].data(), frame.size());
+        simTimes[i] = frame.simTime;
+        tracks += frame.size();
+    }
+    double decodeUs = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - begin).count() / frames;
+
+    ThreadPool pool;
+    double detectMs = 0, worstMs = 0;
+    size_t pairs = 0, conflicts = 0, rebuilds = 0;
+    std::vector<Conflict> found;
+    for (int pass = 0; pass < passes; pass++) {
+        IncrementalConflictDetector detector(3000.0, 1000.0, 120);
+        detector.setThreadPool(&pool);
+        for (uint64_t i = 0; i < frames; i++) {
+            auto start = std::chrono::steady_clock::now();
+            detector.detect(recorded[i], simTimes[i], found);
+            double ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+            detectMs += ms;
+            worstMs = std::max(worstMs, ms);
+            pairs += detector.getPairsEvaluated();
+            conflicts += found.size();
+            rebuilds += detector.wasRebuilt() ? 1 : 0;
+        }
+    }
+
+    const double checks = (double)frames * passes;
+    std::cout << "Replay of " << dir << ": " << frames << " frames, "
+              << std::fixed << std::setprecision(1) << (double)tracks / frames << " tracks per frame"
+              << (damaged ? ", " + std::to_string(damaged) + " damaged frames skipped" : "") << std::endl
+              << "  decode           " << std::setw(9) << decodeUs << " us per frame" << std::endl
+              << std::setprecision(3)
+              << "  detection        " << std::setw(9) << detectMs / checks << " ms per frame, worst "
+              << worstMs << " ms" << std::endl
+              << std::setprecision(0)
+              << "  throughput       " << std::setw(9) << checks / (detectMs / 1000.0) << " frames/s ("
+              << (checks / (detectMs / 1000.0)) << "x real time at 1 s frames)" << std::endl
+              << std::setprecision(1)
+              << "  pairs evaluated  " << std::setw(9) << pairs / checks << " per frame, "
+              << conflicts / checks << " conflicts per frame, " << rebuilds << " full passes in "
+              << passes << (passes == 1 ? " pass" : " passes") << std::endl;
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include "commandCodes.h"
+#include "utils.h"
+#include "shm_utils.h"
+
+/**
+ * Measures the per-access cost of reading the radar frame header through
+ * accessSharedMemory (open/mmap/munmap/close every call) versus a
+ * SharedMemorySegment that stays mapped.
+ *
+ * Usage: ShmAccessBench [iterations] [capacity]
+ */
+
+static const char* BENCH_SHM_NAME = "/shm_bench_access";
+
+int main(int argc, char* argv[]) {
+    int iterations = (argc > 1) ? atoi(argv[1]) : 100000;
+    uint32_t capacity = (argc > 2) ? (uint32_t)atoi(argv[2]) : DEFAULT_RADAR_CAPACITY;
+    size_t frameSize = radarFrameSize(capacity);
+
+    setLogLevel(LOG_WARNING);
+
+    bool created = accessSharedMemory<RadarFrameHeader>(
+        BENCH_SHM_NAME,
+        frameSize,
+        O_CREAT | O_RDWR,
+        true,
+        [capacity](RadarFrameHeader* rh) {
+            rh->capacity = capacity;
+            rh->numPlanes = capacity / 2;
+            rh->sequence = 0;
+            rh->timestamp = 0;
+        }
+    );
+
+    if (!created) {
+        std::cerr << "Failed to create benchmark shared memory" << std::endl;
+        return 1;
+    }
+
+    volatile uint64_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        accessSharedMemory<RadarFrameHeader>(
+            BENCH_SHM_NAME,
+            frameSize,
+            O_RDONLY,
+            false,
+            [&sink](RadarFrameHeader* rh) {
+                sink = sink + rh->numPlanes;
+            }
+        );
+    }
+    auto perCall = std::chrono::steady_clock::now() - start;
+
+    SharedMemorySegment segment;
+    if (!segment.open(BENCH_SHM_NAME, frameSize, O_RDONLY, false)) {
+        std::cerr << "Failed to open persistent segment" << std::endl;
+        shm_unlink(BENCH_SHM_NAME);
+        return 1;
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        const RadarFrameHeader* rh = segment.as<RadarFrameHeader>();
+        sink = sink + rh->numPlanes;
+    }
+    auto persistent = std::chrono::steady_clock::now() - start;
+
+    segment.close();
+    shm_unlink(BENCH_SHM_NAME);
+
+    double perCallNs = std::chrono::duration<double, std::nano>(perCall).count() / iterations;
+    double persistentNs = std::chrono::duration<double, std::nano>(persistent).count() / iterations;
+
+    std::cout << "Shared memory access, " << iterations << " iterations, "
+              << frameSize << " byte frame" << std::endl;
+    std::cout << "  accessSharedMemory (map per call): " << perCallNs << " ns/access" << std::endl;
+    std::cout << "  SharedMemorySegment (persistent):  " << persistentNs << " ns/access" << std::endl;
+    if (persistentNs > 0) {
+        std::cout << "  speedup: " << perCallNs / persistentNs << "x" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,403 @@
+#ifndef AIRSPACE_HISTORY_H
+#define AIRSPACE_HISTORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "commandCodes.h"
+
+/**
+ * Append-only airspace history, one record per radar frame. A history is
+ * a directory holding two memory-mapped files:
+ *
+ * - ticks.idx: a time index with one fixed-size HistoryTick per frame,
+ *   in time order, so a reader finds a time by binary search.
+ * - tracks.col: blocks of frames, about HISTORY_BLOCK_ROWS tracks each.
+ *   A block holds whole frames and is encoded one of two ways (below).
+ *
+ * Residual blocks (the default) store each track as its difference from
+ * dead reckoning. Positions and velocities are quantized to
+ * HISTORY_POSITION_QUANTUM and HISTORY_VELOCITY_QUANTUM. A track seen in
+ * the previous frame is predicted at its previous position plus velocity
+ * times the simulation time step, and only the zig-zag varint residuals
+ * that are not zero are written, behind one control byte per track. Runs
+ * of tracks with no residual at all shrink to a single byte. The first
+ * frame of each block is a keyframe with absolute values, so a reader
+ * decodes at most one block to reach any frame. Aircraft in straight
+ * flight cost one byte or less per frame instead of 52.
+ *
+ * Column blocks store the frames uncompressed, one contiguous column per
+ * field (id, x, y, z, vx, vy, vz), and read back exactly.
+ *
+ * When the writer moves on from a block it indexes it for queries
+ * (HistoryQuery.h). An aircraft block follows it in tracks.col, with one
+ * span per aircraft and stretch of consecutive frames it appears in:
+ * the aircraft's bounding box over the span and its track alone, residual
+ * coded like a frame. A third file, blocks.idx, has one summary per block
+ * with its time range and the bounding box of every track in it. A block
+ * is indexed after its last frame, so the frames of the block being
+ * written, or of a writer that did not close, have no summary yet.
+ *
+ * Both files grow in chunks and are written through the mapping, so
+ * appending a frame costs an encode, a copy and two release stores, with
+ * no write() call. The writer publishes a frame by storing the tick count
+ * last; readers in other processes only look at published ticks and may
+ * follow a history while it is being written.
+ *
+ * Timestamps are CLOCK_REALTIME nanoseconds so that a history survives
+ * restarts; the simulation time of each frame is kept alongside.
+ */
+
+#define HISTORY_INDEX_FILE "ticks.idx"
+#define HISTORY_TRACKS_FILE "tracks.col"
+#define HISTORY_BLOCKS_FILE "blocks.idx"
+
+const uint64_t HISTORY_INDEX_MAGIC = 0x3158444948435441ULL;    // "ATCHIDX1"
+const uint64_t HISTORY_TRACKS_MAGIC = 0x314C4F4348435441ULL;   // "ATCHCOL1"
+const uint64_t HISTORY_BLOCKS_MAGIC = 0x314B4C4248435441ULL;   // "ATCHBLK1"
+const uint32_t HISTORY_VERSION = 1;
+
+/** Tracks per block, and so between keyframes; a larger frame gets a block of its own */
+const uint32_t HISTORY_BLOCK_ROWS = 65536;
+
+/** Most frames in a residual block, which bounds the decoding behind a random read */
+const uint32_t HISTORY_BLOCK_TICKS = 256;
+
+/** Resolution of recorded positions and velocities; decoded values are within half of it */
+const double HISTORY_POSITION_QUANTUM = 0.01;
+const double HISTORY_VELOCITY_QUANTUM = 0.01;
+
+enum HistoryBlockEncoding : uint32_t {
+    HISTORY_BLOCK_COLUMNS = 0,
+    HISTORY_BLOCK_RESIDUAL = 1,
+    HISTORY_BLOCK_AIRCRAFT = 2      // Spans of the frame block before it
+};
+
+/** Start of both files; their records follow at offset sizeof(HistoryFileHeader) */
+struct alignas(64) HistoryFileHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t reserved;
+    std::atomic<uint64_t> used;     // ticks.idx: ticks published; tracks.col: bytes in blocks;
+                                    // blocks.idx: summaries published
+};
+
+/** One radar frame in ticks.idx */
+struct HistoryTick {
+    int64_t timeNs;             // CLOCK_REALTIME when Radar published the frame
+    double simTime;             // Radar's simulation time, in seconds
+    uint64_t sequence;          // Radar frame sequence
+    uint64_t blockOffset;       // Block in tracks.col holding the frame
+    uint32_t row;               // Columns: first row; residual: byte offset in the block
+    uint32_t count;             // Tracks in the frame
+};
+
+/**
+ * Block header in tracks.col. Column blocks are followed by `capacity`
+ * rows of each column: int32 ids, then doubles x, y, z, vx, vy, vz.
+ * Residual blocks are followed by their encoded frames.
+ */
+struct HistoryBlockHeader {
+    uint32_t capacity;          // Columns: rows allocated; residual: unused
+    uint32_t rows;
+    uint64_t firstTick;
+    uint32_t ticks;
+    uint32_t encoding;          // HistoryBlockEncoding
+    uint64_t bytes;             // Header and data
+};
+
+/**
+ * One aircraft over consecutive frames of a block, in the aircraft block
+ * that follows it. Spans are sorted by id, then by first frame; their
+ * encoded tracks follow them in the same order, each from `offset` up to
+ * the next span's.
+ */
+struct HistoryAircraftSpan {
+    int32_t id;
+    uint32_t firstTick;         // Relative to the block's first tick
+    uint32_t ticks;
+    uint32_t offset;            // Of the encoded track, from the aircraft block
+    float min[3], max[3];       // Bounding box of the decoded positions, rounded outwards
+};
+
+/** Entry in blocks.idx for a frame block that has been indexed */
+struct HistoryBlockSummary {
+    uint64_t blockOffset;       // Frame block in tracks.col
+    uint64_t aircraftOffset;    // Its aircraft block in tracks.col
+    uint64_t firstTick;
+    uint32_t ticks;
+    uint32_t spans;
+    int64_t firstTimeNs;
+    int64_t lastTimeNs;
+    double min[3], max[3];      // Bounding box of every track in the block
+};
+
+/** One aircraft in one frame, as span reads and queries return it */
+struct HistoryTrackPoint {
+    uint64_t tick;
+    int32_t id;
+    double x, y, z;
+    double vx, vy, vz;
+};
+
+/** One decoded frame, kept as columns like KinematicsEngine */
+struct HistoryFrame {
+    int64_t timeNs;
+    double simTime;
+    uint64_t sequence;
+    std::vector<int32_t> ids;
+    std::vector<double> x, y, z;
+    std::vector<double> vx, vy, vz;
+
+    size_t size() const { return ids.size(); }
+};
+
+/**
+ * Quantized tracks of the last frame coded in a residual block, which
+ * predict the next one. Shared by the writer and the reader.
+ */
+struct HistoryResidualState {
+    std::vector<int32_t> ids;
+    std::vector<int64_t> x, y, z;
+    std::vector<int64_t> vx, vy, vz;
+    double simTime;
+    std::unordered_map<int32_t, uint32_t> indexById;    // Built on demand
+    bool indexed;
+
+    HistoryResidualState() : simTime(0), indexed(false) {}
+
+    void clear();
+    void resize(size_t n);
+    size_t size() const { return ids.size(); }
+
+    /** Row of `id` in this frame, trying `hint` first; -1 if absent */
+    long find(int32_t id, size_t hint);
+};
+
+/**
+ * A file mapped whole, grown in chunks by its writer and remapped by
+ * readers when it has grown elsewhere.
+ */
+class MappedFile {
+private:
+    std::string path;
+    int fd;
+    char* base;
+    size_t mappedSize;
+    bool writable;
+
+    bool mapCurrent(size_t size);
+
+public:
+    MappedFile() : fd(-1), base(nullptr), mappedSize(0), writable(false) {}
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Open and map a file. A writable file is created if missing and
+     * sized to at least initialSize.
+     * @return true if successful, false otherwise
+     */
+    bool open(const std::string& filePath, bool forWriting, size_t initialSize = 0);
+
+    /** Grow the file so that `needed` bytes are mapped; writers only */
+    bool reserve(size_t needed);
+
+    /** Map the file again if another process has grown it */
+    bool refresh();
+
+    /** Schedule dirty pages for writeback */
+    void sync();
+
+    void close();
+
+    bool isOpen() const { return base != nullptr; }
+    size_t size() const { return mappedSize; }
+    char* data() const { return base; }
+};
+
+/**
+ * Writer side of a history. Only one writer may have a history open; it
+ * appends to whatever the directory already holds. Not thread-safe.
+ */
+class AirspaceHistoryWriter {
+private:
+    MappedFile index;
+    MappedFile tracks;
+    HistoryBlockEncoding encoding;
+    uint64_t blockOffset;       // Current block; 0 before the first append
+    int64_t lastTimeNs;
+    HistoryResidualState previous, current;
+    std::vector<uint8_t> encoded;
+
+    // Spans of the current block, written after it as its aircraft block
+    // when the writer moves on. Slots are reused from block to block.
+    struct AircraftTrack {
+        int32_t id;
+        uint64_t firstTick, lastTick;
+        int64_t q[6];           // Quantized state at lastTick
+        double simTime;
+        uint32_t run;           // Frames matching their prediction, not yet written
+        double min[3], max[3];
+        std::vector<uint8_t> data;
+    };
+    MappedFile blocks;
+    std::vector<AircraftTrack> spanTracks;
+    size_t openSpans;
+    std::unordered_map<int32_t, uint32_t> spanById;     // Latest span of each aircraft
+    std::vector<int32_t> rowIds, nextRowIds;            // Previous frame's rows and their spans,
+    std::vector<uint32_t> rowSpans, nextRowSpans;       // to skip spanById while rows keep their order
+    std::vector<uint32_t> spanOrder;
+    uint64_t blockFirstTick;
+    int64_t blockFirstTimeNs;
+
+    HistoryFileHeader* blocksHeader() const { return reinterpret_cast<HistoryFileHeader*>(blocks.data()); }
+
+    HistoryFileHeader* indexHeader() const { return reinterpret_cast<HistoryFileHeader*>(index.data()); }
+    HistoryFileHeader* tracksHeader() const { return reinterpret_cast<HistoryFileHeader*>(tracks.data()); }
+    bool startBlock(uint32_t capacity, uint64_t firstTick);
+    bool appendColumns(uint64_t tick, const RadarTrack* frame, size_t count, uint32_t& row);
+    bool appendResidual(uint64_t tick, double simTime, const RadarTrack* frame, size_t count,
+                        uint32_t& row);
+    void trackAircraft(uint64_t tick, double simTime, const RadarTrack* frame, size_t count);
+    bool indexBlock();
+
+public:
+    AirspaceHistoryWriter()
+        : encoding(HISTORY_BLOCK_RESIDUAL), blockOffset(0), lastTimeNs(0), openSpans(0),
+          blockFirstTick(0), blockFirstTimeNs(0) {}
+    ~AirspaceHistoryWriter() { close(); }
+
+    AirspaceHistoryWriter(const AirspaceHistoryWriter&) = delete;
+    AirspaceHistoryWriter& operator=(const AirspaceHistoryWriter&) = delete;
+
+    /**
+     * Open the history in `dir`, creating it if needed. New blocks use
+     * `blockEncoding`; blocks already in the history keep theirs.
+     * @return true if successful, false otherwise
+     */
+    bool open(const std::string& dir, HistoryBlockEncoding blockEncoding = HISTORY_BLOCK_RESIDUAL);
+    /** Index the current block and close the history */
+    void close();
+    bool isOpen() const { return index.isOpen() && tracks.isOpen(); }
+
+    /**
+     * Append one radar frame. Frames must arrive in time order; a frame
+     * older than the last one is rejected.
+     * @return true if the frame was recorded
+     */
+    bool append(int64_t timeNs, double simTime, uint64_t sequence,
+                const RadarTrack* frame, size_t count);
+
+    /** Schedule everything appended so far for writeback */
+    void sync();
+
+    uint64_t tickCount() const;
+    uint64_t bytesUsed() const;
+};
+
+/**
+ * Reader side of a history. Readers may open a history that is still
+ * being written and call refresh() to see newer frames. Not thread-safe.
+ */
+class AirspaceHistoryReader {
+private:
+    MappedFile index;
+    MappedFile tracks;
+    MappedFile blocks;          // Absent in histories recorded before blocks were indexed
+    uint64_t ticks;
+    uint64_t summaries;
+
+    // Last frame decoded from a residual block, so sequential reads
+    // decode each frame once
+    mutable HistoryResidualState decoded, scratch;
+    mutable uint64_t decodedBlock;
+    mutable uint64_t decodedTick;
+
+    const HistoryTick* tickEntries() const;
+    bool readColumns(const HistoryTick& t, const char* block, HistoryFrame& frame) const;
+    bool readResidual(uint64_t i, const HistoryTick& t, const char* block, HistoryFrame& frame) const;
+
+public:
+    AirspaceHistoryReader() : ticks(0), summaries(0), decodedBlock(0), decodedTick(0) {}
+
+    /** @return true if `dir` holds a readable history */
+    bool open(const std::string& dir);
+    void close();
+
+    /** Pick up frames appended since open() or the last refresh() */
+    bool refresh();
+
+    uint64_t tickCount() const { return ticks; }
+    const HistoryTick& tick(uint64_t i) const { return tickEntries()[i]; }
+
+    /** Index of the first frame at or after timeNs (tickCount() if none), O(log n) */
+    uint64_t seek(int64_t timeNs) const;
+
+    /**
+     * Decode frame i into `frame`, reusing its storage. Reading frames in
+     * order decodes each once; jumping decodes from the block's keyframe.
+     * @return false if i is out of range or the frame is damaged
+     */
+    bool readFrame(uint64_t i, HistoryFrame& frame) const;
+
+    /** Indexed blocks, in time order; see HistoryQuery.h for queries over them */
+    uint64_t blockCount() const { return summaries; }
+    const HistoryBlockSummary& block(uint64_t b) const;
+
+    /** Spans of an indexed block, sorted by id; nullptr if damaged */
+    const HistoryAircraftSpan* spans(const HistoryBlockSummary& summary) const;
+
+    /**
+     * Decode a span's track and append its frames from fromTick (absolute)
+     * up to, but not including, toTick to `points`. Values match
+     * readFrame() on residual blocks.
+     * @return false if the span is damaged
+     */
+    bool readSpan(const HistoryBlockSummary& summary, const HistoryAircraftSpan& span,
+                  uint64_t fromTick, uint64_t toTick, std::vector<HistoryTrackPoint>& points) const;
+
+    uint64_t bytesUsed() const;
+};
+
+/**
+ * Turns decoded frames back into radar tracks for replay. Velocity epochs
+ * are assigned as KinematicsEngine assigns them: an aircraft gets a new
+ * epoch when it appears and whenever its recorded velocity changes, so
+ * IncrementalConflictDetector sees the changes it saw live.
+ */
+class HistoryReplayTracks {
+private:
+    struct Recorded {
+        double vx, vy, vz;
+        uint32_t epoch;
+        uint64_t lastFrame;
+    };
+    std::unordered_map<int32_t, Recorded> recorded;
+    uint32_t nextEpoch;
+    uint64_t frames;
+
+public:
+    HistoryReplayTracks() : nextEpoch(1), frames(0) {}
+
+    /** Fill `out` with the first `count` tracks of `frame` */
+    void build(const HistoryFrame& frame, RadarTrack* out, size_t count);
+};
+
+/**
+ * Parse a history time: local "YYYY-mm-dd HH:MM:SS[.fff]" or seconds
+ * since the epoch, into CLOCK_REALTIME nanoseconds.
+ * @return true if successful, false otherwise
+ */
+bool parseHistoryTime(const char* text, int64_t& ns);
+
+/** Format CLOCK_REALTIME nanoseconds as local "YYYY-mm-dd HH:MM:SS.mmm" */
+void formatHistoryTime(char* buf, size_t size, int64_t ns);
+
+#endif // AIRSPACE_HISTORY_H
@@ -1,28 +1,46 @@
 #ifndef AIRSPACE_LOGGER_H
 #define AIRSPACE_LOGGER_H
 
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "commandCodes.h"
+#include "AirspaceHistory.h"
+
+// How often the recorder checks for a new radar frame
+const int HISTORY_POLL_MS = 50;
 
 /**
- * AirspaceLogger receives COMMAND_LOG_AIRSPACE messages from ComputerSystem,
- * writes them to a file for record.
+ * AirspaceLogger records every radar frame published in /shm_radar_data
+ * into the airspace history (AirspaceHistory.h). A recorder thread polls
+ * the frame sequence every HISTORY_POLL_MS and appends each new frame.
+ *
+ * The COMMAND_LOG_AIRSPACE messages ComputerSystem still sends every 20 s
+ * serve as checkpoints: the logger schedules the history for writeback
+ * and logs how much it holds.
+ *
+ * Frames Radar replays from a history (RADAR_FRAME_REPLAYED) are not
+ * recorded again.
  */
 class AirspaceLogger {
     private:
-        std::string logPath;
+        std::string historyPath;
         pid_t pid;
         int chid;
+        AirspaceHistoryWriter history;
+        std::mutex historyMutex;
+        std::atomic<bool> recording;
+        uint64_t framesMissed;
+        uint64_t framesReplayed;
         
-        void logAirspaceState(const std::vector<Position>& positions,
-                              const std::vector<Velocity>& velocities,
-                              double timestamp);
+        void recordFrames();
+        void checkpoint(double timestamp);
                               
         void registerChannelId();
     
     public:
-        AirspaceLogger(const std::string& logPath = DEFAULT_AIRSPACE_LOG_PATH);
+        AirspaceLogger(const std::string& historyPath = DEFAULT_AIRSPACE_HISTORY_PATH);
         void run();
         
         int getChid() const { return chid; }
@@ -0,0 +1,145 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+/** Log levels for finer-grained control **/
+enum LogLevel {
+    LOG_DEBUG,    // Detailed debugging information
+    LOG_INFO,     // General informational messages
+    LOG_WARNING,  // Warning conditions
+    LOG_ERROR     // Error conditions
+};
+
+/**
+ * Asynchronous logging backend behind logMessage(). Each thread formats
+ * its records straight into its own single-producer ring; one writer
+ * thread per process drains every ring, keeps each log file open and
+ * hands all pending lines for a file to a single writev(). A log call
+ * costs a timestamp lookup and a memcpy, with no lock and no syscall.
+ *
+ * Lines from one thread stay in order. Lines from different threads to
+ * the same file are ordered per batch, not by timestamp. The writer
+ * wakes every ASYNC_LOG_FLUSH_MS, or at once for warnings and errors
+ * and for rings past half full; remaining lines are flushed at exit().
+ * A thread that finds its ring full waits up to ASYNC_LOG_FULL_WAIT_US
+ * for the writer, then drops the record; the writer reports how many
+ * were dropped.
+ *
+ * After fork() the child has no writer thread, so it writes each record
+ * synchronously until it execs.
+ */
+
+const int ASYNC_LOG_FLUSH_MS = 20;
+
+/** Longest message logFormat() assembles; longer ones are truncated */
+const size_t ASYNC_LOG_LINE_BYTES = 1024;
+
+/** Bytes of pending log text each thread can buffer */
+const size_t ASYNC_LOG_QUEUE_BYTES = 256 * 1024;
+
+const int ASYNC_LOG_FULL_WAIT_US = 5000;
+
+/**
+ * Register a log file, created on first write. Call once per file and
+ * keep the id; registering the same path again returns the same id.
+ * @return file id, or -1 if too many files are registered
+ */
+int asyncLogOpen(const char* path);
+
+/**
+ * Queue one line: "[timestamp] [subsystem] [LEVEL] message". The line
+ * also goes to stdout, or stderr for warnings and errors.
+ */
+void asyncLogWrite(int file, LogLevel level, const char* subsystem,
+                   const char* message, size_t length);
+
+/** Block until every line queued before the call has been written */
+void asyncLogFlush();
+
+/**
+ * Compile-time floor for the logging macros in utils.h. Calls below it
+ * are removed by the compiler; release builds set it to LOG_INFO.
+ */
+#ifndef ATC_LOG_MIN_LEVEL
+#define ATC_LOG_MIN_LEVEL LOG_DEBUG
+#endif
+
+/** Runtime level shared by the whole process; LOG_INFO until changed */
+extern std::atomic<int> asyncLogThreshold;
+
+/** Set the runtime level for every thread and translation unit */
+void setLogLevel(LogLevel level);
+
+/** True if a message at level would be written */
+#define LOG_LEVEL_ENABLED(level) \
+    ((level) >= ATC_LOG_MIN_LEVEL && \
+     (level) >= asyncLogThreshold.load(std::memory_order_relaxed))
+
+/**
+ * Fixed buffer a message is assembled in, one argument at a time, with
+ * no heap allocation. Numbers are printed the way std::to_string prints
+ * them, so messages read the same as the string concatenations they
+ * replace.
+ */
+class LogLine {
+public:
+    LogLine() : length(0) {}
+
+    const char* data() const { return text; }
+    size_t size() const { return length; }
+
+    void add(const char* s) { append(s, strlen(s)); }
+    void add(const std::string& s) { append(s.data(), s.size()); }
+    void add(char c) { append(&c, 1); }
+    void add(int v) { print("%d", v); }
+    void add(long v) { print("%ld", v); }
+    void add(long long v) { print("%lld", v); }
+    void add(unsigned v) { print("%u", v); }
+    void add(unsigned long v) { print("%lu", v); }
+    void add(unsigned long long v) { print("%llu", v); }
+    void add(double v) { print("%f", v); }
+
+private:
+    char text[ASYNC_LOG_LINE_BYTES];
+    size_t length;
+
+    void append(const char* s, size_t n) {
+        if (n > sizeof(text) - length) {
+            n = sizeof(text) - length;
+        }
+        memcpy(text + length, s, n);
+        length += n;
+    }
+
+    template <typename T>
+    void print(const char* format, T v) {
+        char buf[64];
+        int n = snprintf(buf, sizeof(buf), format, v);
+        if (n > 0) {
+            append(buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+        }
+    }
+};
+
+inline void logAppend(LogLine&) {}
+
+template <typename T, typename... Rest>
+inline void logAppend(LogLine& line, const T& first, const Rest&... rest) {
+    line.add(first);
+    logAppend(line, rest...);
+}
+
+/** Concatenate args into one line and queue it; check the level first */
+template <typename... Args>
+void logFormat(const char* subsystem, int file, LogLevel level, const Args&... args) {
+    LogLine line;
+    logAppend(line, args...);
+    asyncLogWrite(file, level, subsystem, line.data(), line.size());
+}
+
+#endif // ASYNC_LOG_H
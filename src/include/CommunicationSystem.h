@@ -2,21 +2,30 @@
 #define COMMUNICATION_SYSTEM_H
 
 #include <string>
+#include <atomic>
 #include "commandCodes.h"
+#include "shm_utils.h"
 
 /**
- * CommunicationSystem reads commands from /shm_commands,
- * simulates sending them to planes (i.e. prints to stdout/log).
+ * CommunicationSystem reads commands from /shm_commands and transmits them
+ * to the aircraft by forwarding them over /shm_uplink to Radar, which
+ * applies them to the simulated aircraft. It sleeps on the command ring's
+ * doorbell until a command arrives.
  */
 class CommunicationSystem {
 private:
     std::string transmissionLogPath;
+    std::atomic<bool> running;
+    SharedMemorySegment uplinkSegment;
     void logTransmission(const std::string& message);
 
 public:
     CommunicationSystem(const std::string& logPath = DEFAULT_TRANSMISSION_LOG_PATH);
-    void send(int planeId, const Command& command);
+    void send(int planeId, Command command);
     void run();
+
+    /** Make run() return within its next doorbell timeout */
+    void stop() { running = false; }
 };
 
 #endif // COMMUNICATION_SYSTEM_H
\ No newline at end of file
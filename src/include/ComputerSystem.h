@@ -2,9 +2,15 @@
 #define COMPUTER_SYSTEM_H
 
 #include <vector>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include "commandCodes.h"
+#include "shm_utils.h"
+#include "IncrementalConflictDetector.h"
+#include "ThreadPool.h"
+#include "ConnectionCache.h"
+#include "DisplaySubscriptions.h"
 
 /**
  * ComputerSystem reads plane data from /shm_radar_data,
@@ -26,6 +32,7 @@ private:
     const double MIN_VERTICAL_SEPARATION;
     const double MIN_HORIZONTAL_SEPARATION;
     int congestionDegreeSeconds;
+    int displayIntervalMs;              // Between grids sent to DataDisplay
 
     std::atomic<bool> violationCheckInProgress;
     std::atomic<bool> logInProgress;
@@ -33,6 +40,27 @@ private:
     std::condition_variable eventCV;
     bool emergencyEvent;
 
+    ConnectionCache connections;
+    RadarFrameReader radarReader;
+    SharedMemorySegment commandSegment;
+    SharedMemorySegment ackSegment;
+    uint64_t nextCommandSequence;
+    uint64_t commandsAcked;
+
+    // Per-stage command latencies in ms since the last report
+    std::vector<double> uplinkLatencies;     // issued -> transmitted
+    std::vector<double> applyLatencies;      // transmitted -> applied
+    std::vector<double> totalLatencies;      // issued -> applied
+    uint64_t lastViolationSequence;
+    ThreadPool detectionPool;
+    IncrementalConflictDetector conflictDetector;
+    std::vector<Conflict> conflicts;
+    std::vector<int> conflictIds;           // Aircraft in `conflicts`, sorted, for the display
+    std::vector<ConflictAlert> alertBatch;
+
+    DisplaySubscriptions displays;          // Subscribed displays, sent only their viewport
+    std::vector<AircraftDisplayEntry> displayEntries;
+
     std::vector<Position> positionsSnapshot;
     std::vector<Velocity> velocitiesSnapshot;
 
@@ -40,29 +68,28 @@ private:
 
     void listen();
 
-    void handlePulse(int code, double &currentTime);
+    void handlePulse(int code);
 
     bool initializeChannelIds();
 
     void registerChannelId();
 
     void logSystem(bool toFile);
+    void sendToSubscribers(int commandType, const std::vector<AircraftDisplayEntry>& entries);
+    void handleSubscription(int rcvid, const DisplaySubscribeMessage& request);
     void opConCheck();
     void sendDisplayCommand(int planeNumber);
-    void sendVelocityUpdateToComm(int planeNumber, Vec3 newVelocity);
-    void sendLogToAirspaceLogger(double currentTime);
+    void sendVelocityUpdateToComm(int planeNumber, Vec3 newVelocity, int64_t issuedNs);
+    void collectCommandAcks();
+    void reportCommandLatency();
+    void sendLogToAirspaceLogger();
 
     bool checkSeparation(const Position &pos1, const Position &pos2) const;
     bool predictSeparation(const Position &pos1, const Velocity &vel1,
                            const Position &pos2, const Velocity &vel2) const;
 
-    void violationCheck();
-    void checkForFutureViolation(const Position &pos1, const Velocity &vel1,
-                                 const Position &pos2, const Velocity &vel2,
-                                 int plane1, int plane2);
-
-    double calculateTimeToMinimumDistance(const Position &pos1, const Velocity &vel1,
-                                          const Position &pos2, const Velocity &vel2);
+    void violationCheck(bool force = false);
+    void reportViolations(const std::vector<Conflict> &found, double frameTimestamp);
     void processEmergencyEvents();
     void triggerEmergencyEvent();
 
@@ -75,6 +102,8 @@ public:
     void setOperatorChid(int id) { operatorChid = id; }
     void setDisplayChid(int id) { displayChid = id; }
     void setLoggerChid(int id) { loggerChid = id; }
+    /** How often DataDisplay is sent a grid; call before run() */
+    void setDisplayInterval(int ms) { displayIntervalMs = ms; }
 
     void update(double currentTime);
 
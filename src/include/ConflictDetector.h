@@ -0,0 +1,143 @@
+#ifndef CONFLICT_DETECTOR_H
+#define CONFLICT_DETECTOR_H
+
+#include <vector>
+#include <cstdint>
+#include "commandCodes.h"
+#include "CpaKernel.h"
+#include "ThreadPool.h"
+
+/** A predicted loss of separation between two aircraft */
+struct Conflict {
+    int plane1;
+    int plane2;
+    double timeToClosestApproach;
+};
+
+/** Closest approach of a candidate pair, by index into the input tracks */
+struct PairApproach {
+    uint32_t first;
+    uint32_t second;
+    double timeToClosestApproach;
+    double horizontalSeparation;
+    double verticalSeparation;
+};
+
+/**
+ * ConflictDetector finds every aircraft pair whose closest point of approach
+ * within the look-ahead horizon violates both the horizontal and vertical
+ * separation minima.
+ *
+ * detect() bins each aircraft's swept volume over the horizon into a hashed
+ * uniform grid and only runs the exact closest-point-of-approach test on
+ * pairs sharing a cell. The swept boxes are padded by half the separation
+ * minima, so any pair the exact test would flag is guaranteed to share a
+ * cell and the result is identical to detectBruteForce().
+ *
+ * Both paths evaluate candidates through the batched CPA kernel, one
+ * aircraft against a structure-of-arrays block of partners at a time.
+ *
+ * With a thread pool attached, candidate collection and the narrow phase are
+ * split into tasks over cells and candidate runs. Every task writes into its
+ * worker's buffer and the buffers are merged in task order, so the reported
+ * conflicts are the same, in the same order, as a single-threaded pass.
+ */
+class ConflictDetector {
+private:
+    double minHorizontalSeparation;
+    double minVerticalSeparation;
+    double horizonSeconds;
+
+    // Snapshot in structure-of-arrays form
+    std::vector<int> ids;
+    std::vector<double> x, y, z;
+    std::vector<double> vx, vy, vz;
+
+    // Swept, padded bounding boxes
+    std::vector<double> minX, maxX, minY, maxY, minZ, maxZ;
+
+    // (cell key, aircraft index) pairs, sorted by cell
+    std::vector<std::pair<uint64_t, uint32_t>> cellEntries;
+    std::vector<std::pair<uint32_t, uint32_t>> candidates;
+
+    double cellSize;
+
+    /** Per-worker gather block, kernel results and output buffers */
+    struct WorkerScratch {
+        std::vector<uint32_t> gatherIndex;
+        std::vector<double> gatherX, gatherY, gatherZ;
+        std::vector<double> gatherVx, gatherVy, gatherVz;
+        std::vector<double> resultTime, resultHorizontal, resultVertical;
+        std::vector<std::pair<uint32_t, uint32_t>> candidates;
+        std::vector<Conflict> conflicts;
+        std::vector<PairApproach> approaches;
+    };
+
+    /** Where a task's output landed in its worker's buffer */
+    struct TaskSpan {
+        uint32_t worker;
+        size_t begin;
+        size_t end;
+    };
+
+    ThreadPool* pool;
+    std::vector<WorkerScratch> scratch;
+    std::vector<size_t> taskBounds;
+    std::vector<TaskSpan> taskSpans;
+
+    void loadSnapshot(const std::vector<RadarTrack>& tracks);
+    void buildSweptBoxes();
+    void buildCells();
+    void collectCandidates();
+    bool boxesOverlap(uint32_t a, uint32_t b) const;
+    void runBroadPhase(const std::vector<RadarTrack>& tracks);
+    void narrowPhase(bool keepAllPairs);
+
+    void prepareWorkers();
+    void runTasks(size_t taskCount, const ThreadPool::Task& fn);
+    void splitRuns(size_t count, size_t targetSize,
+                   const std::function<bool(size_t)>& isRunStart);
+
+    CpaReference reference(uint32_t i) const;
+    void ensureScratch(WorkerScratch& s, size_t count);
+    void collectConflicts(WorkerScratch& s, uint32_t i, const uint32_t* others,
+                          size_t count) const;
+    void collectApproaches(WorkerScratch& s, uint32_t i, const uint32_t* others,
+                           size_t count) const;
+
+    /** Concatenate each task's output in task order */
+    template<typename T>
+    void mergeTaskOutput(std::vector<T> WorkerScratch::*buffer, std::vector<T>& out) const
+    {
+        out.clear();
+        for (const TaskSpan& span : taskSpans) {
+            const std::vector<T>& src = scratch[span.worker].*buffer;
+            out.insert(out.end(), src.begin() + span.begin, src.begin() + span.end);
+        }
+    }
+
+public:
+    ConflictDetector(double minHorizontalSeparation, double minVerticalSeparation,
+                     double horizonSeconds);
+
+    /** Run detection on the given pool; nullptr runs on the calling thread */
+    void setThreadPool(ThreadPool* threadPool) { pool = threadPool; }
+
+    void setHorizon(double seconds) { horizonSeconds = seconds; }
+    double getHorizon() const { return horizonSeconds; }
+
+    void detect(const std::vector<RadarTrack>& tracks, std::vector<Conflict>& conflicts);
+    void detectBruteForce(const std::vector<RadarTrack>& tracks, std::vector<Conflict>& conflicts);
+
+    /**
+     * Run the same broad phase as detect() but report the closest approach
+     * of every candidate pair, conflicting or not
+     */
+    void findApproaches(const std::vector<RadarTrack>& tracks,
+                        std::vector<PairApproach>& approaches);
+
+    size_t getCandidateCount() const { return candidates.size(); }
+    double getCellSize() const { return cellSize; }
+};
+
+#endif // CONFLICT_DETECTOR_H
@@ -0,0 +1,77 @@
+#ifndef CONNECTION_CACHE_H
+#define CONNECTION_CACHE_H
+
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <sys/types.h>
+#include "commandCodes.h"
+#include "shm_utils.h"
+
+/** Subsystem endpoints published in /shm_channels */
+enum IpcEndpoint {
+    ENDPOINT_OPERATOR = 0,
+    ENDPOINT_DISPLAY,
+    ENDPOINT_LOGGER,
+    ENDPOINT_COMPUTER,
+    ENDPOINT_COUNT
+};
+
+/**
+ * ConnectionCache keeps one IPC connection per subsystem endpoint for the
+ * lifetime of the process, so periodic sends no longer pay for
+ * connecting and disconnecting.
+ *
+ * get() checks the endpoint's channel ID and PID in /shm_channels (through
+ * a persistent mapping) on every call and reconnects lazily when the peer
+ * has restarted. Callers report a failed send with invalidate() so the next
+ * get() reconnects. Connects, reconnects and failures are counted.
+ */
+class ConnectionCache {
+private:
+    struct Connection {
+        int coid;
+        int chid;
+        pid_t pid;
+    };
+
+    LogFunction logFunction;
+    SharedMemorySegment channelsSegment;
+    Connection connections[ENDPOINT_COUNT];
+    std::mutex mutex;
+
+    std::atomic<uint64_t> connects;
+    std::atomic<uint64_t> reconnects;
+    std::atomic<uint64_t> failures;
+
+    bool lookup(IpcEndpoint endpoint, int& chid, pid_t& pid);
+    void detach(Connection& c);
+
+public:
+    /** @param log The owning subsystem's log function, for peer moves and failed connects */
+    explicit ConnectionCache(LogFunction log = logSystemMessage);
+    ~ConnectionCache();
+
+    ConnectionCache(const ConnectionCache&) = delete;
+    ConnectionCache& operator=(const ConnectionCache&) = delete;
+
+    /** Connection ID for the endpoint, or -1 if it is not reachable */
+    int get(IpcEndpoint endpoint);
+
+    /** Channel and process the endpoint is published at; false if it is not */
+    bool peer(IpcEndpoint endpoint, int& chid, pid_t& pid);
+
+    /** Drop the connection after a failed send on coid */
+    void invalidate(IpcEndpoint endpoint, int coid);
+
+    /** Drop every cached connection */
+    void clear();
+
+    uint64_t getConnects() const { return connects.load(std::memory_order_relaxed); }
+    uint64_t getReconnects() const { return reconnects.load(std::memory_order_relaxed); }
+    uint64_t getFailures() const { return failures.load(std::memory_order_relaxed); }
+
+    static const char* endpointName(IpcEndpoint endpoint);
+};
+
+#endif // CONNECTION_CACHE_H
@@ -0,0 +1,55 @@
+#ifndef CPA_KERNEL_H
+#define CPA_KERNEL_H
+
+#include <cstddef>
+
+/**
+ * Batched closest-point-of-approach kernel. One reference aircraft is
+ * evaluated against a block of candidates laid out as structure-of-arrays,
+ * producing for each candidate the time to closest approach (clamped to
+ * zero when it already happened) and the horizontal and vertical separation
+ * at that time.
+ *
+ * The AVX2 and scalar versions perform the same IEEE operations in the same
+ * order, so they return bit-identical results; cpaBatch() picks AVX2 at
+ * runtime when the CPU supports it.
+ */
+
+struct CpaReference {
+    double x, y, z;
+    double vx, vy, vz;
+};
+
+struct CpaCandidates {
+    const double* x;
+    const double* y;
+    const double* z;
+    const double* vx;
+    const double* vy;
+    const double* vz;
+};
+
+struct CpaResults {
+    double* timeToClosestApproach;
+    double* horizontalSeparation;
+    double* verticalSeparation;
+};
+
+typedef void (*CpaKernelFn)(const CpaReference& ref, const CpaCandidates& cand,
+                            size_t count, CpaResults& out);
+
+void cpaBatchScalar(const CpaReference& ref, const CpaCandidates& cand,
+                    size_t count, CpaResults& out);
+
+#if defined(__x86_64__) || defined(__i386__)
+void cpaBatchAvx2(const CpaReference& ref, const CpaCandidates& cand,
+                  size_t count, CpaResults& out);
+#endif
+
+void cpaBatch(const CpaReference& ref, const CpaCandidates& cand,
+              size_t count, CpaResults& out);
+
+bool cpaAvx2Supported();
+const char* cpaKernelName();
+
+#endif // CPA_KERNEL_H
@@ -3,11 +3,31 @@
 
 #include <vector>
 #include <string>
+#include <atomic>
+#include <thread>
 #include "commandCodes.h"
+#include "GridRenderer.h"
+#include "ConnectionCache.h"
+
+/** Frames between full redraws of the live terminal, to recover from anything else written to it */
+const uint64_t LIVE_REPAINT_FRAMES = 100;
 
 /**
  * DataDisplay listens on a channel for commands (COMMAND_GRID, COMMAND_ONE_PLANE, etc.),
  * prints the results, and logs them to a file.
+ *
+ * With a live output (setLiveOutput), each grid is drawn on that terminal
+ * in place: only the cells that changed are rewritten, through ANSI cursor
+ * moves. data_display.log then gets only the grids logged to the airspace
+ * log; the other grids leave a one-line summary at LOG_DEBUG.
+ *
+ * The display subscribes to ComputerSystem with the airspace its grid
+ * shows (COMMAND_DISPLAY_SUBSCRIBE) and renews the subscription every
+ * DISPLAY_SUBSCRIBE_INTERVAL_MS, so it is sent only the aircraft in view.
+ * Until ComputerSystem has it, the display registered in /shm_channels is
+ * sent every aircraft. A sector display (setSector) does not register
+ * there: it only gets grids through its subscription, so several can run
+ * beside the main one, each on its own part of the airspace.
  */
 class DataDisplay {
     private:
@@ -15,16 +35,39 @@ class DataDisplay {
         pid_t pid;
         int fd;
         std::string logPath;
+        GridRenderer grid;
+        std::string gridMessage;    // Reused so a grid line does not allocate
+        std::string livePath;
+        int liveFd;
+        uint64_t liveFrames;
+        std::string sector;         // Empty for the main display
+        ConnectionCache connections;
+        bool subscribed;            // Only touched by the subscription thread
+        std::atomic<bool> running;
     
         void receiveMessage();
-        std::string generateGrid(const multipleAircraftDisplay& airspaceInfo);
+        void logGrid(const char* label, const std::vector<AircraftDisplayEntry>& aircraft, bool toFile);
+        void drawLive();
+        // On a thread of their own: ComputerSystem sends grids from the
+        // thread that receives subscriptions, so subscribing from the
+        // receive loop could block both on each other
+        void renewSubscription();
+        void subscribe();
+        void unsubscribe();
     
         void registerChannelId();
     
     public:
-        DataDisplay(const std::string& logPath = DEFAULT_AIRSPACE_LOG_PATH);
+        DataDisplay(const std::string& logPath = DEFAULT_AIRSPACE_LOG_PATH,
+                    const GridView& view = GridView());
         int getChid() const;
+        /** Draw grids in place on this terminal (or file); call before run() */
+        void setLiveOutput(const std::string& path) { livePath = path; }
+        /** Run as a sector display with this name; call before run() */
+        void setSector(const std::string& name) { sector = name; }
         void run();
+        /** run() returns within a second */
+        void stop() { running = false; }
         void displayAirspace(double currentTime, const std::vector<Position>& positions);
         void requestAugmentedInfo(int planeId);
     
@@ -0,0 +1,136 @@
+#ifndef DISPLAY_SUBSCRIPTIONS_H
+#define DISPLAY_SUBSCRIPTIONS_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <sys/types.h>
+#include "commandCodes.h"
+
+/** Side of the buckets the sector is divided into to find aircraft by position */
+const double DISPLAY_INDEX_CELL_SIZE = 5000.0;
+
+/** Work done by one DisplaySubscriptions::select() */
+struct DisplaySelectStats {
+    size_t buckets;             // Visited; 0 when the frame was scanned instead
+    size_t tested;              // Aircraft checked against the viewport, not copied with their bucket
+    size_t selected;
+};
+
+/**
+ * Sends grids to one subscribed display from a thread of its own, so a
+ * slow or hung display holds up only itself. It holds two frames not yet
+ * sent at most, the one in flight included, so a console grid and a logged
+ * one posted together both go out; with two, the display is not ready().
+ *
+ * The thread starts with the first frame. Dropping the sender detaches it,
+ * as it may be stuck in a send; it disconnects and exits once that returns.
+ */
+class DisplaySender {
+public:
+    DisplaySender(pid_t pid, int chid);
+    ~DisplaySender();
+
+    DisplaySender(const DisplaySender&) = delete;
+    DisplaySender& operator=(const DisplaySender&) = delete;
+
+    /** True unless two frames are still to be sent, or a send failed */
+    bool ready() const;
+
+    /** errno of the send that failed (the display is gone), 0 until then */
+    int failure() const;
+
+    /**
+     * Send `aircraft` as a grid or log command after any earlier frame.
+     * The frame is swapped into the sender, so `aircraft` comes back with
+     * the buffer of an earlier one.
+     * @return false, leaving `aircraft` alone, if the sender is not ready()
+     */
+    bool post(int commandType, std::vector<AircraftDisplayEntry>& aircraft);
+
+private:
+    struct State;               // Shared with the thread, which may outlive the sender
+    std::shared_ptr<State> state;
+
+    static void run(std::shared_ptr<State> state);
+};
+
+/**
+ * Displays that registered a viewport with ComputerSystem
+ * (COMMAND_DISPLAY_SUBSCRIBE), and the index that finds the aircraft
+ * inside each one, so a display is sent only what it shows.
+ *
+ * The index is a uniform grid of x/y buckets over the sector, filled by
+ * copying the frame's aircraft in bucket order with a counting sort;
+ * aircraft outside the sector go in the edge buckets. select() then visits
+ * only the buckets a viewport overlaps: a bucket inside it is copied whole,
+ * or only checked for altitude, and the aircraft of the others are checked
+ * exactly. Building the index costs about as much as one scan of the
+ * frame, so it is built only by the first select() of a frame that gains
+ * from it: with several subscribers, for a viewport over at most 3/4 of
+ * the buckets. Otherwise select() scans the frame.
+ *
+ * Not thread safe; ComputerSystem uses it from its message loop only.
+ */
+class DisplaySubscriptions {
+public:
+    struct Subscriber {
+        pid_t pid;
+        int chid;
+        DisplayViewport viewport;
+        std::unique_ptr<DisplaySender> sender;
+        uint64_t skipped;       // Frames not sent in a row while the sender was not ready
+    };
+
+    explicit DisplaySubscriptions(double cellSize = DISPLAY_INDEX_CELL_SIZE);
+
+    DisplaySubscriptions(const DisplaySubscriptions&) = delete;
+    DisplaySubscriptions& operator=(const DisplaySubscriptions&) = delete;
+
+    /**
+     * Register the display on (pid, chid), or move its viewport.
+     * @return false if MAX_DISPLAY_SUBSCRIPTIONS others are subscribed
+     */
+    bool subscribe(pid_t pid, int chid, const DisplayViewport& viewport);
+
+    /** @return false if the display was not subscribed */
+    bool unsubscribe(pid_t pid, int chid);
+
+    /** Drop subscriber `i`, as after a failed send */
+    void remove(size_t i);
+
+    size_t size() const { return subscribers.size(); }
+    Subscriber& at(size_t i) { return subscribers[i]; }
+    bool contains(pid_t pid, int chid) const;
+
+    /** Take the aircraft of a frame; they must stay valid for the select() calls until the next one */
+    void index(const AircraftDisplayEntry* aircraft, size_t count);
+
+    /**
+     * The aircraft of the frame inside `viewport`: in frame order when the
+     * frame is scanned, by bucket and in frame order within each otherwise
+     */
+    void select(const DisplayViewport& viewport, std::vector<AircraftDisplayEntry>& out,
+                DisplaySelectStats* stats = nullptr);
+
+private:
+    std::vector<Subscriber> subscribers;
+
+    double cellSize;
+    int columns, rows;
+    const AircraftDisplayEntry* frame;
+    size_t frameCount;
+    bool indexed;               // The buckets hold the current frame
+    std::vector<uint32_t> bucketStart;  // Of each bucket's run in `sorted`, then the end
+    std::vector<uint32_t> bucketOf;     // Of each aircraft
+    std::vector<AircraftDisplayEntry> sorted;   // The frame, grouped by bucket
+
+    int column(double x) const;
+    int row(double y) const;
+    /** Bounds of a bucket; the edge buckets reach out to infinity */
+    double edge(int index, int count, double origin) const;
+    void buildIndex();
+    void scan(const DisplayViewport& viewport, std::vector<AircraftDisplayEntry>& out) const;
+};
+
+#endif // DISPLAY_SUBSCRIPTIONS_H
@@ -0,0 +1,198 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <time.h>
+#include "AsyncLog.h"
+
+/**
+ * Binary structured event log. Each event is one fixed-size record: a
+ * CLOCK_MONOTONIC nanosecond timestamp, the subsystem and event ids and
+ * up to EVENT_MAX_ARGS typed numeric arguments. Records are appended to
+ * one memory-mapped file shared by every process: a writer claims a slot
+ * with a fetch_add on the file header and fills it in place, with no
+ * formatting, lock or syscall. `atc-logdump` renders the file as text
+ * using EVENT_CATALOG.
+ *
+ * The log is optional. ATCController creates the file when started with
+ * --event-log and passes its path to the subsystems in ATC_EVENT_LOG;
+ * without it, EVENT_LOG() costs one atomic load. Events are recorded
+ * regardless of the text log level, so DEBUG telemetry such as
+ * per-aircraft positions can stay on in production. The file does not
+ * grow: once it is full, new events are counted in `dropped`.
+ */
+
+#define EVENT_LOG_ENV "ATC_EVENT_LOG"
+#define EVENT_LOG_DEFAULT_PATH "/tmp/atc/logs/events.bin"
+
+const uint64_t EVENT_LOG_MAGIC = 0x3130545645435441ULL;     // "ATCEVT01"
+const uint64_t EVENT_LOG_DEFAULT_RECORDS = 1 << 20;         // 64 MiB file
+const uint64_t MAX_EVENT_LOG_RECORDS = 1ULL << 26;          // 4 GiB file
+const int EVENT_MAX_ARGS = 6;
+
+enum EventSubsystem : uint16_t {
+    EVSUB_ATC_CONTROLLER,
+    EVSUB_RADAR,
+    EVSUB_COMPUTER_SYSTEM,
+    EVSUB_OPERATOR_CONSOLE,
+    EVSUB_DATA_DISPLAY,
+    EVSUB_COMMUNICATION_SYSTEM,
+    EVSUB_AIRSPACE_LOGGER,
+    EVSUB_COUNT
+};
+
+/** Add new events at the end; ids are stored in existing files */
+enum EventId : uint16_t {
+    EVT_RADAR_FRAME,            // tracks, sequence
+    EVT_TRACK_POSITION,         // plane, x, y, z
+    EVT_TRACK_STOPPED,          // plane, x, y, z
+    EVT_COMMAND_QUEUED,         // sequence, plane, vx, vy, vz
+    EVT_COMMAND_TRANSMITTED,    // sequence, plane, vx, vy, vz
+    EVT_COMMAND_APPLIED,        // sequence, plane, status, vx, vy, vz
+    EVT_COMMAND_ACKNOWLEDGED,   // sequence, plane, status, issueToApplyMs
+    EVT_VIOLATION_CHECK,        // pairs, changed, conflicts, fullPass
+    EVT_CONFLICT,               // plane1, plane2, timeToClosestApproach
+    EVT_COUNT
+};
+
+enum EventArgType : uint8_t {
+    EVENT_ARG_INT = 0,
+    EVENT_ARG_UINT = 1,
+    EVENT_ARG_DOUBLE = 2
+};
+
+union EventArg {
+    int64_t i;
+    uint64_t u;
+    double d;
+};
+
+/**
+ * One 64-byte record. `timestampNs` is stored last, with release order;
+ * a zero timestamp marks a slot that was claimed but never completed.
+ */
+struct EventRecord {
+    std::atomic<int64_t> timestampNs;
+    uint16_t subsystem;
+    uint16_t event;
+    uint8_t level;
+    uint8_t argCount;
+    uint16_t argTypes;          // EventArgType, two bits per argument
+    EventArg args[EVENT_MAX_ARGS];
+};
+
+static_assert(sizeof(EventRecord) == 64, "event records are one cache line");
+
+/** Start of the file; records follow at offset sizeof(EventLogHeader) */
+struct alignas(64) EventLogHeader {
+    uint64_t magic;
+    uint32_t recordSize;
+    uint32_t reserved;
+    uint64_t capacity;                  // Records the file holds
+    int64_t createdMonotonicNs;         // Same instant on both clocks, so
+    int64_t createdRealtimeNs;          // monotonic stamps map to wall time
+    alignas(64) std::atomic<uint64_t> next;     // Slots claimed so far
+    std::atomic<uint64_t> dropped;              // Events after the file filled
+};
+
+struct EventInfo {
+    const char* name;
+    LogLevel level;
+    int argCount;
+    const char* argNames[EVENT_MAX_ARGS];
+};
+
+/** Name, level and argument names of every EventId, shared with atc-logdump */
+extern const EventInfo EVENT_CATALOG[EVT_COUNT];
+extern const char* const EVENT_SUBSYSTEM_NAMES[EVSUB_COUNT];
+
+/**
+ * Create (or truncate) an event log file with room for `records` events.
+ * @return true on success, false also if `records` is 0 or above MAX_EVENT_LOG_RECORDS
+ */
+bool eventLogCreate(const char* path, uint64_t records);
+
+/** Map an existing event log for writing; later EVENT_LOG() calls use it */
+bool eventLogOpen(const char* path);
+
+enum EventLogState { EVENT_LOG_UNKNOWN = 0, EVENT_LOG_ON = 1, EVENT_LOG_OFF = 2 };
+
+extern std::atomic<int> eventLogState;
+
+/** Open the file named by ATC_EVENT_LOG, once; false if unset or unusable */
+bool eventLogAttach();
+
+inline bool eventLogEnabled() {
+    int state = eventLogState.load(std::memory_order_acquire);
+    return state == EVENT_LOG_ON || (state == EVENT_LOG_UNKNOWN && eventLogAttach());
+}
+
+/** Claim a record; nullptr if the file is full */
+EventRecord* eventLogClaim();
+
+inline void eventSetInt(EventRecord* r, int i, int64_t v) {
+    r->args[i].i = v;
+    r->argTypes |= EVENT_ARG_INT << (2 * i);
+}
+
+inline void eventSetUint(EventRecord* r, int i, uint64_t v) {
+    r->args[i].u = v;
+    r->argTypes |= EVENT_ARG_UINT << (2 * i);
+}
+
+inline void eventSetArg(EventRecord* r, int i, int v) { eventSetInt(r, i, v); }
+inline void eventSetArg(EventRecord* r, int i, long v) { eventSetInt(r, i, v); }
+inline void eventSetArg(EventRecord* r, int i, long long v) { eventSetInt(r, i, v); }
+inline void eventSetArg(EventRecord* r, int i, unsigned v) { eventSetUint(r, i, v); }
+inline void eventSetArg(EventRecord* r, int i, unsigned long v) { eventSetUint(r, i, v); }
+inline void eventSetArg(EventRecord* r, int i, unsigned long long v) { eventSetUint(r, i, v); }
+inline void eventSetArg(EventRecord* r, int i, bool v) { eventSetUint(r, i, v); }
+
+inline void eventSetArg(EventRecord* r, int i, double v) {
+    r->args[i].d = v;
+    r->argTypes |= EVENT_ARG_DOUBLE << (2 * i);
+}
+
+inline void eventSetArgs(EventRecord*, int) {}
+
+template <typename T, typename... Rest>
+inline void eventSetArgs(EventRecord* r, int i, const T& first, const Rest&... rest) {
+    eventSetArg(r, i, first);
+    eventSetArgs(r, i + 1, rest...);
+}
+
+/** Append one event; use EVENT_LOG(), which skips this when the log is off */
+template <typename... Args>
+void eventLogWrite(EventSubsystem subsystem, EventId event, const Args&... args) {
+    static_assert(sizeof...(Args) <= EVENT_MAX_ARGS, "too many event arguments");
+    EventRecord* r = eventLogClaim();
+    if (!r) {
+        return;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    r->subsystem = subsystem;
+    r->event = event;
+    r->level = (uint8_t)EVENT_CATALOG[event].level;
+    r->argCount = (uint8_t)sizeof...(Args);
+    r->argTypes = 0;
+    eventSetArgs(r, 0, args...);
+    r->timestampNs.store((int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec, std::memory_order_release);
+}
+
+/**
+ * Record an event if the binary log is enabled; arguments are not
+ * evaluated otherwise.
+ *
+ *     EVENT_LOG(EVSUB_RADAR, EVT_TRACK_POSITION, id, x, y, z);
+ */
+#define EVENT_LOG(subsystem, event, ...) \
+    do { \
+        if (eventLogEnabled()) { \
+            eventLogWrite(subsystem, event, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#endif // EVENT_LOG_H
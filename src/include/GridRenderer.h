@@ -0,0 +1,195 @@
+#ifndef GRID_RENDERER_H
+#define GRID_RENDERER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "commandCodes.h"
+
+/** Largest grid a view may ask for, in cells */
+const int MAX_GRID_COLUMNS = 256;
+const int MAX_GRID_ROWS = 256;
+const int MAX_GRID_CELL_WIDTH = 32;
+const int MAX_GRID_BANDS = 8;
+
+/** How much a cell says about the aircraft in it */
+enum GridDetail {
+    GRID_DETAIL_AUTO,           // Ids where they fit, else a count; density above GridView::densityAbove
+    GRID_DETAIL_IDS,            // Ids, ending with '+' where they do not all fit
+    GRID_DETAIL_COUNTS,         // "[n]"
+    GRID_DETAIL_DENSITY         // The cell filled with a shade from GRID_DENSITY_SHADES
+};
+
+/** Density shades: 1, 2, up to 4, 8, ... 128 aircraft, then more */
+const char GRID_DENSITY_SHADES[] = ".:-=+*#%@";
+const char GRID_DENSITY_LEGEND[] = "density . 1  : 2  - 4  = 8  + 16  * 32  # 64  % 128  @ more";
+
+/** Default GridView::densityAbove */
+const size_t DEFAULT_GRID_DENSITY_ABOVE = 1000;
+
+/** Default altitude slicing: 5 km bands, and profile rows of the minimum vertical separation */
+const double DEFAULT_GRID_BAND_HEIGHT = 5000.0;
+const double DEFAULT_GRID_PROFILE_ROW_HEIGHT = 1000.0;
+
+/**
+ * What the plan-view grid shows: `columns` x `rows` cells, each
+ * `cellSize / zoom` metres square, centred on (centerX, centerY). Rows go
+ * down with y. The defaults are the 25 x 25 grid of 4 km cells over the
+ * 100 km sector that DataDisplay has always printed.
+ *
+ * `detail` picks what each cell shows; by default ids, a count for cells
+ * too crowded to list them, and density shading for the whole frame once
+ * more than `densityAbove` aircraft are in view.
+ *
+ * Altitude can be shown too. With `bands`, the plan view is split into
+ * that many views of `bandHeight` metres each, stacked from
+ * `altitudeFloor` up. With `profileRows`, a side profile of the same
+ * columns follows: x across, altitude up, `profileRowHeight` metres per
+ * row from `altitudeFloor`. Either way each view gets a title line.
+ */
+struct GridView {
+    int columns;
+    int rows;
+    double cellSize;            // Metres per cell at zoom 1
+    double zoom;                // 2 halves the cell size, keeping the centre
+    double centerX, centerY;
+    int cellWidth;              // Characters per cell, without the '|' separator
+    GridDetail detail;
+    size_t densityAbove;        // Aircraft in view, for GRID_DETAIL_AUTO
+    int bands;                  // Plan views by altitude; 0 for one of every altitude
+    double bandHeight;
+    int profileRows;            // 0 for no side profile
+    double profileRowHeight;
+    double altitudeFloor;       // Bottom of the first band and of the profile
+
+    GridView() : columns(25), rows(25), cellSize(4000.0), zoom(1.0),
+                 centerX(50000.0), centerY(50000.0), cellWidth(5),
+                 detail(GRID_DETAIL_AUTO), densityAbove(DEFAULT_GRID_DENSITY_ABOVE),
+                 bands(0), bandHeight(DEFAULT_GRID_BAND_HEIGHT),
+                 profileRows(0), profileRowHeight(DEFAULT_GRID_PROFILE_ROW_HEIGHT), altitudeFloor(0.0) {}
+};
+
+/**
+ * Renders aircraft into the text grid DataDisplay prints and logs:
+ *
+ *   |     |     | 1,12|     |  4  |...
+ *
+ * The cell of each aircraft is computed from its position, and aircraft
+ * are grouped by cell with a counting sort over the occupied cells only.
+ * The band plan views and the side profile are cells of the same frame,
+ * so one pass bins each aircraft into its band's plan cell and its
+ * profile cell, and the same sort groups both.
+ * Each cell lists the ids in it, in input order, centred; when they do not
+ * fit, it lists those that do and ends with '+'. Aircraft outside the view
+ * are left out.
+ *
+ * Busy frames are summarised instead (see GridDetail): crowded cells show
+ * how many aircraft they hold, "[12]", and above a threshold every cell is
+ * shaded by density, "=====". Both come from the per-cell counts alone, so
+ * such frames skip grouping the ids. Aircraft flagged AIRCRAFT_IN_CONFLICT
+ * are still shown by id over the summary: a summarised cell holding any
+ * lists only those, after a '!', as in "!12,47".
+ *
+ * The frame is kept between renders and only the cells written by the
+ * previous render are blanked, so the cost follows the number of
+ * aircraft, not the size of the grid. Buffers grow to the largest frame
+ * seen and are then reused: a render does not allocate once it has seen
+ * as many aircraft as it is given.
+ *
+ * For a live terminal, terminalUpdate() turns each render into ANSI
+ * cursor moves and the text of the cells that changed since the terminal
+ * was last updated, so output follows what moved rather than the grid
+ * size.
+ */
+class GridRenderer {
+public:
+    explicit GridRenderer(const GridView& view = GridView());
+
+    /** True if `view` is within the MAX_GRID_* limits, with positive, finite cell sizes */
+    static bool isValid(const GridView& view);
+
+    /**
+     * Show another part of the airspace, or at another resolution.
+     * @return false, keeping the current view, if `view` is out of range
+     */
+    bool setView(const GridView& view);
+    const GridView& getView() const { return view; }
+
+    /** The airspace the view shows: aircraft outside it are never drawn */
+    DisplayViewport getViewport() const;
+
+    /**
+     * Render one frame. The text is valid until the next render() or
+     * setView(); it starts with a newline and ends with one. It has
+     * getLines() lines, each '\n' and the same number of characters.
+     */
+    const std::string& render(const AircraftDisplayEntry* aircraft, size_t count);
+
+    size_t getLines() const { return lines; }
+
+    /** Aircraft inside the view in the last frame */
+    size_t getPlotted() const { return plotted; }
+
+    /**
+     * How the last frame was drawn: GRID_DETAIL_IDS, _COUNTS or _DENSITY.
+     * With GRID_DETAIL_AUTO, crowded cells of an ids frame are counted.
+     */
+    GridDetail getDetail() const { return drawn; }
+
+    /**
+     * ANSI escapes that bring a terminal showing the previous frame up to
+     * date with the last render(): for each cell that changed, a cursor
+     * move and its new text. The grid's first row goes on terminal line
+     * `firstLine`, and the cursor is left on the line below the grid.
+     * The first update, after setView() or repaint() or when a render was
+     * not followed by an update, clears the terminal from `firstLine` down
+     * and draws the whole grid instead. Valid until the next call.
+     */
+    const std::string& terminalUpdate(int firstLine = 1);
+
+    /** Have the next terminalUpdate() redraw the whole grid */
+    void repaint() { repaintPending = true; }
+
+    /** Cells the last terminalUpdate() wrote */
+    size_t getCellsChanged() const { return cellsChanged; }
+
+private:
+    GridView view;
+    double left, top;           // Corner of cell (0, 0), in metres
+    double cellMetres;
+    size_t rowBytes;            // "\n" then "|" and cellWidth characters per column
+    size_t lines;               // Rows of every view, and their titles
+    uint32_t planCells;         // Per band
+    uint32_t profileFirst;      // First cell of the side profile
+
+    std::string frame;
+    std::vector<uint32_t> cellOffset;   // Of each cell's text in `frame`
+    std::vector<uint32_t> cellCount;    // Aircraft per cell, zero outside `occupied`
+    std::vector<uint32_t> cellEnd;      // End of each occupied cell's run in `ids`
+    std::vector<uint32_t> occupied;     // Cells with aircraft this frame; room for every cell and one
+    size_t occupiedCount;
+    std::vector<uint32_t> written;      // Offsets of the cells the last render wrote
+    size_t writtenCount;
+    std::vector<uint32_t> previous;     // And those the render before it wrote
+    size_t previousCount;
+    std::vector<uint32_t> binCell;      // Each aircraft's cells in the views it shows in,
+    std::vector<int32_t> binId;         // and its id, in input order
+    std::vector<int32_t> ids;           // Aircraft ids grouped by cell
+    std::vector<uint64_t> flagged;      // In-conflict aircraft: cell << 32 | input index
+    size_t plotted;
+    GridDetail drawn;
+
+    std::string shown;                  // The frame as the terminal shows it
+    std::string ansi;
+    bool repaintPending;
+    int rendersSinceUpdate;
+    size_t cellsChanged;
+
+    bool writeIds(char* text, const int32_t* cellIds, uint32_t n, char marker, bool overflow);
+    void writeCount(char* text, uint32_t n);
+    void writeShade(char* text, uint32_t n);
+    void moveCursor(int line, int column);
+    void title(size_t line, const char* format, double from, double to);
+};
+
+#endif // GRID_RENDERER_H
@@ -0,0 +1,53 @@
+#ifndef HISTORY_QUERY_H
+#define HISTORY_QUERY_H
+
+#include <cstdint>
+#include <vector>
+#include "AirspaceHistory.h"
+
+/**
+ * Range queries over an airspace history (AirspaceHistory.h): every
+ * aircraft inside a box over a time range, the track of some aircraft, or
+ * both at once.
+ *
+ * The time range is found by binary search over the block summaries in
+ * blocks.idx. A block whose bounding box misses the query box is skipped
+ * without being read. In the others, the spans of the aircraft asked for
+ * are found by binary search by id, spans whose own bounding box misses
+ * are skipped, and only the tracks of the remaining spans are decoded.
+ * Frames not yet indexed (the block being written, or histories recorded
+ * before blocks were indexed) are decoded whole and filtered.
+ */
+
+struct HistoryQuery {
+    int64_t fromNs;             // CLOCK_REALTIME range, inclusive
+    int64_t toNs;
+    bool boxed;                 // Only positions inside min..max, inclusive
+    double min[3], max[3];
+    std::vector<int32_t> ids;   // Only these aircraft; empty for every one
+
+    HistoryQuery() : fromNs(INT64_MIN), toNs(INT64_MAX), boxed(false), min{0, 0, 0}, max{0, 0, 0} {}
+};
+
+/** What a query had to read, to tell how well the index served it */
+struct HistoryQueryStats {
+    uint64_t blocks;            // Indexed blocks in the time range
+    uint64_t blocksSkipped;     // Of those, skipped by bounding box
+    uint64_t spansRead;         // Aircraft tracks decoded
+    uint64_t spansSkipped;      // Spans of the aircraft asked for skipped by bounding box
+    uint64_t framesDecoded;     // Frames not indexed, decoded whole
+
+    HistoryQueryStats() : blocks(0), blocksSkipped(0), spansRead(0), spansSkipped(0), framesDecoded(0) {}
+};
+
+/**
+ * Run `query` over the frames `reader` has published. `points` receives
+ * the matching positions sorted by frame, then aircraft id. Positions and
+ * velocities are decoded to HISTORY_POSITION_QUANTUM and
+ * HISTORY_VELOCITY_QUANTUM.
+ * @return false if part of the history is damaged; `points` then holds what could be read
+ */
+bool queryHistory(const AirspaceHistoryReader& reader, const HistoryQuery& query,
+                  std::vector<HistoryTrackPoint>& points, HistoryQueryStats* stats = nullptr);
+
+#endif // HISTORY_QUERY_H
@@ -0,0 +1,142 @@
+#ifndef INCREMENTAL_CONFLICT_DETECTOR_H
+#define INCREMENTAL_CONFLICT_DETECTOR_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "commandCodes.h"
+#include "ConflictDetector.h"
+
+/**
+ * IncrementalConflictDetector reports the same conflicts as ConflictDetector
+ * but reuses closest-approach results between radar frames.
+ *
+ * Two aircraft that keep their velocity have a fixed closest point of
+ * approach in absolute time, so a pair result only needs recomputing once
+ * either aircraft changes trajectory. A trajectory change is a new velocity
+ * epoch on the track, a different velocity, or a position that no longer
+ * matches dead reckoning from the last known state.
+ *
+ * Every rebuildInterval seconds (and whenever too many aircraft change at
+ * once) a full spatial-hash pass is run with the horizon extended by the
+ * interval, which bounds every pair that can conflict before the next
+ * rebuild. In between, only pairs involving changed or new aircraft are
+ * evaluated, and only against aircraft close enough to conflict with them
+ * before the next rebuild's horizon ends: the current positions are binned
+ * into a uniform grid, and a partner must lie within reach of the changed
+ * aircraft's swept box and have a swept box overlapping it. Cached CPA
+ * times are aged by the frame time. Pairs whose minimum distance can never
+ * breach both minima are not cached at all.
+ */
+class IncrementalConflictDetector {
+private:
+    /** Last known straight-line trajectory of one aircraft */
+    struct AircraftState {
+        uint32_t epoch;         // Velocity epoch from the radar track
+        uint32_t revision;      // Bumped on every detected trajectory change
+        double refTime;
+        double x, y, z;
+        double vx, vy, vz;
+        uint32_t index;         // Index in the current frame
+        uint64_t lastSeen;      // Detection cycle that last saw this aircraft
+    };
+
+    /** Cached closest approach of a pair that may still conflict */
+    struct PairState {
+        uint32_t firstRevision;
+        uint32_t secondRevision;
+        double closestApproachTime;     // Absolute frame time of the CPA
+        double horizontalSeparation;
+        double verticalSeparation;
+    };
+
+    struct FoundConflict {
+        uint32_t first;
+        uint32_t second;
+        double timeToClosestApproach;
+
+        bool operator<(const FoundConflict& o) const {
+            return first != o.first ? first < o.first : second < o.second;
+        }
+    };
+
+    ConflictDetector detector;
+    double minHorizontalSeparation;
+    double minVerticalSeparation;
+    double horizonSeconds;
+    double rebuildInterval;
+
+    std::unordered_map<int, AircraftState> aircraft;
+    std::unordered_map<uint64_t, PairState> pairs;
+
+    bool haveBaseline;
+    double lastRebuildTime;
+    double lastFrameTime;
+    double rebuildHorizon;
+    uint64_t cycle;
+    uint32_t nextRevision;
+
+    // Current frame in structure-of-arrays form
+    std::vector<double> x, y, z;
+    std::vector<double> vx, vy, vz;
+    std::vector<uint32_t> changedIndices;
+    std::vector<char> changedFlags;
+
+    // Current positions by grid cell, built when aircraft changed
+    double gridMinX, gridMinY, gridCellSize;
+    int gridColumns, gridRows;
+    double maxHorizontalSpeed;
+    std::vector<uint32_t> gridStart;    // Of each cell's run in gridOrder, then the end
+    std::vector<uint32_t> gridCellOf;
+    std::vector<uint32_t> gridOrder;
+
+    // Partners of one changed aircraft, gathered for the CPA kernel
+    std::vector<uint32_t> partners;
+    std::vector<double> partnerX, partnerY, partnerZ;
+    std::vector<double> partnerVx, partnerVy, partnerVz;
+    std::vector<double> resultTime, resultHorizontal, resultVertical;
+    std::vector<PairApproach> approaches;
+    std::vector<FoundConflict> found;
+
+    size_t pairsEvaluated;
+    bool lastCycleRebuilt;
+
+    static uint64_t pairKey(int a, int b);
+    bool mayEverConflict(double horizontal, double vertical) const;
+
+    size_t loadFrame(const std::vector<RadarTrack>& tracks, double frameTime);
+    void rebuild(const std::vector<RadarTrack>& tracks, double frameTime);
+    void buildGrid();
+    void findPartners(uint32_t c, double window);
+    void refreshChanged(const std::vector<RadarTrack>& tracks, double frameTime);
+    void storePair(const RadarTrack& a, const RadarTrack& b, double frameTime,
+                   double t, double horizontal, double vertical);
+    void evaluatePairs(const std::vector<RadarTrack>& tracks, double frameTime);
+
+public:
+    IncrementalConflictDetector(double minHorizontalSeparation, double minVerticalSeparation,
+                                double horizonSeconds, double rebuildInterval = 30.0);
+
+    void setThreadPool(ThreadPool* pool) { detector.setThreadPool(pool); }
+
+    void setHorizon(double seconds) { horizonSeconds = seconds; }
+    double getHorizon() const { return horizonSeconds; }
+
+    /**
+     * Detect conflicts in a radar frame taken at frameTime (seconds). Frames
+     * must be passed in time order; a frame earlier than the previous one
+     * forces a full pass.
+     */
+    void detect(const std::vector<RadarTrack>& tracks, double frameTime,
+                std::vector<Conflict>& conflicts);
+
+    /** Drop all cached state so the next frame runs a full pass */
+    void reset();
+
+    size_t getPairsEvaluated() const { return pairsEvaluated; }
+    size_t getCachedPairs() const { return pairs.size(); }
+    size_t getChangedCount() const { return changedIndices.size(); }
+    bool wasRebuilt() const { return lastCycleRebuilt; }
+};
+
+#endif // INCREMENTAL_CONFLICT_DETECTOR_H
@@ -0,0 +1,79 @@
+#ifndef IPC_H
+#define IPC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+/**
+ * Portable message passing with QNX semantics: a server creates a channel
+ * and receives messages or pulses on it; a client connects to (pid, chid)
+ * and sends a message, blocking until the server replies. Functions return
+ * -1 and set errno on failure, like the QNX calls they replace.
+ *
+ * Two backends implement this interface, selected at build time:
+ * - IpcQnx.cpp maps every call onto ChannelCreate/MsgReceive/MsgSend/
+ *   MsgReply and timer pulses.
+ * - IpcLinux.cpp keeps each channel in a shared memory segment holding a
+ *   lock-free request ring with a futex doorbell. Each connection owns a
+ *   shared mailbox that carries the request and the reply, so message
+ *   bodies never pass through the kernel. Timer pulses come from timerfds
+ *   serviced by one timer thread per process.
+ */
+
+#ifndef EOK
+#define EOK 0
+#endif
+
+/** One part of a message sent with ipcSendv() */
+struct IpcIov {
+    const void* base;
+    size_t len;
+};
+
+/** Pulse delivered by ipcReceive() when it returns 0 */
+struct IpcPulse {
+    int code;
+    int value;
+};
+
+/** Create a channel owned by this process; returns its chid */
+int ipcChannelCreate();
+int ipcChannelDestroy(int chid);
+
+/**
+ * Block until a message or pulse arrives on chid.
+ * @param buf Receives up to size bytes of the message
+ * @param pulse Receives the pulse when the call returns 0
+ * @return rcvid > 0 for a message, 0 for a pulse, -1 on error
+ */
+int ipcReceive(int chid, void* buf, size_t size, IpcPulse* pulse);
+
+/** Copy bytes of the message starting at offset; returns the bytes copied */
+long ipcRead(int rcvid, void* buf, size_t bytes, size_t offset);
+
+/** Unblock the sender; its ipcSend() returns status */
+int ipcReply(int rcvid, int status, const void* msg, size_t size);
+
+/** Unblock the sender; its ipcSend() fails with errno set to err */
+int ipcError(int rcvid, int err);
+
+/** Connect to channel chid of process pid; returns a coid */
+int ipcConnect(pid_t pid, int chid);
+int ipcDisconnect(int coid);
+
+/** Send a message and block for the reply; returns the reply status */
+int ipcSend(int coid, const void* msg, size_t size, void* reply, size_t replySize);
+int ipcSendv(int coid, const IpcIov* iov, int parts, void* reply, size_t replySize);
+
+/** Queue a pulse without waiting for the receiver */
+int ipcSendPulse(int coid, int code, int value);
+
+/**
+ * Deliver a pulse with the given code to chid every intervalMs
+ * milliseconds, starting one interval from now.
+ * @return timer ID, or -1 on error
+ */
+int ipcTimerCreate(int chid, int code, int intervalMs);
+
+#endif // IPC_H
@@ -0,0 +1,55 @@
+#ifndef KINEMATICS_ENGINE_H
+#define KINEMATICS_ENGINE_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * KinematicsEngine advances every tracked aircraft in a single pass per tick.
+ * State is kept as structure-of-arrays so the update loop streams through
+ * contiguous x/y/z and vx/vy/vz columns instead of chasing Plane objects.
+ * Boundary handling matches Plane::updatePosition: an aircraft that would
+ * leave the airspace is parked on the boundary with zero velocity.
+ *
+ * Every aircraft carries a velocity epoch, a stamp that changes whenever its
+ * velocity does (added, setVelocity, parked on the boundary). Consumers can
+ * treat two frames with the same epoch as one straight-line trajectory.
+ */
+class KinematicsEngine {
+private:
+    std::vector<int> ids;
+    std::vector<double> x, y, z;
+    std::vector<double> vx, vy, vz;
+    std::vector<uint32_t> epochs;
+    std::unordered_map<int, size_t> indexById;
+    uint32_t nextEpoch;
+
+public:
+    KinematicsEngine();
+
+    bool addAircraft(int id, double px, double py, double pz,
+                     double pvx, double pvy, double pvz);
+    bool removeAircraft(int id);
+    bool setVelocity(int id, double pvx, double pvy, double pvz);
+    bool contains(int id) const { return indexById.count(id) != 0; }
+
+    void advance(double dt);
+
+    size_t removeStopped(std::vector<int>& removedIds);
+
+    size_t size() const { return ids.size(); }
+    void reserve(size_t n);
+
+    const std::vector<int>&    getIds() const { return ids; }
+    const std::vector<double>& getX() const   { return x; }
+    const std::vector<double>& getY() const   { return y; }
+    const std::vector<double>& getZ() const   { return z; }
+    const std::vector<double>& getVx() const  { return vx; }
+    const std::vector<double>& getVy() const  { return vy; }
+    const std::vector<double>& getVz() const  { return vz; }
+    const std::vector<uint32_t>& getEpochs() const { return epochs; }
+};
+
+#endif // KINEMATICS_ENGINE_H
@@ -20,8 +20,12 @@ private:
     static pthread_mutex_t mutex;
     static std::queue<OperatorConsoleResponseMessage> responseQueue;
 
+    std::vector<ConflictAlert> alertBuffer;
+
     void logCommand(const std::string& cmd);
     void listen();
+    bool receiveAlertBatch(int rcvid, const OperatorConsoleAlertBatchMessage& msg);
+    void renderAlertBatch(double frameTimestamp);
     static void* cinRead(void* param);
     static void tokenize(std::vector<std::string>& dest, std::string& str);
     
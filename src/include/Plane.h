@@ -3,11 +3,12 @@
 
 #include "utils.h"
 #include "commandCodes.h"
-#include <atomic>
-#include <thread>
 #include <mutex>
 
-/** Represents a single plane. Updated by Radar every second. */
+/**
+ * Represents a single plane as read from the input file.
+ * Radar copies it into its KinematicsEngine, which advances it every second.
+ */
 class Plane {
 private:
     int id;
@@ -16,10 +17,6 @@ private:
     double lastUpdateTime;
     
     mutable std::mutex positionMutex;
-    std::atomic<bool> running;
-    std::thread planeThread;
-    
-    void runPlaneProcess(double startTime);
 
 public:
     Plane(int pid, double x, double y, double z,
@@ -27,8 +24,6 @@ public:
     ~Plane();
 
     void updatePosition(double currentTime);
-    void start(double startTime);
-    void stop();
 
     int    getId() const   { return id; }
     
@@ -4,14 +4,38 @@
 #include <vector>
 #include <mutex>
 #include "Plane.h"
+#include "AirspaceHistory.h"
+#include "KinematicsEngine.h"
+#include "shm_utils.h"
 
 /**
- * Radar updates plane positions every second and writes to /shm_radar_data.
+ * Radar advances all tracked aircraft through a single KinematicsEngine
+ * every second and writes the resulting snapshot to /shm_radar_data.
+ * Each tick it also applies the commands CommunicationSystem transmitted
+ * over /shm_uplink and acknowledges them on /shm_command_acks.
+ *
+ * In replay mode (RadarMain --replay) Radar publishes frames recorded in
+ * an airspace history instead of simulating; the commands it receives
+ * are acknowledged as unsupported.
  */
 class Radar {
 private:
-    std::vector<Plane*> trackedPlanes;
+    KinematicsEngine engine;
+    std::vector<int> removedIds;
+    double lastUpdateTime;
     std::mutex planesMutex; 
+    SharedMemorySegment frameSegment;
+    SharedMemorySegment uplinkSegment;
+    SharedMemorySegment ackSegment;
+
+    HistoryReplayTracks replayTracks;
+    bool replaying;
+
+    void trackPlane(Plane* plane);
+    void applyCommands();
+    int applyCommand(const Command& cmd);
+    bool ensureFrameCapacity(size_t n);
+    bool publishFrame(double currentTime);
 
 public:
     Radar();
@@ -23,6 +47,13 @@ public:
     
     void addPlane(Plane* plane, double currentTime);
     void removePlane(int planeId);
+
+    /**
+     * Publish a frame recorded in an airspace history in place of the
+     * simulated traffic, keeping its simulation time and recorded time.
+     * @return true if successful, false otherwise
+     */
+    bool replayFrame(const HistoryFrame& frame);
 };
 
-#endif // RADAR_H
\ No newline at end of file
+#endif // RADAR_H
@@ -0,0 +1,69 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * ThreadPool runs indexed task batches on a fixed set of worker threads.
+ *
+ * parallelFor() deals the task indices out to per-worker deques in
+ * contiguous blocks. Each worker pops from the back of its own deque and,
+ * once it runs dry, steals from the front of the others, so uneven tasks
+ * still keep every core busy. The calling thread takes part as worker 0 and
+ * the call returns once every task has finished.
+ *
+ * Task functions receive the worker index (0 .. size() - 1) so callers can
+ * keep per-worker scratch buffers without locking.
+ */
+class ThreadPool {
+public:
+    typedef std::function<void(size_t task, size_t worker)> Task;
+
+    /** threadCount == 0 sizes the pool to the number of hardware threads */
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /** Number of workers, including the calling thread */
+    size_t size() const { return queues.size(); }
+
+    void parallelFor(size_t taskCount, const Task& fn);
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> threads;
+
+    // Serializes parallelFor() callers
+    std::mutex jobMutex;
+    const Task* job;
+    std::atomic<size_t> remaining;
+
+    std::mutex stateMutex;
+    std::condition_variable wakeCv;
+    std::condition_variable doneCv;
+    uint64_t generation;
+    bool stopping;
+
+    void workerLoop(size_t worker);
+    void runTasks(size_t worker);
+    bool popLocal(size_t worker, size_t& task);
+    bool steal(size_t worker, size_t& task);
+};
+
+#endif // THREAD_POOL_H
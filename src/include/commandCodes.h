@@ -4,18 +4,36 @@
 #include <vector>
 #include <ctime>
 #include <string>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <semaphore.h>
 
 /** POSIX shared memory names **/
 #define SHM_RADAR_DATA "/shm_radar_data"
 #define SHM_COMMANDS   "/shm_commands"
+#define SHM_UPLINK     "/shm_uplink"
+#define SHM_COMMAND_ACKS "/shm_command_acks"
 #define SHM_CHANNELS   "/shm_channels" 
 #define SHM_SYNC_READY "/shm_sync_ready"
 
-#define MAX_PLANES    10
-#define MAX_COMMANDS  10
+// Command ring capacity used when none is configured, and its upper bound
+#define DEFAULT_COMMAND_CAPACITY 64
+#define MAX_COMMAND_CAPACITY     65536
+
+// Radar frame capacity (number of tracks) used when none is configured,
+// and the upper bound any frame or message may claim
+#define DEFAULT_RADAR_CAPACITY 4096
+#define MAX_RADAR_CAPACITY     1000000
+
+// Interval between grids ComputerSystem sends DataDisplay when none is
+// configured, and the shortest allowed (10 Hz)
+#define DEFAULT_DISPLAY_INTERVAL_MS 5000
+#define MIN_DISPLAY_INTERVAL_MS     100
 
 // Default log file paths
 #define DEFAULT_AIRSPACE_LOG_PATH "/tmp/atc/logs/airspacelog.txt"
+#define DEFAULT_AIRSPACE_HISTORY_PATH "/tmp/atc/logs/history"
 #define DEFAULT_COMMAND_LOG_PATH "/tmp/atc/logs/commandlog.txt"
 #define DEFAULT_TRANSMISSION_LOG_PATH "/tmp/atc/logs/transmissionlog.txt"
 #define DEFAULT_PLANE_INPUT_PATH "/tmp/atc/plane_input.txt"
@@ -30,6 +48,14 @@ enum CommandCode {
     CMD_POSITION = 2
 };
 
+/** Outcome of a command, reported back by Radar in its acknowledgement */
+enum CommandStatus {
+    CMD_STATUS_PENDING = 0,
+    CMD_STATUS_APPLIED = 1,
+    CMD_STATUS_UNKNOWN_AIRCRAFT = 2,
+    CMD_STATUS_UNSUPPORTED = 3
+};
+
 
 // Fixed channel IDs for subsystems
 #define OPERATOR_CONSOLE_CHANNEL_ID  1
@@ -43,6 +69,10 @@ enum CommandCode {
 #define OPERATOR_COMMAND_CHECK_TIMER        3
 #define LOG_AIRSPACE_TO_FILE_TIMER          4
 #define LOG_AIRSPACE_TO_LOGGER_TIMER        5
+#define DISPLAY_STOP_CHECK_TIMER            6
+
+/** Pulse ComputerSystem sends itself to force a violation check from its message loop **/
+#define EMERGENCY_VIOLATION_CHECK_PULSE     7
 
 // DataDisplay command types
 #define COMMAND_ONE_PLANE       6
@@ -53,6 +83,8 @@ enum CommandCode {
 // IPC command types
 #define COMMAND_OPERATOR_REQUEST 10
 #define COMMAND_EXIT_THREAD      11
+#define COMMAND_DISPLAY_SUBSCRIBE   12
+#define COMMAND_DISPLAY_UNSUBSCRIBE 13
 #define COMMAND_LOG_AIRSPACE     100
 
 // OperatorConsole commands
@@ -63,9 +95,13 @@ enum CommandCode {
 // OperatorConsole system commands
 enum OperatorConsoleSystemCommand {
     OPCON_CONSOLE_COMMAND_GET_USER_COMMAND = 1,
-    OPCON_CONSOLE_COMMAND_ALERT = 2
+    OPCON_CONSOLE_COMMAND_ALERT = 2,
+    OPCON_CONSOLE_COMMAND_ALERT_BATCH = 3
 };
 
+// Upper bound on alerts carried by one OPCON_CONSOLE_COMMAND_ALERT_BATCH message
+#define MAX_ALERTS_PER_BATCH 65536
+
 // OperatorConsole user commands
 enum OperatorConsoleUserCommand {
     OPCON_USER_COMMAND_NO_COMMAND_AVAILABLE = 0,
@@ -110,43 +146,125 @@ struct Velocity {
     time_t timestamp;
 };
 
+/**
+ * Command on its way to an aircraft. The *Ns stamps are CLOCK_MONOTONIC
+ * nanoseconds, comparable across processes on the same host, and are
+ * filled in at each hop so the acknowledgement carries the whole path.
+ */
 struct Command {
     int planeId;
     CommandCode code;
     double value[3];
     time_t timestamp;
+    uint64_t sequence;          // Assigned by ComputerSystem, echoed in the acknowledgement
+    int64_t issuedNs;           // Operator entered the command
+    int64_t transmittedNs;      // CommunicationSystem forwarded it over the uplink
+    int64_t appliedNs;          // Radar applied it to the simulated aircraft
+    int32_t status;             // CommandStatus
 };
 
-struct RadarData {
-    int numPlanes;
-    Position positions[MAX_PLANES];
-    Velocity velocities[MAX_PLANES];
+struct RadarTrack {
+    int planeId;
+    double x, y, z;
+    double vx, vy, vz;
+    time_t timestamp;
+    uint32_t velocityEpoch;     // Changes whenever the aircraft's velocity changes
+};
+
+/**
+ * Layout of /shm_radar_data: this header followed by `capacity` RadarTrack
+ * entries, of which the first `numPlanes` are valid. `sequence` is a seqlock
+ * counter: odd while Radar is writing a frame, advanced by 2 per frame.
+ */
+struct RadarFrameHeader {
+    uint32_t capacity;
+    uint32_t numPlanes;
+    std::atomic<uint64_t> sequence;
+    double timestamp;           // Simulation time of the frame, in seconds
+    int64_t publishedNs;        // CLOCK_REALTIME when Radar published it
+    uint32_t flags;             // RadarFrameFlags
+    uint32_t reserved;
+};
+
+enum RadarFrameFlags : uint32_t {
+    // Replayed from an airspace history; publishedNs is the recorded time
+    RADAR_FRAME_REPLAYED = 1
 };
 
-struct CommandQueue {
-    int head;
-    int tail;
-    Command commands[MAX_COMMANDS];
+/** Consistent copy of a radar frame header as seen by a reader */
+struct RadarFrameInfo {
+    uint32_t capacity;
+    uint32_t numPlanes;
+    uint64_t sequence;
+    double timestamp;
+    int64_t publishedNs;
+    uint32_t flags;
+};
+
+inline size_t radarFrameSize(uint32_t capacity) {
+    return sizeof(RadarFrameHeader) + (size_t)capacity * sizeof(RadarTrack);
+}
+
+inline RadarTrack* radarFrameTracks(RadarFrameHeader* header) {
+    return reinterpret_cast<RadarTrack*>(header + 1);
+}
+
+inline const RadarTrack* radarFrameTracks(const RadarFrameHeader* header) {
+    return reinterpret_cast<const RadarTrack*>(header + 1);
+}
+
+/**
+ * Layout of a command ring: this header followed by `capacity` Command
+ * slots, used as a single-producer/single-consumer ring. The producer
+ * advances `tail` and the consumer advances `head`, each publishing with a
+ * release store. `doorbell` is a process-shared semaphore posted once per
+ * command, so the consumer can sleep until there is work.
+ *
+ * Three rings carry a command end to end:
+ * - /shm_commands: ComputerSystem -> CommunicationSystem
+ * - /shm_uplink: CommunicationSystem -> Radar
+ * - /shm_command_acks: Radar -> ComputerSystem
+ */
+struct CommandRingHeader {
+    uint32_t capacity;
+    sem_t doorbell;
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
 };
 
+inline size_t commandRingSize(uint32_t capacity) {
+    return sizeof(CommandRingHeader) + (size_t)capacity * sizeof(Command);
+}
+
+inline Command* commandRingEntries(CommandRingHeader* header) {
+    return reinterpret_cast<Command*>(header + 1);
+}
+
 struct PlanePositionResponse {
     Vec3 currentPosition;
     Vec3 currentVelocity;
 };
 
+// Checkpoint request; AirspaceLogger records the tracks from the radar frames
 struct AirspaceLogMessage {
     int commandType;
     int numPlanes;
     double timestamp;
-    Position positions[MAX_PLANES];
-    Velocity velocities[MAX_PLANES];
 };
 
+// AircraftDisplayEntry::flags
+const uint32_t AIRCRAFT_IN_CONFLICT = 1;    // Predicted to lose separation
+
+struct AircraftDisplayEntry {
+    int planeId;
+    uint32_t flags;             // AIRCRAFT_* bits; fills what was padding
+    Vec3 position;
+    Vec3 velocity;
+};
+
+// Followed in the message by numberOfAircrafts AircraftDisplayEntry entries
 struct multipleAircraftDisplay {
     size_t numberOfAircrafts;
-    int planeIDArray[MAX_PLANES];      
-    Vec3 positionArray[MAX_PLANES];    
-    Vec3 velocityArray[MAX_PLANES];    
 };
 
 struct dataDisplayCommandMessage {
@@ -161,17 +279,52 @@ struct dataDisplayCommandMessage {
     } commandBody;
 };
 
+/** Region of airspace a display shows: x, y and altitude, bounds included */
+struct DisplayViewport {
+    double min[3];
+    double max[3];
+};
+
+// Displays ComputerSystem sends grids to besides the one in /shm_channels
+const size_t MAX_DISPLAY_SUBSCRIPTIONS = 16;
+// How often a display renews its subscription, so a restarted ComputerSystem learns it again
+const int DISPLAY_SUBSCRIBE_INTERVAL_MS = 2000;
+
+// COMMAND_DISPLAY_SUBSCRIBE: send the display on (pid, chid) the aircraft in
+// `viewport` from now on, replacing any viewport it had. Fails with ENOSPC
+// when MAX_DISPLAY_SUBSCRIPTIONS displays are subscribed.
+// COMMAND_DISPLAY_UNSUBSCRIBE: stop; `viewport` is ignored.
+struct DisplaySubscribeMessage {
+    int commandType;
+    int chid;
+    pid_t pid;
+    DisplayViewport viewport;
+};
+
 struct OperatorConsoleCommandMessage {
     int systemCommandType;
     int plane1, plane2;
     double collisionTimeSeconds;
 };
 
+struct ConflictAlert {
+    int plane1, plane2;
+    double collisionTimeSeconds;
+};
+
+// Followed in the message by numAlerts ConflictAlert entries
+struct OperatorConsoleAlertBatchMessage {
+    int systemCommandType;
+    uint32_t numAlerts;
+    double frameTimestamp;
+};
+
 struct OperatorConsoleResponseMessage {
     int userCommandType;
     int planeNumber;
     double newCongestionValue;
     Vec3 newVelocity;
+    int64_t issuedNs;           // CLOCK_MONOTONIC time the operator entered it
 };
 
 #endif // COMMAND_CODES_H
\ No newline at end of file
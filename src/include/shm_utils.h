@@ -6,9 +6,15 @@
 #include <unistd.h>
 #include <string>
 #include <functional>
+#include <vector>
 #include <string.h>   
 #include <errno.h>   
+#include <sched.h>
+#include <time.h>
+#include <semaphore.h>
+#include <atomic>
 #include "utils.h"
+#include "commandCodes.h"
 #include <mutex>
 
 /**
@@ -121,4 +127,414 @@ inline bool initializeChannelIdsSharedMemory(const std::string& shmName,
     );
 }
 
+/**
+ * SharedMemorySegment keeps a shared memory object open and mapped for the
+ * lifetime of the handle, so hot paths reuse one mapping instead of paying
+ * shm_open/mmap/munmap on every access. Call remap() after another process
+ * has grown the object, or resize() to grow it from this side.
+ */
+class SharedMemorySegment {
+private:
+    std::string name;
+    int fd;
+    void* ptr;
+    size_t mappedSize;
+    int prot;
+    LogFunction logFunction;
+
+    void report(const std::string& message, LogLevel level) const {
+        if (logFunction) {
+            logFunction(message, level);
+        }
+    }
+
+    bool mapCurrent(size_t size) {
+        void* p = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            report("Failed to map shared memory " + name + ": " + 
+                 std::string(strerror(errno)), LOG_ERROR);
+            return false;
+        }
+        if (ptr) {
+            munmap(ptr, mappedSize);
+        }
+        ptr = p;
+        mappedSize = size;
+        return true;
+    }
+
+public:
+    /**
+     * @param log Where open and map failures are reported: the owning
+     *            subsystem's log function, or nullptr to leave them to the caller
+     */
+    explicit SharedMemorySegment(LogFunction log = logSystemMessage)
+        : fd(-1), ptr(nullptr), mappedSize(0), prot(PROT_READ), logFunction(log) {}
+    ~SharedMemorySegment() { close(); }
+
+    SharedMemorySegment(const SharedMemorySegment&) = delete;
+    SharedMemorySegment& operator=(const SharedMemorySegment&) = delete;
+
+    /**
+     * Open and map a shared memory segment
+     * @param shmName Shared memory name
+     * @param size Size to allocate/map
+     * @param flags Open flags
+     * @param createIfMissing Whether to create shm if it doesn't exist
+     * @param maxRetries Maximum number of retry attempts
+     * @return true if successful, false otherwise
+     */
+    bool open(const std::string& shmName, size_t size, int flags,
+              bool createIfMissing, int maxRetries = 5) {
+        close();
+        ensureLogDirectories();
+
+        name = shmName;
+        prot = (flags & O_RDWR) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+
+        for (int retry = 0; retry < maxRetries; retry++) {
+            int oflags = createIfMissing ? (flags | O_CREAT) : flags;
+            fd = shm_open(name.c_str(), oflags, 0666);
+
+            if (fd == -1) {
+                report("Failed to open shared memory " + name + ": " + 
+                     std::string(strerror(errno)) + " (retry " + 
+                     std::to_string(retry + 1) + "/" + 
+                     std::to_string(maxRetries) + ")", LOG_WARNING);
+                if (retry < maxRetries - 1) {
+                    usleep(500000);
+                }
+                continue;
+            }
+
+            if ((flags & O_RDWR) && createIfMissing && ftruncate(fd, size) == -1) {
+                report("Failed to set size of shared memory " + name + 
+                     ": " + std::string(strerror(errno)), LOG_ERROR);
+                close();
+                return false;
+            }
+
+            if (mapCurrent(size)) {
+                return true;
+            }
+
+            ::close(fd);
+            fd = -1;
+            if (retry < maxRetries - 1) {
+                usleep(500000);
+            }
+        }
+
+        return false;
+    }
+
+    /** Map the segment again with a new size after it was resized elsewhere */
+    bool remap(size_t newSize) {
+        if (fd == -1) {
+            return false;
+        }
+        return mapCurrent(newSize);
+    }
+
+    /** Grow or shrink the underlying object and remap it */
+    bool resize(size_t newSize) {
+        if (fd == -1 || !(prot & PROT_WRITE)) {
+            return false;
+        }
+        if (ftruncate(fd, newSize) == -1) {
+            report("Failed to resize shared memory " + name + 
+                 ": " + std::string(strerror(errno)), LOG_ERROR);
+            return false;
+        }
+        return mapCurrent(newSize);
+    }
+
+    void close() {
+        if (ptr) {
+            munmap(ptr, mappedSize);
+            ptr = nullptr;
+        }
+        if (fd != -1) {
+            ::close(fd);
+            fd = -1;
+        }
+        mappedSize = 0;
+    }
+
+    bool isOpen() const { return ptr != nullptr; }
+    size_t size() const { return mappedSize; }
+
+    template<typename T>
+    T* as() const { return static_cast<T*>(ptr); }
+};
+
+/**
+ * Seqlock writer side for the radar frame. Radar brackets every frame update
+ * with these calls; the writer never waits for readers.
+ */
+inline void radarFrameBeginWrite(RadarFrameHeader* rh) {
+    uint64_t seq = rh->sequence.load(std::memory_order_relaxed);
+    rh->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+inline void radarFrameEndWrite(RadarFrameHeader* rh) {
+    uint64_t seq = rh->sequence.load(std::memory_order_relaxed);
+    rh->sequence.store(seq + 1, std::memory_order_release);
+}
+
+/**
+ * RadarFrameReader maps /shm_radar_data once, follows capacity changes by
+ * remapping, and copies frames under the seqlock so a reader never sees a
+ * frame that Radar was halfway through writing. It retries only when a
+ * write overlapped the copy.
+ */
+class RadarFrameReader {
+private:
+    SharedMemorySegment segment;
+    LogFunction logFunction;
+    std::mutex readerMutex;
+
+    bool ensureMapped(uint32_t capacity) {
+        if (capacity == 0 || capacity > MAX_RADAR_CAPACITY) {
+            return false;
+        }
+        size_t needed = radarFrameSize(capacity);
+        if (needed > segment.size()) {
+            return segment.remap(needed);
+        }
+        return true;
+    }
+
+    bool ensureOpen() {
+        return segment.isOpen() ||
+               segment.open(SHM_RADAR_DATA, sizeof(RadarFrameHeader), O_RDONLY, false);
+    }
+
+public:
+    /** @param log The reading subsystem's log function, or nullptr to report nothing */
+    explicit RadarFrameReader(LogFunction log = logSystemMessage) : segment(log), logFunction(log) {}
+
+    /**
+     * Sequence number of the latest complete frame, without copying it.
+     * Readers compare it with the sequence of their last read to skip work.
+     * @param sequence Receives the current frame sequence
+     * @return true if successful, false otherwise
+     */
+    bool peekSequence(uint64_t& sequence) {
+        std::lock_guard<std::mutex> lock(readerMutex);
+
+        if (!ensureOpen()) {
+            return false;
+        }
+        uint64_t seq = segment.as<RadarFrameHeader>()->sequence.load(std::memory_order_acquire);
+        sequence = seq & ~(uint64_t)1;
+        return true;
+    }
+
+    /**
+     * Read a consistent copy of the current frame header only, for callers
+     * that need the plane count or timestamp but not the tracks.
+     * @param info Receives the frame header, including its sequence
+     * @param maxRetries Maximum number of attempts while Radar keeps writing
+     * @return true if successful, false otherwise
+     */
+    bool readInfo(RadarFrameInfo& info, int maxRetries = 1000) {
+        std::lock_guard<std::mutex> lock(readerMutex);
+
+        if (!ensureOpen()) {
+            return false;
+        }
+
+        const RadarFrameHeader* rh = segment.as<RadarFrameHeader>();
+        for (int attempt = 0; attempt < maxRetries; attempt++) {
+            uint64_t before = rh->sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                sched_yield();
+                continue;
+            }
+
+            RadarFrameInfo copy;
+            copy.capacity = rh->capacity;
+            copy.numPlanes = rh->numPlanes;
+            copy.sequence = before;
+            copy.timestamp = rh->timestamp;
+            copy.publishedNs = rh->publishedNs;
+            copy.flags = rh->flags;
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (rh->sequence.load(std::memory_order_relaxed) != before) {
+                continue;
+            }
+            if (copy.numPlanes > copy.capacity) {
+                return false;
+            }
+            info = copy;
+            return true;
+        }
+
+        if (logFunction) {
+            logFunction("Gave up reading radar frame header after " +
+                        std::to_string(maxRetries) + " concurrent writes", LOG_WARNING);
+        }
+        return false;
+    }
+
+    /**
+     * Read a consistent copy of the current radar frame.
+     * @param tracks Receives the valid tracks of the frame
+     * @param info Optional copy of the frame header, including its sequence
+     * @param maxRetries Maximum number of attempts while Radar keeps writing
+     * @return true if successful, false otherwise
+     */
+    bool read(std::vector<RadarTrack>& tracks, RadarFrameInfo* info = nullptr,
+              int maxRetries = 1000) {
+        std::lock_guard<std::mutex> lock(readerMutex);
+
+        if (!ensureOpen()) {
+            return false;
+        }
+
+        for (int attempt = 0; attempt < maxRetries; attempt++) {
+            const RadarFrameHeader* rh = segment.as<RadarFrameHeader>();
+
+            uint64_t before = rh->sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                sched_yield();
+                continue;
+            }
+
+            uint32_t capacity = rh->capacity;
+            uint32_t numPlanes = rh->numPlanes;
+            double timestamp = rh->timestamp;
+            int64_t publishedNs = rh->publishedNs;
+            uint32_t flags = rh->flags;
+
+            if (numPlanes > capacity || !ensureMapped(capacity)) {
+                // Torn header or a capacity we cannot map; validate and retry
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (rh->sequence.load(std::memory_order_relaxed) == before) {
+                    return false;
+                }
+                continue;
+            }
+
+            // ensureMapped may have moved the mapping
+            rh = segment.as<RadarFrameHeader>();
+            tracks.resize(numPlanes);
+            if (numPlanes > 0) {
+                memcpy(tracks.data(), radarFrameTracks(rh), numPlanes * sizeof(RadarTrack));
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t after = rh->sequence.load(std::memory_order_relaxed);
+            if (after != before) {
+                continue;
+            }
+
+            if (info) {
+                info->capacity = capacity;
+                info->numPlanes = numPlanes;
+                info->sequence = before;
+                info->timestamp = timestamp;
+                info->publishedNs = publishedNs;
+                info->flags = flags;
+            }
+            return true;
+        }
+
+        if (logFunction) {
+            logFunction("Gave up reading radar frame after " + 
+                        std::to_string(maxRetries) + " concurrent writes", LOG_WARNING);
+        }
+        return false;
+    }
+};
+
+/**
+ * Map a command ring at its full size. ATCController sizes the ring, so the
+ * header is mapped first to learn the capacity.
+ * @param segment Segment to open; left open on success
+ * @param name SHM_COMMANDS, SHM_UPLINK or SHM_COMMAND_ACKS
+ * @return the ring header, or nullptr if it is missing or malformed
+ */
+inline CommandRingHeader* openCommandRing(SharedMemorySegment& segment, const char* name) {
+    if (!segment.isOpen() &&
+        !segment.open(name, sizeof(CommandRingHeader), O_RDWR, false, 1)) {
+        return nullptr;
+    }
+
+    uint32_t capacity = segment.as<CommandRingHeader>()->capacity;
+    if (capacity == 0 || capacity > MAX_COMMAND_CAPACITY) {
+        segment.close();
+        return nullptr;
+    }
+    if (segment.size() < commandRingSize(capacity) &&
+        !segment.remap(commandRingSize(capacity))) {
+        segment.close();
+        return nullptr;
+    }
+    return segment.as<CommandRingHeader>();
+}
+
+/**
+ * Producer side of a command ring; one process pushes per ring.
+ * @return false if the ring is full
+ */
+inline bool commandRingPush(CommandRingHeader* ring, const Command& cmd) {
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    if (tail - head >= ring->capacity) {
+        return false;
+    }
+    commandRingEntries(ring)[tail % ring->capacity] = cmd;
+    ring->tail.store(tail + 1, std::memory_order_release);
+    sem_post(&ring->doorbell);
+    return true;
+}
+
+/** Pop the next command once the caller has consumed its doorbell post */
+inline bool commandRingTake(CommandRingHeader* ring, Command& cmd) {
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    uint64_t tail = ring->tail.load(std::memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+    cmd = commandRingEntries(ring)[head % ring->capacity];
+    ring->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * Consumer side of a command ring; one process pops per ring.
+ * Sleeps on the doorbell until a command arrives or timeoutMs elapses.
+ * @return true if cmd holds the next command
+ */
+inline bool commandRingPop(CommandRingHeader* ring, Command& cmd, int timeoutMs) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += (long)(timeoutMs % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    // One post per published command, so a successful wait means one is ready
+    while (sem_timedwait(&ring->doorbell, &deadline) == -1) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return commandRingTake(ring, cmd);
+}
+
+/** Non-blocking pop for consumers that drain the ring on their own tick */
+inline bool commandRingTryPop(CommandRingHeader* ring, Command& cmd) {
+    if (sem_trywait(&ring->doorbell) == -1) {
+        return false;
+    }
+    return commandRingTake(ring, cmd);
+}
+
 #endif // SHM_UTILS_H
\ No newline at end of file
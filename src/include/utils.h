@@ -2,12 +2,14 @@
 #define UTILS_H
 
 #include <string>
+#include <cstdint>
 #include <time.h>
 #include <iostream>
 #include <fstream>
 #include <mutex>
 #include <cstdio>
 #include <sys/stat.h>
+#include "AsyncLog.h"
 
 /** Airspace boundaries **/
 const double AIRSPACE_X_MIN = 0.0;
@@ -17,22 +19,6 @@ const double AIRSPACE_Y_MAX = 100000.0;
 const double AIRSPACE_Z_MIN = 0.0;
 const double AIRSPACE_Z_MAX = 25000.0;
 
-/** Log levels for finer-grained control **/
-enum LogLevel {
-    LOG_DEBUG,    // Detailed debugging information
-    LOG_INFO,     // General informational messages
-    LOG_WARNING,  // Warning conditions
-    LOG_ERROR     // Error conditions
-};
-
-// Global log level setting
-static LogLevel currentLogLevel = LOG_INFO;
-
-/** Set global log level **/
-static inline void setLogLevel(LogLevel level) {
-    currentLogLevel = level;
-}
-
 static inline std::string boolToString(bool value) {
     return value ? "true" : "false";
 }
@@ -45,11 +31,25 @@ static inline bool isPositionWithinBounds(double x, double y, double z) {
 
 static inline std::string printTimeStamp() {
     time_t now = time(nullptr);
-    char buf[20];
+    char buf[32];
     strftime(buf, sizeof(buf), "[%Y-%m-%d %H:%M:%S]", localtime(&now));
     return std::string(buf);
 }
 
+/** CLOCK_MONOTONIC in nanoseconds; comparable between processes on one host */
+static inline int64_t monotonicNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/** CLOCK_REALTIME in nanoseconds since the epoch, for records kept across runs */
+static inline int64_t realtimeNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
 static inline void ensureLogDirectories() {
     static std::once_flag dirFlag;
     std::call_once(dirFlag, []() {
@@ -58,73 +58,130 @@ static inline void ensureLogDirectories() {
     });
 }
 
-static inline void logMessage(const std::string& subsystem, 
+/** Log files, registered with the writer on first use **/
+static inline int radarLogFile() {
+    static const int file = asyncLogOpen("/tmp/atc/logs/radar.log");
+    return file;
+}
+
+static inline int computerSystemLogFile() {
+    static const int file = asyncLogOpen("/tmp/atc/logs/computer_system.log");
+    return file;
+}
+
+static inline int operatorConsoleLogFile() {
+    static const int file = asyncLogOpen("/tmp/atc/logs/operator_console.log");
+    return file;
+}
+
+static inline int dataDisplayLogFile() {
+    static const int file = asyncLogOpen("/tmp/atc/logs/data_display.log");
+    return file;
+}
+
+static inline int airspaceLoggerLogFile() {
+    static const int file = asyncLogOpen("/tmp/atc/logs/airspace_logger.log");
+    return file;
+}
+
+static inline int communicationSystemLogFile() {
+    static const int file = asyncLogOpen("/tmp/atc/logs/communication_system.log");
+    return file;
+}
+
+static inline int planeLogFile() {
+    static const int file = asyncLogOpen("/tmp/atc/logs/plane.log");
+    return file;
+}
+
+static inline int systemLogFile() {
+    static const int file = asyncLogOpen("/tmp/atc/logs/system.log");
+    return file;
+}
+
+/** "Plane-<id>", formatted on the stack for the plane log */
+struct PlaneSubsystem {
+    char name[24];
+    explicit PlaneSubsystem(int planeId) {
+        snprintf(name, sizeof(name), "Plane-%d", planeId);
+    }
+};
+
+/**
+ * Queue a preformatted log line for the asynchronous writer (see
+ * AsyncLog.h). Callers build the message first, so prefer the LOG_*
+ * macros below on hot paths and for LOG_DEBUG.
+ */
+static inline void logMessage(const char* subsystem,
                             const std::string& message,
-                            const std::string& logPath, 
+                            int logFile,
                             LogLevel level = LOG_INFO) {
-    if (level < currentLogLevel) return;
-    
-    static std::mutex logMutex;
-    std::lock_guard<std::mutex> lock(logMutex);
-    
-    std::string levelStr;
-    switch (level) {
-        case LOG_DEBUG:   levelStr = "DEBUG"; break;
-        case LOG_INFO:    levelStr = "INFO"; break;
-        case LOG_WARNING: levelStr = "WARNING"; break;
-        case LOG_ERROR:   levelStr = "ERROR"; break;
-    }
-    
-    std::string timestampedMsg = printTimeStamp() + " [" + subsystem + "] [" + levelStr + "] " + message;
-    
-    if (level >= LOG_WARNING) {
-        std::cerr << timestampedMsg << std::endl;
-    } else {
-        std::cout << timestampedMsg << std::endl;
-    }
-    
-    ensureLogDirectories();
-    
-    FILE* fp = fopen(logPath.c_str(), "a");
-    if (fp) {
-        fprintf(fp, "%s\n", timestampedMsg.c_str());
-        fclose(fp);
-    } else {
-        std::cerr << "Failed to open log file: " << logPath << std::endl;
-    }
+    if (!LOG_LEVEL_ENABLED(level)) return;
+    asyncLogWrite(logFile, level, subsystem, message.data(), message.size());
 }
 
+/**
+ * A subsystem's logging function, for shared code that reports on behalf of
+ * the process using it (SharedMemorySegment, ConnectionCache)
+ */
+typedef void (*LogFunction)(const std::string& message, LogLevel level);
+
 /** Subsystem-specific logging functions **/
 static inline void logRadarMessage(const std::string& message, LogLevel level = LOG_INFO) {
-    logMessage("Radar", message, "/tmp/atc/logs/radar.log", level);
+    logMessage("Radar", message, radarLogFile(), level);
 }
 
 static inline void logComputerSystemMessage(const std::string& message, LogLevel level = LOG_INFO) {
-    logMessage("ComputerSystem", message, "/tmp/atc/logs/computer_system.log", level);
+    logMessage("ComputerSystem", message, computerSystemLogFile(), level);
 }
 
 static inline void logOperatorConsoleMessage(const std::string& message, LogLevel level = LOG_INFO) {
-    logMessage("OperatorConsole", message, "/tmp/atc/logs/operator_console.log", level);
+    logMessage("OperatorConsole", message, operatorConsoleLogFile(), level);
 }
 
 static inline void logDataDisplayMessage(const std::string& message, LogLevel level = LOG_INFO) {
-    logMessage("DataDisplay", message, "/tmp/atc/logs/data_display.log", level);
+    logMessage("DataDisplay", message, dataDisplayLogFile(), level);
 }
 
 static inline void logAirspaceLoggerMessage(const std::string& message, LogLevel level = LOG_INFO) {
-    logMessage("AirspaceLogger", message, "/tmp/atc/logs/airspace_logger.log", level);
+    logMessage("AirspaceLogger", message, airspaceLoggerLogFile(), level);
 }
 
 static inline void logCommunicationSystemMessage(const std::string& message, LogLevel level = LOG_INFO) {
-    logMessage("CommunicationSystem", message, "/tmp/atc/logs/communication_system.log", level);
+    logMessage("CommunicationSystem", message, communicationSystemLogFile(), level);
 }
 
 static inline void logPlaneMessage(int planeId, const std::string& message, LogLevel level = LOG_INFO) {
-    logMessage("Plane-" + std::to_string(planeId), message, "/tmp/atc/logs/plane.log", level);
+    logMessage(PlaneSubsystem(planeId).name, message, planeLogFile(), level);
 }
 
 static inline void logSystemMessage(const std::string& message, LogLevel level = LOG_INFO) {
-    logMessage("ATCController", message, "/tmp/atc/logs/system.log", level);
+    logMessage("ATCController", message, systemLogFile(), level);
 }
 
+/**
+ * Lazy logging: the arguments after level are concatenated into the log
+ * line, and are not evaluated at all unless the level is enabled. Levels
+ * below ATC_LOG_MIN_LEVEL compile to nothing.
+ *
+ *     LOG_RADAR(LOG_DEBUG, "Updating radar data with ", n, " planes");
+ */
+#define ATC_LOG(subsystem, file, level, ...) \
+    do { \
+        if (LOG_LEVEL_ENABLED(level)) { \
+            logFormat(subsystem, file, level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_RADAR(level, ...)           ATC_LOG("Radar", radarLogFile(), level, __VA_ARGS__)
+#define LOG_COMPUTER_SYSTEM(level, ...) ATC_LOG("ComputerSystem", computerSystemLogFile(), level, __VA_ARGS__)
+#define LOG_OPERATOR_CONSOLE(level, ...) ATC_LOG("OperatorConsole", operatorConsoleLogFile(), level, __VA_ARGS__)
+#define LOG_DATA_DISPLAY(level, ...)    ATC_LOG("DataDisplay", dataDisplayLogFile(), level, __VA_ARGS__)
+#define LOG_AIRSPACE_LOGGER(level, ...) ATC_LOG("AirspaceLogger", airspaceLoggerLogFile(), level, __VA_ARGS__)
+#define LOG_COMMUNICATION_SYSTEM(level, ...) \
+    ATC_LOG("CommunicationSystem", communicationSystemLogFile(), level, __VA_ARGS__)
+#define LOG_PLANE(planeId, level, ...) \
+    ATC_LOG(PlaneSubsystem(planeId).name, planeLogFile(), level, __VA_ARGS__)
+#define LOG_SYSTEM(level, ...)          ATC_LOG("ATCController", systemLogFile(), level, __VA_ARGS__)
+
 #endif // UTILS_H
\ No newline at end of file
@@ -9,8 +9,15 @@
 #include <mutex>
 #include <fstream>
 #include <sys/wait.h>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
 #include "commandCodes.h"
 #include "utils.h"
+#include "EventLog.h"
+#include "AirspaceHistory.h"
 #include "shm_utils.h"
 
 static volatile sig_atomic_t running = 1;
@@ -29,64 +36,42 @@ static void handleSig(int sig) {
 void monitorSystemStatus() {
     logSystemMessage("System monitoring thread started");
     
+    SharedMemorySegment syncSegment;
+    SharedMemorySegment channelsSegment;
+    
     while (running) {
-        bool syncSuccess = accessSharedMemory<int>(
-            SHM_SYNC_READY,
-            sizeof(int),
-            O_RDONLY,
-            false,
-            [](int* syncReady) {
-                if (*syncReady == 0) {
-                    logSystemMessage("WARNING: Shared memory sync flag reset to 0!", LOG_WARNING);
-                    
-                    bool restoreSuccess = accessSharedMemory<int>(
-                        SHM_SYNC_READY,
-                        sizeof(int),
-                        O_RDWR,
-                        false,
-                        [](int* writeSync) {
-                            *writeSync = 1;
-                        }
-                    );
-                    
-                    if (!restoreSuccess) {
-                        logSystemMessage("Failed to restore sync flag", LOG_ERROR);
-                    }
-                }
+        if (syncSegment.isOpen() ||
+            syncSegment.open(SHM_SYNC_READY, sizeof(int), O_RDWR, false)) {
+            int* syncReady = syncSegment.as<int>();
+            if (*syncReady == 0) {
+                logSystemMessage("WARNING: Shared memory sync flag reset to 0!", LOG_WARNING);
+                *syncReady = 1;
             }
-        );
-        
-        if (!syncSuccess) {
+        } else {
             logSystemMessage("Failed to check sync flag", LOG_WARNING);
         }
         
         // Check channel IDs to ensure all subsystems are still registered
-        bool channelsSuccess = accessSharedMemory<ChannelIds>(
-            SHM_CHANNELS,
-            sizeof(ChannelIds),
-            O_RDONLY,
-            false,
-            [](ChannelIds* channels) {
-                if (channels->operatorChid <= 0 || channels->operatorPid <= 0 || 
-                    channels->displayChid <= 0 || channels->displayPid <= 0 || 
-                    channels->loggerChid <= 0 || channels->loggerPid <= 0 || 
-                    channels->computerChid <= 0 || channels->computerPid <= 0) {
-                    
-                    logSystemMessage("WARNING: One or more subsystem channel IDs or PIDs are missing or invalid!", LOG_WARNING);
-                    
-                    if (channels->operatorChid <= 0 || channels->operatorPid <= 0) 
-                        logSystemMessage("OperatorConsole channel ID or PID missing", LOG_WARNING);
-                    if (channels->displayChid <= 0 || channels->displayPid <= 0) 
-                        logSystemMessage("DataDisplay channel ID or PID missing", LOG_WARNING);
-                    if (channels->loggerChid <= 0 || channels->loggerPid <= 0) 
-                        logSystemMessage("AirspaceLogger channel ID or PID missing", LOG_WARNING);
-                    if (channels->computerChid <= 0 || channels->computerPid <= 0) 
-                        logSystemMessage("ComputerSystem channel ID or PID missing", LOG_WARNING);
-                }
+        if (channelsSegment.isOpen() ||
+            channelsSegment.open(SHM_CHANNELS, sizeof(ChannelIds), O_RDONLY, false)) {
+            const ChannelIds* channels = channelsSegment.as<ChannelIds>();
+            if (channels->operatorChid <= 0 || channels->operatorPid <= 0 || 
+                channels->displayChid <= 0 || channels->displayPid <= 0 || 
+                channels->loggerChid <= 0 || channels->loggerPid <= 0 || 
+                channels->computerChid <= 0 || channels->computerPid <= 0) {
+                
+                logSystemMessage("WARNING: One or more subsystem channel IDs or PIDs are missing or invalid!", LOG_WARNING);
+                
+                if (channels->operatorChid <= 0 || channels->operatorPid <= 0) 
+                    logSystemMessage("OperatorConsole channel ID or PID missing", LOG_WARNING);
+                if (channels->displayChid <= 0 || channels->displayPid <= 0) 
+                    logSystemMessage("DataDisplay channel ID or PID missing", LOG_WARNING);
+                if (channels->loggerChid <= 0 || channels->loggerPid <= 0) 
+                    logSystemMessage("AirspaceLogger channel ID or PID missing", LOG_WARNING);
+                if (channels->computerChid <= 0 || channels->computerPid <= 0) 
+                    logSystemMessage("ComputerSystem channel ID or PID missing", LOG_WARNING);
             }
-        );
-        
-        if (!channelsSuccess) {
+        } else {
             logSystemMessage("Failed to check channel IDs", LOG_WARNING);
         }
         
@@ -96,7 +81,30 @@ void monitorSystemStatus() {
     logSystemMessage("System monitoring thread terminated");
 }
 
-bool initializeSystemComponents() {
+static bool createCommandRing(const char* name, uint32_t capacity) {
+    return accessSharedMemory<CommandRingHeader>(
+        name,
+        commandRingSize(capacity),
+        O_CREAT | O_RDWR,
+        true,
+        [capacity](CommandRingHeader* ring) {
+            ring->capacity = capacity;
+            ring->head = 0;
+            ring->tail = 0;
+            if (sem_init(&ring->doorbell, 1, 0) == -1) {
+                throw std::runtime_error("sem_init failed: " + std::string(strerror(errno)));
+            }
+            memset(commandRingEntries(ring), 0, (size_t)capacity * sizeof(Command));
+            Command* commands = commandRingEntries(ring);
+            for (uint32_t i = 0; i < capacity; i++) {
+                commands[i].planeId = -1;
+                commands[i].code = CMD_POSITION;
+            }
+        }
+    );
+}
+
+bool initializeSystemComponents(uint32_t radarCapacity, uint32_t commandCapacity) {
     mkdir("/tmp/atc", 0777);
     mkdir("/tmp/atc/logs", 0777);
 
@@ -115,27 +123,20 @@ bool initializeSystemComponents() {
         return false;
     }
 
-    // Create radar data shared memory
-    bool radarSuccess = accessSharedMemory<RadarData>(
+    // Create radar data shared memory sized for the configured capacity
+    bool radarSuccess = accessSharedMemory<RadarFrameHeader>(
         SHM_RADAR_DATA,
-        sizeof(RadarData),
+        radarFrameSize(radarCapacity),
         O_CREAT | O_RDWR,
         true,
-        [](RadarData* rd) {
-            rd->numPlanes = 0;
-            for (int i = 0; i < MAX_PLANES; i++) {
-                rd->positions[i].planeId = -1;
-                rd->positions[i].x = 0;
-                rd->positions[i].y = 0;
-                rd->positions[i].z = 0;
-                rd->positions[i].timestamp = 0;
-                
-                rd->velocities[i].planeId = -1;
-                rd->velocities[i].vx = 0;
-                rd->velocities[i].vy = 0;
-                rd->velocities[i].vz = 0;
-                rd->velocities[i].timestamp = 0;
-            }
+        [radarCapacity](RadarFrameHeader* rh) {
+            rh->capacity = radarCapacity;
+            rh->numPlanes = 0;
+            rh->sequence = 0;
+            rh->timestamp = 0;
+            rh->publishedNs = 0;
+            rh->flags = 0;
+            memset(radarFrameTracks(rh), 0, (size_t)radarCapacity * sizeof(RadarTrack));
         }
     );
     
@@ -144,30 +145,22 @@ bool initializeSystemComponents() {
         return false;
     }
 
-    bool cmdSuccess = accessSharedMemory<CommandQueue>(
-        SHM_COMMANDS,
-        sizeof(CommandQueue),
-        O_CREAT | O_RDWR,
-        true,
-        [](CommandQueue* cq) {
-            cq->head = 0;
-            cq->tail = 0;
-            for (int i = 0; i < MAX_COMMANDS; i++) {
-                cq->commands[i].planeId = -1;
-                cq->commands[i].code = CMD_POSITION;
-                cq->commands[i].value[0] = 0;
-                cq->commands[i].value[1] = 0;
-                cq->commands[i].value[2] = 0;
-                cq->commands[i].timestamp = 0;
-            }
+    logSystemMessage("Radar frame created with capacity for " + 
+                   std::to_string(radarCapacity) + " tracks");
+
+    // Commands travel ComputerSystem -> CommunicationSystem -> Radar and are
+    // acknowledged back to ComputerSystem, one ring per hop
+    const char* commandRings[] = { SHM_COMMANDS, SHM_UPLINK, SHM_COMMAND_ACKS };
+    for (const char* name : commandRings) {
+        if (!createCommandRing(name, commandCapacity)) {
+            logSystemMessage(std::string("Failed to create command ring ") + name, LOG_ERROR);
+            return false;
         }
-    );
-    
-    if (!cmdSuccess) {
-        logSystemMessage("Failed to create commands shared memory", LOG_ERROR);
-        return false;
     }
 
+    logSystemMessage("Command rings created with capacity for " + 
+                   std::to_string(commandCapacity) + " commands");
+
     // Create channels shared memory for inter-process communication
     bool channelsSuccess = accessSharedMemory<ChannelIds>(
         SHM_CHANNELS,
@@ -200,7 +193,112 @@ int main(int argc, char* argv[]) {
     
     logSystemMessage("Air Traffic Control System starting");
 
-    if (!initializeSystemComponents()) {
+    uint32_t radarCapacity = DEFAULT_RADAR_CAPACITY;
+    uint32_t commandCapacity = DEFAULT_COMMAND_CAPACITY;
+    std::string eventLogPath;
+    uint64_t eventLogRecords = EVENT_LOG_DEFAULT_RECORDS;
+    // Radar replays a recorded history instead of simulating when --replay is given
+    std::vector<std::string> radarArgs = { "Radar" };
+    // DataDisplay grid options, passed on without the --display prefix
+    std::vector<std::string> displayArgs = { "DataDisplay" };
+    std::vector<std::string> computerArgs = { "ComputerSystem" };
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--radar-capacity") == 0 && i + 1 < argc) {
+            char* end;
+            long requested = strtol(argv[++i], &end, 10);
+            if (end != argv[i] && *end == '\0' && requested > 0 && requested <= MAX_RADAR_CAPACITY) {
+                radarCapacity = (uint32_t)requested;
+            } else {
+                logSystemMessage("Ignoring invalid radar capacity " + std::string(argv[i]) + 
+                               ", using " + std::to_string(radarCapacity), LOG_WARNING);
+            }
+        } else if (strcmp(argv[i], "--command-capacity") == 0 && i + 1 < argc) {
+            char* end;
+            long requested = strtol(argv[++i], &end, 10);
+            if (end != argv[i] && *end == '\0' && requested > 0 && requested <= MAX_COMMAND_CAPACITY) {
+                commandCapacity = (uint32_t)requested;
+            } else {
+                logSystemMessage("Ignoring invalid command capacity " + std::string(argv[i]) + 
+                               ", using " + std::to_string(commandCapacity), LOG_WARNING);
+            }
+        } else if (strcmp(argv[i], "--event-log") == 0 && i + 1 < argc) {
+            eventLogPath = argv[++i];
+        } else if (strcmp(argv[i], "--event-log-records") == 0 && i + 1 < argc) {
+            char* end;
+            long long requested = strtoll(argv[++i], &end, 10);
+            if (end != argv[i] && *end == '\0' && requested > 0 &&
+                (unsigned long long)requested <= MAX_EVENT_LOG_RECORDS) {
+                eventLogRecords = (uint64_t)requested;
+            } else {
+                logSystemMessage("Ignoring invalid event log size " + std::string(argv[i]) + 
+                               ", using " + std::to_string(eventLogRecords), LOG_WARNING);
+            }
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            radarArgs.insert(radarArgs.end(), { "--replay", argv[++i] });
+        } else if (strcmp(argv[i], "--replay-speed") == 0 && i + 1 < argc) {
+            char* end;
+            double speed = strtod(argv[++i], &end);
+            if (*end == '\0' && speed >= 0) {
+                radarArgs.insert(radarArgs.end(), { "--speed", argv[i] });
+            } else {
+                logSystemMessage("Ignoring invalid replay speed " + std::string(argv[i]) +
+                               ", replaying in real time", LOG_WARNING);
+            }
+        } else if ((strcmp(argv[i], "--replay-from") == 0 || strcmp(argv[i], "--replay-to") == 0) &&
+                   i + 1 < argc) {
+            int64_t ns;
+            const char* option = (strcmp(argv[i], "--replay-from") == 0) ? "--from" : "--to";
+            if (parseHistoryTime(argv[++i], ns)) {
+                radarArgs.insert(radarArgs.end(), { option, argv[i] });
+            } else {
+                logSystemMessage("Ignoring invalid replay time " + std::string(argv[i]), LOG_WARNING);
+            }
+        } else if (strcmp(argv[i], "--display-grid") == 0 || strcmp(argv[i], "--display-center") == 0 ||
+                   strcmp(argv[i], "--display-cell-size") == 0 || strcmp(argv[i], "--display-zoom") == 0 ||
+                   strcmp(argv[i], "--display-cell-width") == 0 || strcmp(argv[i], "--display-live") == 0 ||
+                   strcmp(argv[i], "--display-detail") == 0 || strcmp(argv[i], "--display-density-above") == 0 ||
+                   strcmp(argv[i], "--display-bands") == 0 || strcmp(argv[i], "--display-profile") == 0 ||
+                   strcmp(argv[i], "--display-altitude-floor") == 0) {
+            int values = (strcmp(argv[i], "--display-grid") == 0 || strcmp(argv[i], "--display-center") == 0 ||
+                          strcmp(argv[i], "--display-bands") == 0 || strcmp(argv[i], "--display-profile") == 0) ? 2 : 1;
+            if (i + values < argc) {
+                displayArgs.push_back("--" + std::string(argv[i] + strlen("--display-")));
+                for (int k = 0; k < values; k++) {
+                    displayArgs.push_back(argv[++i]);
+                }
+            }
+        } else if (strcmp(argv[i], "--display-rate") == 0 && i + 1 < argc) {
+            // Grids are pushed by ComputerSystem, so it takes the rate
+            char* end;
+            double hz = strtod(argv[++i], &end);
+            if (*end == '\0' && hz > 0 && hz * MIN_DISPLAY_INTERVAL_MS <= 1000.0) {
+                computerArgs.insert(computerArgs.end(), { "--display-rate", argv[i] });
+            } else {
+                logSystemMessage("Ignoring invalid display rate " + std::string(argv[i]) + ", at most " +
+                               std::to_string(1000 / MIN_DISPLAY_INTERVAL_MS) + " Hz", LOG_WARNING);
+            }
+        }
+    }
+    bool replaying = std::find(radarArgs.begin(), radarArgs.end(), "--replay") != radarArgs.end();
+    if (!replaying && radarArgs.size() > 1) {
+        logSystemMessage("Replay options given without --replay, ignoring them", LOG_WARNING);
+        radarArgs.resize(1);
+    }
+
+    // Subsystems inherit the event log path through the environment
+    unsetenv(EVENT_LOG_ENV);
+    if (!eventLogPath.empty()) {
+        if (eventLogCreate(eventLogPath.c_str(), eventLogRecords) && eventLogOpen(eventLogPath.c_str())) {
+            setenv(EVENT_LOG_ENV, eventLogPath.c_str(), 1);
+            logSystemMessage("Binary event log " + eventLogPath + " created with room for " +
+                           std::to_string(eventLogRecords) + " events");
+        } else {
+            logSystemMessage("Failed to create binary event log " + eventLogPath +
+                           ", continuing without it", LOG_ERROR);
+        }
+    }
+
+    if (!initializeSystemComponents(radarCapacity, commandCapacity)) {
         logSystemMessage("Failed to initialize system components", LOG_ERROR);
         return 1;
     }
@@ -224,7 +322,12 @@ int main(int argc, char* argv[]) {
     // Start DataDisplay next (ID 2)
     pids[2] = fork();
     if (pids[2] == 0) {
-        execl((basePath+"/DataDisplay").c_str(), "DataDisplay", (char*)nullptr);
+        std::vector<char*> args;
+        for (std::string& arg : displayArgs) {
+            args.push_back(&arg[0]);
+        }
+        args.push_back(nullptr);
+        execv((basePath+"/DataDisplay").c_str(), args.data());
         logSystemMessage("Failed to exec DataDisplay: " + std::string(strerror(errno)), LOG_ERROR);
         _exit(1);
     }
@@ -244,7 +347,12 @@ int main(int argc, char* argv[]) {
     // Start ComputerSystem next (ID 4)
     pids[1] = fork();
     if (pids[1] == 0) {
-        execl((basePath+"/ComputerSystem").c_str(), "ComputerSystem", (char*)nullptr);
+        std::vector<char*> args;
+        for (std::string& arg : computerArgs) {
+            args.push_back(&arg[0]);
+        }
+        args.push_back(nullptr);
+        execv((basePath+"/ComputerSystem").c_str(), args.data());
         logSystemMessage("Failed to exec ComputerSystem: " + std::string(strerror(errno)), LOG_ERROR);
         _exit(1);
     }
@@ -254,7 +362,12 @@ int main(int argc, char* argv[]) {
     // Start other components that don't need specific IDs
     pids[0] = fork();    
     if (pids[0] == 0) {
-        execl((basePath+"/Radar").c_str(), "Radar", (char*)nullptr);
+        std::vector<char*> args;
+        for (std::string& arg : radarArgs) {
+            args.push_back(&arg[0]);
+        }
+        args.push_back(nullptr);
+        execv((basePath+"/Radar").c_str(), args.data());
         logSystemMessage("Failed to exec Radar: " + std::string(strerror(errno)), LOG_ERROR);
         _exit(1);
     }
@@ -347,6 +460,8 @@ int main(int argc, char* argv[]) {
     
     shm_unlink(SHM_RADAR_DATA);
     shm_unlink(SHM_COMMANDS);
+    shm_unlink(SHM_UPLINK);
+    shm_unlink(SHM_COMMAND_ACKS);
     shm_unlink(SHM_CHANNELS);
     shm_unlink(SHM_SYNC_READY);
 
@@ -31,7 +31,7 @@ int main() {
     }
     
     logCommunicationSystemMessage("Shutdown signal received", LOG_WARNING);
-    
+    comm.stop();
     
     if (commThread.joinable()) {
         commThread.join();
@@ -1,6 +1,10 @@
 #include "ComputerSystem.h"
 #include "utils.h"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <signal.h>
 #include <thread>
 #include <unistd.h> 
@@ -8,13 +12,38 @@
 static volatile sig_atomic_t running = 1;
 static void handleSig(int) { running = 0; }
 
-int main() {
+static void usage() {
+    std::cerr << "Usage: ComputerSystem [--display-rate HZ]" << std::endl
+              << "  HZ: grids sent to DataDisplay per second, at most "
+              << 1000 / MIN_DISPLAY_INTERVAL_MS << " (default one every "
+              << DEFAULT_DISPLAY_INTERVAL_MS / 1000 << " s)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
     signal(SIGINT, handleSig);
     signal(SIGTERM, handleSig);
     
+    int displayIntervalMs = DEFAULT_DISPLAY_INTERVAL_MS;
+    for (int i = 1; i < argc; i++) {
+        bool valid = false;
+        if (strcmp(argv[i], "--display-rate") == 0 && i + 1 < argc) {
+            char* end;
+            double hz = strtod(argv[++i], &end);
+            valid = *end == '\0' && hz > 0 && hz * MIN_DISPLAY_INTERVAL_MS <= 1000.0;
+            if (valid) {
+                displayIntervalMs = std::max(MIN_DISPLAY_INTERVAL_MS, (int)std::lround(1000.0 / hz));
+            }
+        }
+        if (!valid) {
+            usage();
+            return 2;
+        }
+    }
+    
     logComputerSystemMessage("Subsystem starting");
     
     ComputerSystem cs;
+    cs.setDisplayInterval(displayIntervalMs);
     
     std::thread csThread([&cs]() {
         try {
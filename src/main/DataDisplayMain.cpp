@@ -1,6 +1,8 @@
 #include "DataDisplay.h"
 #include "utils.h"
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
 #include <signal.h>
 #include <thread>
 #include <unistd.h>
@@ -8,13 +10,115 @@
 static volatile sig_atomic_t running = 1;
 static void handleSig(int) { running = 0; }
 
-int main() {
+static void usage() {
+    std::cerr << "Usage: DataDisplay [--grid COLUMNS ROWS] [--cell-size M] [--zoom Z] [--center X Y]" << std::endl
+              << "                   [--cell-width CHARS] [--detail auto|ids|counts|density]" << std::endl
+              << "                   [--density-above AIRCRAFT] [--bands COUNT HEIGHT] [--profile ROWS HEIGHT]"
+              << std::endl
+              << "                   [--altitude-floor M] [--live TTY] [--sector NAME]" << std::endl
+              << "  Defaults: 25 x 25 cells of 4000 m, zoom 1, centred on (50000, 50000), 5 characters wide,"
+              << std::endl
+              << "  ids or counts per cell, shaded by density above " << DEFAULT_GRID_DENSITY_ABOVE << " aircraft,"
+              << std::endl
+              << "  one plan view of every altitude and no side profile" << std::endl
+              << "  --sector runs another display beside the main one, logging grids to airspacelog_NAME.txt"
+              << std::endl;
+}
+
+static bool parseNumber(const char* text, double& value) {
+    char* end;
+    value = strtod(text, &end);
+    return end != text && *end == '\0';
+}
+
+/**
+ * Parse a count, range checked before the conversion to int. One above
+ * `maximum`, negative or not finite becomes -1, which GridRenderer::isValid
+ * rejects like any other count out of range.
+ */
+static bool parseCount(const char* text, int maximum, int& value) {
+    double a;
+    if (!parseNumber(text, a)) {
+        return false;
+    }
+    value = (a >= 0 && a <= maximum) ? (int)a : -1;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
     signal(SIGINT, handleSig);
     signal(SIGTERM, handleSig);
     
+    GridView view;
+    std::string livePath;
+    std::string sector;
+    for (int i = 1; i < argc; i++) {
+        double a = 0;
+        bool valid;
+        if (strcmp(argv[i], "--grid") == 0 && i + 2 < argc) {
+            valid = parseCount(argv[++i], MAX_GRID_COLUMNS, view.columns) &&
+                    parseCount(argv[++i], MAX_GRID_ROWS, view.rows);
+        } else if (strcmp(argv[i], "--center") == 0 && i + 2 < argc) {
+            valid = parseNumber(argv[++i], view.centerX) && parseNumber(argv[++i], view.centerY);
+        } else if (strcmp(argv[i], "--cell-size") == 0 && i + 1 < argc) {
+            valid = parseNumber(argv[++i], view.cellSize);
+        } else if (strcmp(argv[i], "--zoom") == 0 && i + 1 < argc) {
+            valid = parseNumber(argv[++i], view.zoom);
+        } else if (strcmp(argv[i], "--cell-width") == 0 && i + 1 < argc) {
+            valid = parseCount(argv[++i], MAX_GRID_CELL_WIDTH, view.cellWidth);
+        } else if (strcmp(argv[i], "--detail") == 0 && i + 1 < argc) {
+            static const char* const details[] = { "auto", "ids", "counts", "density" };
+            const char* name = argv[++i];
+            valid = false;
+            for (int d = GRID_DETAIL_AUTO; d <= GRID_DETAIL_DENSITY; d++) {
+                if (strcmp(name, details[d]) == 0) {
+                    view.detail = (GridDetail)d;
+                    valid = true;
+                }
+            }
+        } else if (strcmp(argv[i], "--density-above") == 0 && i + 1 < argc) {
+            valid = parseNumber(argv[++i], a) && a >= 0 && a <= (double)MAX_RADAR_CAPACITY;
+            view.densityAbove = valid ? (size_t)a : view.densityAbove;
+        } else if (strcmp(argv[i], "--bands") == 0 && i + 2 < argc) {
+            valid = parseCount(argv[++i], MAX_GRID_BANDS, view.bands) &&
+                    parseNumber(argv[++i], view.bandHeight);
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 2 < argc) {
+            valid = parseCount(argv[++i], MAX_GRID_ROWS, view.profileRows) &&
+                    parseNumber(argv[++i], view.profileRowHeight);
+        } else if (strcmp(argv[i], "--altitude-floor") == 0 && i + 1 < argc) {
+            valid = parseNumber(argv[++i], view.altitudeFloor);
+        } else if (strcmp(argv[i], "--sector") == 0 && i + 1 < argc) {
+            sector = argv[++i];
+            valid = !sector.empty() && sector.find('/') == std::string::npos;
+        } else if (strcmp(argv[i], "--live") == 0 && i + 1 < argc) {
+            livePath = argv[++i];
+            valid = true;
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            usage();
+            return 2;
+        }
+    }
+    if (!GridRenderer::isValid(view)) {
+        logDataDisplayMessage("Grid view out of range (at most " + std::to_string(MAX_GRID_COLUMNS) + "x" +
+                            std::to_string(MAX_GRID_ROWS) + " cells, " + std::to_string(MAX_GRID_CELL_WIDTH) +
+                            " characters each, " + std::to_string(MAX_GRID_BANDS) + " bands), using the default",
+                            LOG_WARNING);
+        view = GridView();
+    }
+    
     logDataDisplayMessage("Subsystem starting");
     
-    DataDisplay dd;
+    // A sector display logs its grids beside the main display's: airspacelog_NAME.txt
+    std::string logPath = DEFAULT_AIRSPACE_LOG_PATH;
+    if (!sector.empty()) {
+        logPath.insert(logPath.rfind('.'), "_" + sector);
+    }
+    DataDisplay dd(logPath, view);
+    dd.setLiveOutput(livePath);
+    dd.setSector(sector);
     
     std::thread ddThread([&dd]() {
         try {
@@ -30,7 +134,7 @@ int main() {
     }
     
     logDataDisplayMessage("Shutdown signal received", LOG_WARNING);
-    
+    dd.stop();
     
     if (ddThread.joinable()) {
         ddThread.join();
@@ -1,5 +1,6 @@
 #include "Radar.h"
 #include "Plane.h"
+#include "AirspaceHistory.h"
 #include "utils.h"
 #include <iostream>
 #include <fstream>
@@ -12,10 +13,25 @@
 #include <signal.h>
 #include <thread>
 #include <memory> 
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
 
 static volatile sig_atomic_t running = 1;
 static void handleSig(int) { running = 0; }
 
+// Longest recorded pause replayed as is; longer ones, where the system
+// was down between runs, are cut to this
+static const int64_t REPLAY_MAX_GAP_NS = 5000000000LL;
+
+struct ReplayOptions {
+    std::string dir;
+    double speed = 1.0;         // Multiple of real time; 0 replays as fast as possible
+    int64_t from = INT64_MIN;
+    int64_t to = INT64_MAX;
+};
+
 /**
  * Parse the input file containing plane data
  * Format: time id x y z speedX speedY speedZ
@@ -150,19 +166,13 @@ void runRadarSystem() {
                 }
                 if (!exists) {
                     activePlanes.push_back(std::move(planePtr));
+                    radar.addPlane(activePlanes.back().get(), t);
                     logRadarMessage("Added plane ID " +
                                     std::to_string(activePlanes.back()->getId()) +
                                     " at time " + std::to_string(currentTimeInt));
                 }
             }
             timeToPlanes.erase(currentTimeInt);
-
-            planePointers.clear();
-            planePointers.reserve(activePlanes.size());
-            for (auto &planeUptr : activePlanes) {
-                planePointers.push_back(planeUptr.get());
-            }
-            radar.detectAircraft(planePointers, t);
         }
 
         radar.update(t);
@@ -171,13 +181,120 @@ void runRadarSystem() {
     }
 }
 
-int main() {
+/** Sleep until `deadline`, waking regularly to notice a shutdown signal */
+static void waitUntil(std::chrono::steady_clock::time_point deadline) {
+    const auto slice = std::chrono::milliseconds(100);
+    while (running && std::chrono::steady_clock::now() + slice < deadline) {
+        std::this_thread::sleep_for(slice);
+    }
+    if (running) {
+        std::this_thread::sleep_until(deadline);
+    }
+}
+
+/**
+ * Stream the frames of an airspace history into /shm_radar_data in place
+ * of simulated traffic. Each frame is published when its recorded time,
+ * counted from the first replayed frame and divided by the speed, has
+ * elapsed. The last frame stays published when the replay ends.
+ */
+void runReplay(const ReplayOptions& options) {
+    AirspaceHistoryReader history;
+    if (!history.open(options.dir)) {
+        logRadarMessage("Cannot open airspace history " + options.dir + ", nothing to replay", LOG_ERROR);
+        return;
+    }
+
+    uint64_t first = history.seek(options.from);
+    // First frame after the range; `to` is inclusive
+    uint64_t end = (options.to == INT64_MAX) ? history.tickCount() : history.seek(options.to + 1);
+    end = std::max(end, first);
+    if (first == end) {
+        logRadarMessage("Airspace history " + options.dir + " has no frames in the requested range",
+                        LOG_WARNING);
+        return;
+    }
+
+    char fromText[64], toText[64];
+    formatHistoryTime(fromText, sizeof(fromText), history.tick(first).timeNs);
+    formatHistoryTime(toText, sizeof(toText), history.tick(end - 1).timeNs);
+    logRadarMessage("Replaying " + std::to_string(end - first) + " frames from " + options.dir +
+                    ", " + fromText + " to " + toText + ", at " +
+                    (options.speed > 0 ? std::to_string(options.speed) + "x real time"
+                                       : std::string("full speed")));
+
+    Radar radar;
+    HistoryFrame frame;
+    uint64_t published = 0, damaged = 0;
+    int64_t previousNs = 0, replayedNs = 0;     // Recorded time covered, long gaps cut
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = first; running && i < end; i++) {
+        if (!history.readFrame(i, frame)) {
+            damaged++;
+            continue;
+        }
+        if (published > 0) {
+            replayedNs += std::min(std::max<int64_t>(frame.timeNs - previousNs, 0), REPLAY_MAX_GAP_NS);
+        }
+        previousNs = frame.timeNs;
+
+        if (options.speed > 0) {
+            waitUntil(start + std::chrono::nanoseconds((int64_t)(replayedNs / options.speed)));
+        }
+        if (running && radar.replayFrame(frame)) {
+            published++;
+        }
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    logRadarMessage("Replay " + std::string(running ? "finished" : "stopped") + ": " +
+                    std::to_string(published) + " frames, " + std::to_string(replayedNs / 1e9) +
+                    " s recorded in " + std::to_string(wallSeconds) + " s (" +
+                    std::to_string(published / std::max(wallSeconds, 1e-9)) + " frames/s), " +
+                    std::to_string(damaged) + " damaged frames skipped");
+}
+
+static void usage() {
+    std::cerr << "Usage: Radar [--replay DIR [--speed X] [--from TIME] [--to TIME]]" << std::endl
+              << "  X: multiple of real time, 0 for as fast as possible (default 1)" << std::endl
+              << "  TIME: \"YYYY-mm-dd HH:MM:SS[.fff]\" (local) or seconds since the epoch" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
     signal(SIGINT, handleSig);
     signal(SIGTERM, handleSig);
     
+    ReplayOptions replay;
+    for (int i = 1; i < argc; i++) {
+        bool valid = i + 1 < argc;
+        if (valid && strcmp(argv[i], "--replay") == 0) {
+            replay.dir = argv[++i];
+        } else if (valid && strcmp(argv[i], "--speed") == 0) {
+            char* end;
+            replay.speed = strtod(argv[++i], &end);
+            valid = *end == '\0' && replay.speed >= 0;
+        } else if (valid && strcmp(argv[i], "--from") == 0) {
+            valid = parseHistoryTime(argv[++i], replay.from);
+        } else if (valid && strcmp(argv[i], "--to") == 0) {
+            valid = parseHistoryTime(argv[++i], replay.to);
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            usage();
+            return 2;
+        }
+    }
+
     logRadarMessage("Subsystem starting");
     
-    std::thread radarThread(runRadarSystem);
+    std::thread radarThread;
+    if (replay.dir.empty()) {
+        radarThread = std::thread(runRadarSystem);
+    } else {
+        radarThread = std::thread(runReplay, replay);
+    }
     
     while (running) {
         sleep(1); 
@@ -0,0 +1,1106 @@
+#include "AirspaceHistory.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <iterator>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "utils.h"
+
+namespace {
+
+// Files grow by at least half their size, in whole MiB, so remaps stay rare
+const size_t GROW_ALIGN = 1 << 20;
+const uint64_t INITIAL_TICKS = 4096;
+const uint64_t INITIAL_BLOCKS = 1024;
+
+size_t alignUp(size_t n, size_t a) {
+    return (n + a - 1) / a * a;
+}
+
+/** Byte offsets of the columns inside a block of `capacity` rows */
+struct BlockLayout {
+    size_t ids, x, y, z, vx, vy, vz, bytes;
+
+    explicit BlockLayout(uint32_t capacity) {
+        size_t column = (size_t)capacity * sizeof(double);
+        ids = sizeof(HistoryBlockHeader);
+        x = alignUp(ids + (size_t)capacity * sizeof(int32_t), sizeof(double));
+        y = x + column;
+        z = y + column;
+        vx = z + column;
+        vy = vx + column;
+        vz = vy + column;
+        bytes = alignUp(vz + column, 64);
+    }
+};
+
+template <typename T>
+T* column(char* block, size_t offset) {
+    return reinterpret_cast<T*>(block + offset);
+}
+
+template <typename T>
+const T* column(const char* block, size_t offset) {
+    return reinterpret_cast<const T*>(block + offset);
+}
+
+template <typename T>
+void copyColumn(std::vector<T>& out, const char* block, size_t offset, uint32_t row, uint32_t count) {
+    const T* first = column<T>(block, offset) + row;
+    out.assign(first, first + count);
+}
+
+// Residual frame coding: a varint track count, then one control byte per
+// track, or per run of up to RUN_MAX tracks that match their prediction
+const uint8_t CONTROL_RUN = 0x80;       // Low 7 bits: run length - 1
+const uint8_t CONTROL_ID = 0x40;        // Id differs from the previous frame's row; delta follows
+const uint32_t RUN_MAX = 128;           // Low 6 bits: which of x, y, z, vx, vy, vz have a residual
+
+void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+int64_t unzigzag(uint64_t u) {
+    return (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+}
+
+int64_t quantize(double v, double quantum) {
+    return llround(v / quantum);
+}
+
+/** Position steps per quantized velocity unit over dt; both sides compute it the same way */
+double predictionScale(double dt) {
+    return HISTORY_VELOCITY_QUANTUM / HISTORY_POSITION_QUANTUM * dt;
+}
+
+/** Nearest float at or below v */
+float roundDown(double v) {
+    float f = (float)v;
+    return (f > v) ? std::nextafter(f, -HUGE_VALF) : f;
+}
+
+/** Nearest float at or above v */
+float roundUp(double v) {
+    float f = (float)v;
+    return (f < v) ? std::nextafter(f, HUGE_VALF) : f;
+}
+
+void flushRun(std::vector<uint8_t>& out, uint32_t& run) {
+    if (run > 0) {
+        out.push_back((uint8_t)(CONTROL_RUN | (run - 1)));
+        run = 0;
+    }
+}
+
+/** Encode one frame against `prev` (empty for a keyframe) and leave its state in `next` */
+void encodeFrame(HistoryResidualState& prev, const RadarTrack* frame, size_t count,
+                 double simTime, std::vector<uint8_t>& out, HistoryResidualState& next) {
+    double scale = predictionScale(simTime - prev.simTime);
+    out.clear();
+    putVarint(out, count);
+    next.resize(count);
+
+    int32_t lastId = 0;
+    uint32_t run = 0;
+    for (size_t i = 0; i < count; i++) {
+        const RadarTrack& t = frame[i];
+        int64_t q[6] = {
+            quantize(t.x, HISTORY_POSITION_QUANTUM), quantize(t.y, HISTORY_POSITION_QUANTUM),
+            quantize(t.z, HISTORY_POSITION_QUANTUM), quantize(t.vx, HISTORY_VELOCITY_QUANTUM),
+            quantize(t.vy, HISTORY_VELOCITY_QUANTUM), quantize(t.vz, HISTORY_VELOCITY_QUANTUM)
+        };
+        next.ids[i] = t.planeId;
+        next.x[i] = q[0];
+        next.y[i] = q[1];
+        next.z[i] = q[2];
+        next.vx[i] = q[3];
+        next.vy[i] = q[4];
+        next.vz[i] = q[5];
+
+        int64_t r[6];
+        long p = prev.find(t.planeId, i);
+        if (p >= 0) {
+            r[0] = q[0] - (prev.x[p] + llround(prev.vx[p] * scale));
+            r[1] = q[1] - (prev.y[p] + llround(prev.vy[p] * scale));
+            r[2] = q[2] - (prev.z[p] + llround(prev.vz[p] * scale));
+            r[3] = q[3] - prev.vx[p];
+            r[4] = q[4] - prev.vy[p];
+            r[5] = q[5] - prev.vz[p];
+        } else {
+            std::copy(q, q + 6, r);
+        }
+
+        uint8_t control = (i < prev.size() && prev.ids[i] == t.planeId) ? 0 : CONTROL_ID;
+        for (int f = 0; f < 6; f++) {
+            if (r[f] != 0) {
+                control |= (uint8_t)(1 << f);
+            }
+        }
+
+        if (control == 0) {
+            if (++run == RUN_MAX) {
+                flushRun(out, run);
+            }
+        } else {
+            flushRun(out, run);
+            out.push_back(control);
+            if (control & CONTROL_ID) {
+                putVarint(out, zigzag((int64_t)t.planeId - lastId));
+            }
+            for (int f = 0; f < 6; f++) {
+                if (r[f] != 0) {
+                    putVarint(out, zigzag(r[f]));
+                }
+            }
+        }
+        lastId = t.planeId;
+    }
+    flushRun(out, run);
+    next.simTime = simTime;
+}
+
+/** Inverse of encodeFrame; false if the data is damaged */
+bool decodeFrame(HistoryResidualState& prev, const uint8_t* p, const uint8_t* end,
+                 double simTime, HistoryResidualState& next) {
+    double scale = predictionScale(simTime - prev.simTime);
+    uint64_t count;
+    if (!getVarint(p, end, count) || count > MAX_RADAR_CAPACITY) {
+        return false;
+    }
+    next.resize(count);
+
+    int32_t lastId = 0;
+    size_t i = 0;
+    while (i < count) {
+        if (p >= end) {
+            return false;
+        }
+        uint8_t control = *p++;
+        size_t n = (control & CONTROL_RUN) ? (size_t)(control & 0x7f) + 1 : 1;
+        if (i + n > count) {
+            return false;
+        }
+
+        for (size_t k = 0; k < n; k++, i++) {
+            int32_t id;
+            int64_t r[6] = { 0, 0, 0, 0, 0, 0 };
+            if (!(control & CONTROL_RUN) && (control & CONTROL_ID)) {
+                uint64_t u;
+                if (!getVarint(p, end, u)) {
+                    return false;
+                }
+                id = (int32_t)(lastId + unzigzag(u));
+            } else if (i < prev.size()) {
+                id = prev.ids[i];
+            } else {
+                return false;
+            }
+            if (!(control & CONTROL_RUN)) {
+                for (int f = 0; f < 6; f++) {
+                    uint64_t u;
+                    if ((control & (1 << f))) {
+                        if (!getVarint(p, end, u)) {
+                            return false;
+                        }
+                        r[f] = unzigzag(u);
+                    }
+                }
+            }
+
+            next.ids[i] = id;
+            long q = prev.find(id, i);
+            if (q >= 0) {
+                next.x[i] = prev.x[q] + llround(prev.vx[q] * scale) + r[0];
+                next.y[i] = prev.y[q] + llround(prev.vy[q] * scale) + r[1];
+                next.z[i] = prev.z[q] + llround(prev.vz[q] * scale) + r[2];
+                next.vx[i] = prev.vx[q] + r[3];
+                next.vy[i] = prev.vy[q] + r[4];
+                next.vz[i] = prev.vz[q] + r[5];
+            } else {
+                next.x[i] = r[0];
+                next.y[i] = r[1];
+                next.z[i] = r[2];
+                next.vx[i] = r[3];
+                next.vy[i] = r[4];
+                next.vz[i] = r[5];
+            }
+            lastId = id;
+        }
+    }
+    next.simTime = simTime;
+    return true;
+}
+
+bool initHeader(MappedFile& file, uint64_t magic, uint64_t emptyUsed, const std::string& path) {
+    HistoryFileHeader* h = reinterpret_cast<HistoryFileHeader*>(file.data());
+    if (h->magic == 0) {
+        h->version = HISTORY_VERSION;
+        h->used.store(emptyUsed, std::memory_order_relaxed);
+        h->magic = magic;
+        return true;
+    }
+    if (h->magic != magic || h->version != HISTORY_VERSION) {
+        logSystemMessage("Airspace history file " + path + " has an unknown format", LOG_ERROR);
+        return false;
+    }
+    return true;
+}
+
+bool checkHeader(const MappedFile& file, uint64_t magic) {
+    if (file.size() < sizeof(HistoryFileHeader)) {
+        return false;
+    }
+    const HistoryFileHeader* h = reinterpret_cast<const HistoryFileHeader*>(file.data());
+    return h->magic == magic && h->version == HISTORY_VERSION;
+}
+
+} // namespace
+
+// HistoryResidualState
+
+void HistoryResidualState::clear() {
+    resize(0);
+    simTime = 0;
+}
+
+void HistoryResidualState::resize(size_t n) {
+    ids.resize(n);
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    vx.resize(n);
+    vy.resize(n);
+    vz.resize(n);
+    indexed = false;
+}
+
+long HistoryResidualState::find(int32_t id, size_t hint) {
+    if (hint < ids.size() && ids[hint] == id) {
+        return (long)hint;
+    }
+    if (!indexed) {
+        indexById.clear();
+        for (size_t i = 0; i < ids.size(); i++) {
+            indexById[ids[i]] = (uint32_t)i;
+        }
+        indexed = true;
+    }
+    auto it = indexById.find(id);
+    return it == indexById.end() ? -1 : (long)it->second;
+}
+
+// MappedFile
+
+bool MappedFile::mapCurrent(size_t size) {
+    int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* p = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        logSystemMessage("Failed to map " + path + ": " + strerror(errno), LOG_ERROR);
+        return false;
+    }
+    if (base) {
+        munmap(base, mappedSize);
+    }
+    base = static_cast<char*>(p);
+    mappedSize = size;
+    return true;
+}
+
+bool MappedFile::open(const std::string& filePath, bool forWriting, size_t initialSize) {
+    close();
+    path = filePath;
+    writable = forWriting;
+
+    fd = ::open(path.c_str(), forWriting ? (O_RDWR | O_CREAT | O_CLOEXEC) : (O_RDONLY | O_CLOEXEC), 0666);
+    if (fd == -1) {
+        if (forWriting) {
+            logSystemMessage("Failed to open " + path + ": " + strerror(errno), LOG_ERROR);
+        }
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close();
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    if (forWriting && size < initialSize) {
+        if (ftruncate(fd, (off_t)initialSize) == -1) {
+            logSystemMessage("Failed to size " + path + ": " + strerror(errno), LOG_ERROR);
+            close();
+            return false;
+        }
+        size = initialSize;
+    }
+    if (size == 0 || !mapCurrent(size)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::reserve(size_t needed) {
+    if (needed <= mappedSize) {
+        return true;
+    }
+    if (fd == -1 || !writable) {
+        return false;
+    }
+    size_t newSize = alignUp(std::max(needed, mappedSize + mappedSize / 2), GROW_ALIGN);
+    if (ftruncate(fd, (off_t)newSize) == -1) {
+        logSystemMessage("Failed to grow " + path + ": " + strerror(errno), LOG_ERROR);
+        return false;
+    }
+    return mapCurrent(newSize);
+}
+
+bool MappedFile::refresh() {
+    if (fd == -1) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        return false;
+    }
+    if ((size_t)st.st_size > mappedSize) {
+        return mapCurrent((size_t)st.st_size);
+    }
+    return true;
+}
+
+void MappedFile::sync() {
+    if (base) {
+        msync(base, mappedSize, MS_ASYNC);
+    }
+}
+
+void MappedFile::close() {
+    if (base) {
+        munmap(base, mappedSize);
+        base = nullptr;
+    }
+    if (fd != -1) {
+        ::close(fd);
+        fd = -1;
+    }
+    mappedSize = 0;
+}
+
+// AirspaceHistoryWriter
+
+bool AirspaceHistoryWriter::open(const std::string& dir, HistoryBlockEncoding blockEncoding) {
+    close();
+    encoding = blockEncoding;
+    ensureLogDirectories();
+    if (mkdir(dir.c_str(), 0777) == -1 && errno != EEXIST) {
+        logSystemMessage("Failed to create airspace history directory " + dir + ": " +
+                         strerror(errno), LOG_ERROR);
+        return false;
+    }
+
+    std::string indexPath = dir + "/" HISTORY_INDEX_FILE;
+    std::string tracksPath = dir + "/" HISTORY_TRACKS_FILE;
+    std::string blocksPath = dir + "/" HISTORY_BLOCKS_FILE;
+    if (!index.open(indexPath, true, sizeof(HistoryFileHeader) + INITIAL_TICKS * sizeof(HistoryTick)) ||
+        !tracks.open(tracksPath, true, GROW_ALIGN) ||
+        !blocks.open(blocksPath, true, sizeof(HistoryFileHeader) + INITIAL_BLOCKS * sizeof(HistoryBlockSummary)) ||
+        !initHeader(index, HISTORY_INDEX_MAGIC, 0, indexPath) ||
+        !initHeader(tracks, HISTORY_TRACKS_MAGIC, sizeof(HistoryFileHeader), tracksPath) ||
+        !initHeader(blocks, HISTORY_BLOCKS_MAGIC, 0, blocksPath)) {
+        close();
+        return false;
+    }
+
+    // Continue after the last published frame, in a new block
+    uint64_t ticks = indexHeader()->used.load(std::memory_order_acquire);
+    if (sizeof(HistoryFileHeader) + ticks * sizeof(HistoryTick) > index.size()) {
+        logSystemMessage("Airspace history index " + indexPath + " is truncated", LOG_ERROR);
+        close();
+        return false;
+    }
+    if (ticks > 0) {
+        const HistoryTick* entries = reinterpret_cast<const HistoryTick*>(index.data() + sizeof(HistoryFileHeader));
+        lastTimeNs = entries[ticks - 1].timeNs;
+    }
+
+    // Drop summaries of frames the index no longer has
+    uint64_t summaries = std::min(blocksHeader()->used.load(std::memory_order_acquire),
+                                  (uint64_t)((blocks.size() - sizeof(HistoryFileHeader)) / sizeof(HistoryBlockSummary)));
+    const HistoryBlockSummary* summary =
+        reinterpret_cast<const HistoryBlockSummary*>(blocks.data() + sizeof(HistoryFileHeader));
+    while (summaries > 0 && summary[summaries - 1].firstTick + summary[summaries - 1].ticks > ticks) {
+        summaries--;
+    }
+    blocksHeader()->used.store(summaries, std::memory_order_release);
+    return true;
+}
+
+void AirspaceHistoryWriter::close() {
+    if (isOpen() && blockOffset != 0) {
+        indexBlock();
+    }
+    sync();
+    index.close();
+    tracks.close();
+    blocks.close();
+    blockOffset = 0;
+    lastTimeNs = 0;
+    previous.clear();
+    openSpans = 0;
+    spanById.clear();
+    rowIds.clear();
+}
+
+bool AirspaceHistoryWriter::startBlock(uint32_t capacity, uint64_t firstTick) {
+    if (blockOffset != 0 && !indexBlock()) {
+        logSystemMessage("Failed to index an airspace history block, queries will decode it",
+                         LOG_WARNING);
+    }
+
+    uint64_t bytes = encoding == HISTORY_BLOCK_COLUMNS ?
+        BlockLayout(capacity).bytes : sizeof(HistoryBlockHeader);
+    uint64_t offset = tracksHeader()->used.load(std::memory_order_relaxed);
+    if (!tracks.reserve(offset + bytes)) {
+        return false;
+    }
+
+    HistoryBlockHeader* block = reinterpret_cast<HistoryBlockHeader*>(tracks.data() + offset);
+    block->capacity = capacity;
+    block->rows = 0;
+    block->firstTick = firstTick;
+    block->ticks = 0;
+    block->encoding = encoding;
+    block->bytes = bytes;
+    tracksHeader()->used.store(offset + bytes, std::memory_order_release);
+    blockOffset = offset;
+    blockFirstTick = firstTick;
+    return true;
+}
+
+bool AirspaceHistoryWriter::append(int64_t timeNs, double simTime, uint64_t sequence,
+                                   const RadarTrack* frame, size_t count) {
+    if (!isOpen() || timeNs < lastTimeNs || count > MAX_RADAR_CAPACITY) {
+        return false;
+    }
+
+    uint64_t tick = indexHeader()->used.load(std::memory_order_relaxed);
+    if (!index.reserve(sizeof(HistoryFileHeader) + (tick + 1) * sizeof(HistoryTick))) {
+        return false;
+    }
+
+    uint32_t row;
+    bool appended = encoding == HISTORY_BLOCK_COLUMNS ?
+        appendColumns(tick, frame, count, row) : appendResidual(tick, simTime, frame, count, row);
+    if (!appended) {
+        return false;
+    }
+    if (tick == blockFirstTick) {
+        blockFirstTimeNs = timeNs;
+    }
+    trackAircraft(tick, simTime, frame, count);
+
+    HistoryTick* entries = reinterpret_cast<HistoryTick*>(index.data() + sizeof(HistoryFileHeader));
+    entries[tick] = { timeNs, simTime, sequence, blockOffset, row, (uint32_t)count };
+    indexHeader()->used.store(tick + 1, std::memory_order_release);
+    lastTimeNs = timeNs;
+    return true;
+}
+
+bool AirspaceHistoryWriter::appendColumns(uint64_t tick, const RadarTrack* frame, size_t count,
+                                          uint32_t& row) {
+    HistoryBlockHeader* block = blockOffset ?
+        reinterpret_cast<HistoryBlockHeader*>(tracks.data() + blockOffset) : nullptr;
+    if (!block || block->encoding != HISTORY_BLOCK_COLUMNS || block->rows + count > block->capacity) {
+        if (!startBlock(std::max(HISTORY_BLOCK_ROWS, (uint32_t)count), tick)) {
+            return false;
+        }
+        block = reinterpret_cast<HistoryBlockHeader*>(tracks.data() + blockOffset);
+    }
+
+    BlockLayout layout(block->capacity);
+    char* base = reinterpret_cast<char*>(block);
+    row = block->rows;
+    int32_t* ids = column<int32_t>(base, layout.ids) + row;
+    double* x = column<double>(base, layout.x) + row;
+    double* y = column<double>(base, layout.y) + row;
+    double* z = column<double>(base, layout.z) + row;
+    double* vx = column<double>(base, layout.vx) + row;
+    double* vy = column<double>(base, layout.vy) + row;
+    double* vz = column<double>(base, layout.vz) + row;
+    for (size_t i = 0; i < count; i++) {
+        const RadarTrack& t = frame[i];
+        ids[i] = t.planeId;
+        x[i] = t.x;
+        y[i] = t.y;
+        z[i] = t.z;
+        vx[i] = t.vx;
+        vy[i] = t.vy;
+        vz[i] = t.vz;
+    }
+    block->rows = row + (uint32_t)count;
+    block->ticks++;
+    return true;
+}
+
+bool AirspaceHistoryWriter::appendResidual(uint64_t tick, double simTime, const RadarTrack* frame,
+                                           size_t count, uint32_t& row) {
+    HistoryBlockHeader* block = blockOffset ?
+        reinterpret_cast<HistoryBlockHeader*>(tracks.data() + blockOffset) : nullptr;
+    if (!block || block->encoding != HISTORY_BLOCK_RESIDUAL || block->ticks >= HISTORY_BLOCK_TICKS ||
+        (block->rows > 0 && block->rows + count > HISTORY_BLOCK_ROWS)) {
+        if (!startBlock(0, tick)) {
+            return false;
+        }
+        previous.clear();   // Keyframe
+    }
+
+    encodeFrame(previous, frame, count, simTime, encoded, current);
+
+    uint64_t end = tracksHeader()->used.load(std::memory_order_relaxed);
+    if (!tracks.reserve(end + encoded.size())) {
+        return false;
+    }
+    memcpy(tracks.data() + end, encoded.data(), encoded.size());
+
+    block = reinterpret_cast<HistoryBlockHeader*>(tracks.data() + blockOffset);
+    row = (uint32_t)block->bytes;
+    block->bytes += encoded.size();
+    block->rows += (uint32_t)count;
+    block->ticks++;
+    tracksHeader()->used.store(end + encoded.size(), std::memory_order_release);
+    std::swap(previous, current);
+    return true;
+}
+
+void AirspaceHistoryWriter::trackAircraft(uint64_t tick, double simTime, const RadarTrack* frame,
+                                          size_t count) {
+    const uint32_t NONE = UINT32_MAX;
+    nextRowIds.resize(count);
+    nextRowSpans.resize(count);
+
+    for (size_t i = 0; i < count; i++) {
+        const RadarTrack& t = frame[i];
+        int64_t q[6] = {
+            quantize(t.x, HISTORY_POSITION_QUANTUM), quantize(t.y, HISTORY_POSITION_QUANTUM),
+            quantize(t.z, HISTORY_POSITION_QUANTUM), quantize(t.vx, HISTORY_VELOCITY_QUANTUM),
+            quantize(t.vy, HISTORY_VELOCITY_QUANTUM), quantize(t.vz, HISTORY_VELOCITY_QUANTUM)
+        };
+        double position[3] = {
+            q[0] * HISTORY_POSITION_QUANTUM, q[1] * HISTORY_POSITION_QUANTUM, q[2] * HISTORY_POSITION_QUANTUM
+        };
+
+        uint32_t slot = NONE;
+        if (i < rowIds.size() && rowIds[i] == t.planeId) {
+            slot = rowSpans[i];
+        } else {
+            auto found = spanById.find(t.planeId);
+            if (found != spanById.end()) {
+                slot = found->second;
+            }
+        }
+
+        // An aircraft missing from the previous frame starts a new span
+        if (slot == NONE || spanTracks[slot].lastTick + 1 != tick) {
+            slot = (uint32_t)openSpans++;
+            if (slot == spanTracks.size()) {
+                spanTracks.emplace_back();
+            }
+            spanById[t.planeId] = slot;
+            AircraftTrack& a = spanTracks[slot];
+            a.id = t.planeId;
+            a.firstTick = tick;
+            a.run = 0;
+            a.data.clear();
+            for (int f = 0; f < 6; f++) {
+                putVarint(a.data, zigzag(q[f]));
+            }
+            std::copy(position, position + 3, a.min);
+            std::copy(position, position + 3, a.max);
+        } else {
+            AircraftTrack& a = spanTracks[slot];
+            double scale = predictionScale(simTime - a.simTime);
+            int64_t r[6] = {
+                q[0] - (a.q[0] + llround(a.q[3] * scale)), q[1] - (a.q[1] + llround(a.q[4] * scale)),
+                q[2] - (a.q[2] + llround(a.q[5] * scale)),
+                q[3] - a.q[3], q[4] - a.q[4], q[5] - a.q[5]
+            };
+            uint8_t control = 0;
+            for (int f = 0; f < 6; f++) {
+                if (r[f] != 0) {
+                    control |= (uint8_t)(1 << f);
+                }
+            }
+            if (control == 0) {
+                if (++a.run == RUN_MAX) {
+                    flushRun(a.data, a.run);
+                }
+            } else {
+                flushRun(a.data, a.run);
+                a.data.push_back(control);
+                for (int f = 0; f < 6; f++) {
+                    if (r[f] != 0) {
+                        putVarint(a.data, zigzag(r[f]));
+                    }
+                }
+            }
+            for (int d = 0; d < 3; d++) {
+                a.min[d] = std::min(a.min[d], position[d]);
+                a.max[d] = std::max(a.max[d], position[d]);
+            }
+        }
+
+        AircraftTrack& a = spanTracks[slot];
+        a.lastTick = tick;
+        a.simTime = simTime;
+        std::copy(q, q + 6, a.q);
+        nextRowIds[i] = t.planeId;
+        nextRowSpans[i] = slot;
+    }
+    std::swap(rowIds, nextRowIds);
+    std::swap(rowSpans, nextRowSpans);
+}
+
+bool AirspaceHistoryWriter::indexBlock() {
+    const HistoryBlockHeader* frames = reinterpret_cast<const HistoryBlockHeader*>(tracks.data() + blockOffset);
+    uint32_t ticks = frames->ticks;
+    size_t n = openSpans;
+    openSpans = 0;
+    spanById.clear();
+    rowIds.clear();
+    if (ticks == 0) {
+        return true;
+    }
+
+    spanOrder.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        spanOrder[i] = (uint32_t)i;
+    }
+    std::sort(spanOrder.begin(), spanOrder.end(), [this](uint32_t a, uint32_t b) {
+        const AircraftTrack& x = spanTracks[a];
+        const AircraftTrack& y = spanTracks[b];
+        return x.id != y.id ? x.id < y.id : x.firstTick < y.firstTick;
+    });
+    uint64_t bytes = sizeof(HistoryBlockHeader) + n * sizeof(HistoryAircraftSpan);
+    for (size_t i = 0; i < n; i++) {
+        flushRun(spanTracks[i].data, spanTracks[i].run);
+        bytes += spanTracks[i].data.size();
+    }
+
+    uint64_t offset = tracksHeader()->used.load(std::memory_order_relaxed);
+    uint64_t summaries = blocksHeader()->used.load(std::memory_order_relaxed);
+    if (bytes > UINT32_MAX || !tracks.reserve(offset + bytes) ||
+        !blocks.reserve(sizeof(HistoryFileHeader) + (summaries + 1) * sizeof(HistoryBlockSummary))) {
+        return false;
+    }
+
+    HistoryBlockSummary summary;
+    summary.blockOffset = blockOffset;
+    summary.aircraftOffset = offset;
+    summary.firstTick = blockFirstTick;
+    summary.ticks = ticks;
+    summary.spans = (uint32_t)n;
+    summary.firstTimeNs = blockFirstTimeNs;
+    summary.lastTimeNs = lastTimeNs;
+    std::fill(summary.min, summary.min + 3, HUGE_VAL);
+    std::fill(summary.max, summary.max + 3, -HUGE_VAL);
+
+    char* base = tracks.data() + offset;
+    HistoryBlockHeader* block = reinterpret_cast<HistoryBlockHeader*>(base);
+    *block = { 0, (uint32_t)n, blockFirstTick, ticks, HISTORY_BLOCK_AIRCRAFT, bytes };
+    HistoryAircraftSpan* spans = reinterpret_cast<HistoryAircraftSpan*>(block + 1);
+    uint32_t dataOffset = (uint32_t)(sizeof(HistoryBlockHeader) + n * sizeof(HistoryAircraftSpan));
+    for (size_t i = 0; i < n; i++) {
+        const AircraftTrack& a = spanTracks[spanOrder[i]];
+        HistoryAircraftSpan& span = spans[i];
+        span.id = a.id;
+        span.firstTick = (uint32_t)(a.firstTick - blockFirstTick);
+        span.ticks = (uint32_t)(a.lastTick - a.firstTick + 1);
+        span.offset = dataOffset;
+        for (int d = 0; d < 3; d++) {
+            span.min[d] = roundDown(a.min[d]);
+            span.max[d] = roundUp(a.max[d]);
+            summary.min[d] = std::min(summary.min[d], a.min[d]);
+            summary.max[d] = std::max(summary.max[d], a.max[d]);
+        }
+        memcpy(base + dataOffset, a.data.data(), a.data.size());
+        dataOffset += (uint32_t)a.data.size();
+    }
+    tracksHeader()->used.store(offset + bytes, std::memory_order_release);
+
+    HistoryBlockSummary* entries =
+        reinterpret_cast<HistoryBlockSummary*>(blocks.data() + sizeof(HistoryFileHeader));
+    entries[summaries] = summary;
+    blocksHeader()->used.store(summaries + 1, std::memory_order_release);
+    return true;
+}
+
+void AirspaceHistoryWriter::sync() {
+    index.sync();
+    tracks.sync();
+    blocks.sync();
+}
+
+uint64_t AirspaceHistoryWriter::tickCount() const {
+    return index.isOpen() ? indexHeader()->used.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t AirspaceHistoryWriter::bytesUsed() const {
+    if (!isOpen()) {
+        return 0;
+    }
+    return sizeof(HistoryFileHeader) + tickCount() * sizeof(HistoryTick) +
+           tracksHeader()->used.load(std::memory_order_relaxed) + sizeof(HistoryFileHeader) +
+           blocksHeader()->used.load(std::memory_order_relaxed) * sizeof(HistoryBlockSummary);
+}
+
+// AirspaceHistoryReader
+
+bool AirspaceHistoryReader::open(const std::string& dir) {
+    close();
+    if (!index.open(dir + "/" HISTORY_INDEX_FILE, false) ||
+        !tracks.open(dir + "/" HISTORY_TRACKS_FILE, false) ||
+        !checkHeader(index, HISTORY_INDEX_MAGIC) ||
+        !checkHeader(tracks, HISTORY_TRACKS_MAGIC)) {
+        close();
+        return false;
+    }
+    if (!blocks.open(dir + "/" HISTORY_BLOCKS_FILE, false) || !checkHeader(blocks, HISTORY_BLOCKS_MAGIC)) {
+        blocks.close();
+    }
+    return refresh();
+}
+
+void AirspaceHistoryReader::close() {
+    index.close();
+    tracks.close();
+    blocks.close();
+    ticks = 0;
+    summaries = 0;
+    decodedBlock = 0;
+}
+
+const HistoryTick* AirspaceHistoryReader::tickEntries() const {
+    return reinterpret_cast<const HistoryTick*>(index.data() + sizeof(HistoryFileHeader));
+}
+
+bool AirspaceHistoryReader::refresh() {
+    if (!index.isOpen() || !tracks.isOpen()) {
+        return false;
+    }
+
+    // Summaries first, then ticks: every tick a published summary covers was
+    // published before it, and every block a published tick or summary
+    // refers to is counted in tracks' `used`
+    uint64_t s = 0;
+    if (blocks.isOpen()) {
+        s = reinterpret_cast<const HistoryFileHeader*>(blocks.data())->used.load(std::memory_order_acquire);
+        if (sizeof(HistoryFileHeader) + s * sizeof(HistoryBlockSummary) > blocks.size() && !blocks.refresh()) {
+            return false;
+        }
+    }
+    const HistoryFileHeader* ih = reinterpret_cast<const HistoryFileHeader*>(index.data());
+    uint64_t n = ih->used.load(std::memory_order_acquire);
+    const HistoryFileHeader* th = reinterpret_cast<const HistoryFileHeader*>(tracks.data());
+    uint64_t trackBytes = th->used.load(std::memory_order_acquire);
+
+    if ((sizeof(HistoryFileHeader) + n * sizeof(HistoryTick) > index.size() && !index.refresh()) ||
+        (trackBytes > tracks.size() && !tracks.refresh())) {
+        return false;
+    }
+    uint64_t mapped = (index.size() - sizeof(HistoryFileHeader)) / sizeof(HistoryTick);
+    ticks = std::min(n, mapped);
+    summaries = blocks.isOpen() ?
+        std::min(s, (uint64_t)((blocks.size() - sizeof(HistoryFileHeader)) / sizeof(HistoryBlockSummary))) : 0;
+    return true;
+}
+
+uint64_t AirspaceHistoryReader::seek(int64_t timeNs) const {
+    const HistoryTick* entries = tickEntries();
+    const HistoryTick* found = std::lower_bound(entries, entries + ticks, timeNs,
+        [](const HistoryTick& t, int64_t value) { return t.timeNs < value; });
+    return (uint64_t)(found - entries);
+}
+
+bool AirspaceHistoryReader::readFrame(uint64_t i, HistoryFrame& frame) const {
+    if (i >= ticks) {
+        return false;
+    }
+    const HistoryTick& t = tickEntries()[i];
+    if (t.blockOffset < sizeof(HistoryFileHeader) ||
+        t.blockOffset + sizeof(HistoryBlockHeader) > tracks.size()) {
+        return false;
+    }
+    const char* block = tracks.data() + t.blockOffset;
+
+    frame.timeNs = t.timeNs;
+    frame.simTime = t.simTime;
+    frame.sequence = t.sequence;
+    switch (reinterpret_cast<const HistoryBlockHeader*>(block)->encoding) {
+        case HISTORY_BLOCK_COLUMNS:  return readColumns(t, block, frame);
+        case HISTORY_BLOCK_RESIDUAL: return readResidual(i, t, block, frame);
+        default:                     return false;
+    }
+}
+
+bool AirspaceHistoryReader::readColumns(const HistoryTick& t, const char* block,
+                                        HistoryFrame& frame) const {
+    BlockLayout layout(reinterpret_cast<const HistoryBlockHeader*>(block)->capacity);
+    if (t.blockOffset + layout.bytes > tracks.size() ||
+        (uint64_t)t.row + t.count > reinterpret_cast<const HistoryBlockHeader*>(block)->capacity) {
+        return false;
+    }
+    copyColumn(frame.ids, block, layout.ids, t.row, t.count);
+    copyColumn(frame.x, block, layout.x, t.row, t.count);
+    copyColumn(frame.y, block, layout.y, t.row, t.count);
+    copyColumn(frame.z, block, layout.z, t.row, t.count);
+    copyColumn(frame.vx, block, layout.vx, t.row, t.count);
+    copyColumn(frame.vy, block, layout.vy, t.row, t.count);
+    copyColumn(frame.vz, block, layout.vz, t.row, t.count);
+    return true;
+}
+
+bool AirspaceHistoryReader::readResidual(uint64_t i, const HistoryTick& t, const char* block,
+                                         HistoryFrame& frame) const {
+    uint64_t firstTick = reinterpret_cast<const HistoryBlockHeader*>(block)->firstTick;
+    if (firstTick > i) {
+        return false;
+    }
+
+    // Continue from the last decoded frame if it precedes i in the same block
+    uint64_t next = firstTick;
+    if (decodedBlock == t.blockOffset && decodedTick >= firstTick && decodedTick <= i) {
+        next = decodedTick + 1;
+    } else {
+        decoded.clear();
+    }
+    decodedBlock = 0;
+
+    const uint8_t* end = reinterpret_cast<const uint8_t*>(tracks.data() + tracks.size());
+    for (uint64_t j = next; j <= i; j++) {
+        const HistoryTick& tj = tickEntries()[j];
+        if (tj.blockOffset != t.blockOffset || t.blockOffset + tj.row >= tracks.size()) {
+            return false;
+        }
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(block + tj.row);
+        if (!decodeFrame(decoded, data, end, tj.simTime, scratch) || scratch.size() != tj.count) {
+            return false;
+        }
+        std::swap(decoded, scratch);
+    }
+    decodedBlock = t.blockOffset;
+    decodedTick = i;
+
+    size_t n = decoded.size();
+    frame.ids.assign(decoded.ids.begin(), decoded.ids.end());
+    frame.x.resize(n);
+    frame.y.resize(n);
+    frame.z.resize(n);
+    frame.vx.resize(n);
+    frame.vy.resize(n);
+    frame.vz.resize(n);
+    for (size_t k = 0; k < n; k++) {
+        frame.x[k] = decoded.x[k] * HISTORY_POSITION_QUANTUM;
+        frame.y[k] = decoded.y[k] * HISTORY_POSITION_QUANTUM;
+        frame.z[k] = decoded.z[k] * HISTORY_POSITION_QUANTUM;
+        frame.vx[k] = decoded.vx[k] * HISTORY_VELOCITY_QUANTUM;
+        frame.vy[k] = decoded.vy[k] * HISTORY_VELOCITY_QUANTUM;
+        frame.vz[k] = decoded.vz[k] * HISTORY_VELOCITY_QUANTUM;
+    }
+    return true;
+}
+
+const HistoryBlockSummary& AirspaceHistoryReader::block(uint64_t b) const {
+    return reinterpret_cast<const HistoryBlockSummary*>(blocks.data() + sizeof(HistoryFileHeader))[b];
+}
+
+const HistoryAircraftSpan* AirspaceHistoryReader::spans(const HistoryBlockSummary& summary) const {
+    if (summary.aircraftOffset < sizeof(HistoryFileHeader) ||
+        summary.aircraftOffset + sizeof(HistoryBlockHeader) > tracks.size()) {
+        return nullptr;
+    }
+    const HistoryBlockHeader* block =
+        reinterpret_cast<const HistoryBlockHeader*>(tracks.data() + summary.aircraftOffset);
+    if (block->encoding != HISTORY_BLOCK_AIRCRAFT || block->rows != summary.spans ||
+        summary.aircraftOffset + block->bytes > tracks.size() ||
+        sizeof(HistoryBlockHeader) + (uint64_t)summary.spans * sizeof(HistoryAircraftSpan) > block->bytes) {
+        return nullptr;
+    }
+    return reinterpret_cast<const HistoryAircraftSpan*>(block + 1);
+}
+
+bool AirspaceHistoryReader::readSpan(const HistoryBlockSummary& summary, const HistoryAircraftSpan& span,
+                                     uint64_t fromTick, uint64_t toTick,
+                                     std::vector<HistoryTrackPoint>& points) const {
+    const HistoryAircraftSpan* all = spans(summary);
+    if (!all || &span < all || &span >= all + summary.spans) {
+        return false;
+    }
+    const char* base = tracks.data() + summary.aircraftOffset;
+    uint64_t blockBytes = reinterpret_cast<const HistoryBlockHeader*>(base)->bytes;
+    uint64_t endOffset = (&span + 1 < all + summary.spans) ? (&span)[1].offset : blockBytes;
+    if (span.offset > endOffset || endOffset > blockBytes) {
+        return false;
+    }
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(base + span.offset);
+    const uint8_t* end = reinterpret_cast<const uint8_t*>(base + endOffset);
+
+    uint64_t first = summary.firstTick + span.firstTick;
+    uint64_t last = std::min(first + span.ticks, std::min(toTick, ticks));
+    int64_t q[6];
+    for (int f = 0; f < 6; f++) {
+        uint64_t u;
+        if (!getVarint(p, end, u)) {
+            return false;
+        }
+        q[f] = unzigzag(u);
+    }
+
+    const HistoryTick* entries = tickEntries();
+    uint64_t tick = first;
+    uint32_t run = 0;
+    while (tick < last) {
+        if (tick >= fromTick) {
+            points.push_back({ tick, span.id,
+                               q[0] * HISTORY_POSITION_QUANTUM, q[1] * HISTORY_POSITION_QUANTUM,
+                               q[2] * HISTORY_POSITION_QUANTUM, q[3] * HISTORY_VELOCITY_QUANTUM,
+                               q[4] * HISTORY_VELOCITY_QUANTUM, q[5] * HISTORY_VELOCITY_QUANTUM });
+        }
+        if (++tick == last) {
+            break;
+        }
+
+        int64_t r[6] = { 0, 0, 0, 0, 0, 0 };
+        if (run > 0) {
+            run--;
+        } else {
+            if (p >= end) {
+                return false;
+            }
+            uint8_t control = *p++;
+            if (control & CONTROL_RUN) {
+                run = control & 0x7f;
+            } else {
+                for (int f = 0; f < 6; f++) {
+                    uint64_t u;
+                    if (control & (1 << f)) {
+                        if (!getVarint(p, end, u)) {
+                            return false;
+                        }
+                        r[f] = unzigzag(u);
+                    }
+                }
+            }
+        }
+
+        double scale = predictionScale(entries[tick].simTime - entries[tick - 1].simTime);
+        q[0] += llround(q[3] * scale) + r[0];
+        q[1] += llround(q[4] * scale) + r[1];
+        q[2] += llround(q[5] * scale) + r[2];
+        q[3] += r[3];
+        q[4] += r[4];
+        q[5] += r[5];
+    }
+    return true;
+}
+
+uint64_t AirspaceHistoryReader::bytesUsed() const {
+    if (!tracks.isOpen()) {
+        return 0;
+    }
+    const HistoryFileHeader* th = reinterpret_cast<const HistoryFileHeader*>(tracks.data());
+    return sizeof(HistoryFileHeader) + ticks * sizeof(HistoryTick) +
+           th->used.load(std::memory_order_relaxed) +
+           (blocks.isOpen() ? sizeof(HistoryFileHeader) + summaries * sizeof(HistoryBlockSummary) : 0);
+}
+
+void HistoryReplayTracks::build(const HistoryFrame& frame, RadarTrack* out, size_t count) {
+    time_t recordedTime = (time_t)(frame.timeNs / 1000000000LL);
+    frames++;
+
+    for (size_t i = 0; i < count; i++) {
+        auto it = recorded.find(frame.ids[i]);
+        if (it == recorded.end()) {
+            it = recorded.emplace(frame.ids[i],
+                                  Recorded{ frame.vx[i], frame.vy[i], frame.vz[i], nextEpoch++, 0 }).first;
+        } else if (it->second.vx != frame.vx[i] || it->second.vy != frame.vy[i] ||
+                   it->second.vz != frame.vz[i]) {
+            it->second.vx = frame.vx[i];
+            it->second.vy = frame.vy[i];
+            it->second.vz = frame.vz[i];
+            it->second.epoch = nextEpoch++;
+        }
+        it->second.lastFrame = frames;
+        out[i] = { frame.ids[i], frame.x[i], frame.y[i], frame.z[i],
+                   frame.vx[i], frame.vy[i], frame.vz[i], recordedTime, it->second.epoch };
+    }
+
+    // Forget aircraft that left, so one coming back gets a new epoch
+    if (recorded.size() > count) {
+        for (auto it = recorded.begin(); it != recorded.end(); ) {
+            it = (it->second.lastFrame == frames) ? std::next(it) : recorded.erase(it);
+        }
+    }
+}
+
+bool parseHistoryTime(const char* text, int64_t& ns) {
+    char* end;
+    double seconds = strtod(text, &end);
+    if (*end == '\0' && end != text) {
+        ns = (int64_t)(seconds * 1e9);
+        return true;
+    }
+
+    struct tm local;
+    memset(&local, 0, sizeof(local));
+    const char* rest = strptime(text, "%Y-%m-%d %H:%M:%S", &local);
+    if (!rest) {
+        return false;
+    }
+    double fraction = 0;
+    if (*rest == '.') {
+        fraction = strtod(rest, &end);
+        rest = end;
+    }
+    if (*rest != '\0') {
+        return false;
+    }
+    local.tm_isdst = -1;
+    ns = (int64_t)mktime(&local) * 1000000000LL + (int64_t)(fraction * 1e9);
+    return true;
+}
+
+void formatHistoryTime(char* buf, size_t size, int64_t ns) {
+    time_t seconds = (time_t)(ns / 1000000000LL);
+    struct tm local;
+    localtime_r(&seconds, &local);
+    size_t n = strftime(buf, size, "%Y-%m-%d %H:%M:%S", &local);
+    snprintf(buf + n, size - n, ".%03lld", (long long)(ns % 1000000000LL / 1000000));
+}
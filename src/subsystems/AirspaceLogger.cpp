@@ -1,18 +1,21 @@
 #include "AirspaceLogger.h"
 #include <iostream>
 #include <stdio.h>
-#include <sys/neutrino.h>
+#include "Ipc.h"
 #include <sys/mman.h>
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#include <thread>
 #include "utils.h"
 #include "shm_utils.h"
 
-AirspaceLogger::AirspaceLogger(const std::string &lp)
-    : logPath(lp), chid(-1)
+AirspaceLogger::AirspaceLogger(const std::string &hp)
+    : historyPath(hp), chid(-1), recording(false), framesMissed(0), framesReplayed(0)
 {
-    logAirspaceLoggerMessage("AirspaceLogger initialized with log path: " + lp);
+    logAirspaceLoggerMessage("AirspaceLogger initialized with history path: " + hp);
 }
 
 void AirspaceLogger::registerChannelId() {
@@ -36,40 +39,62 @@ void AirspaceLogger::registerChannelId() {
     }
 }
 
-void AirspaceLogger::logAirspaceState(const std::vector<Position> &positions,
-                                    const std::vector<Velocity> &velocities,
-                                    double timestamp)
-{
-    ensureLogDirectories();
-
-    FILE *fp = fopen(logPath.c_str(), "a");
-    if (!fp) {
-        logAirspaceLoggerMessage("Cannot open log file: " + logPath, LOG_ERROR);
-        return;
-    }
-    
-    fprintf(fp, "%s Logging at t=%.1f\n", printTimeStamp().c_str(), timestamp);
+void AirspaceLogger::recordFrames() {
+    RadarFrameReader reader(logAirspaceLoggerMessage);
+    std::vector<RadarTrack> tracks;
+    RadarFrameInfo info;
+    uint64_t lastSequence = 0;
     
-    for (size_t i = 0; i < positions.size(); i++) {
-        fprintf(fp, " Plane %d => (%.1f,%.1f,%.1f) / vel(%.1f,%.1f,%.1f)\n",
-                positions[i].planeId,
-                positions[i].x, positions[i].y, positions[i].z,
-                velocities[i].vx, velocities[i].vy, velocities[i].vz);
+    while (recording.load(std::memory_order_relaxed)) {
+        uint64_t sequence;
+        if (!reader.peekSequence(sequence) || sequence == lastSequence ||
+            !reader.read(tracks, &info)) {
+            usleep(HISTORY_POLL_MS * 1000);
+            continue;
+        }
+        
+        std::lock_guard<std::mutex> lock(historyMutex);
+        // A replay must not record its own history again; frames it
+        // publishes between polls are not missed either
+        if (info.flags & RADAR_FRAME_REPLAYED) {
+            if (framesReplayed == 0) {
+                LOG_AIRSPACE_LOGGER(LOG_INFO, "Radar is replaying a recorded history, "
+                                    "replayed frames are not recorded");
+            }
+            framesReplayed += (lastSequence != 0) ? (info.sequence - lastSequence) / 2 : 1;
+            lastSequence = info.sequence;
+            continue;
+        }
+        
+        // Radar advances the sequence by 2 per frame
+        if (lastSequence != 0 && info.sequence > lastSequence + 2) {
+            framesMissed += (info.sequence - lastSequence) / 2 - 1;
+        }
+        lastSequence = info.sequence;
+        
+        
+        if (!history.append(info.publishedNs, info.timestamp, info.sequence,
+                            tracks.data(), tracks.size())) {
+            LOG_AIRSPACE_LOGGER(LOG_WARNING, "Could not record radar frame ", info.sequence,
+                                " at t=", info.timestamp);
+        }
     }
-    
-    fprintf(fp, "------------------------\n");
-    fclose(fp);
-    
-    logAirspaceLoggerMessage("Logged " + std::to_string(positions.size()) + 
-                           " planes at timestamp " + std::to_string(timestamp));
+}
+
+void AirspaceLogger::checkpoint(double timestamp) {
+    std::lock_guard<std::mutex> lock(historyMutex);
+    history.sync();
+    LOG_AIRSPACE_LOGGER(LOG_INFO, "Airspace history at t=", timestamp, ": ", history.tickCount(),
+                        " frames, ", history.bytesUsed() / 1024, " KiB, ", framesMissed,
+                        " frames missed, ", framesReplayed, " replayed frames not recorded");
 }
 
 void AirspaceLogger::run() {
     ensureLogDirectories();
     
-    chid = ChannelCreate(0);
+    chid = ipcChannelCreate();
     if (chid == -1) {
-        logAirspaceLoggerMessage("ChannelCreate failed: " + 
+        logAirspaceLoggerMessage("Channel creation failed: " + 
                                std::string(strerror(errno)), LOG_ERROR);
         return;
     }
@@ -78,54 +103,55 @@ void AirspaceLogger::run() {
     
     registerChannelId();
 
+    if (history.open(historyPath)) {
+        logAirspaceLoggerMessage("Recording radar frames to " + historyPath + " (" +
+                               std::to_string(history.tickCount()) + " frames already recorded)");
+    } else {
+        logAirspaceLoggerMessage("Cannot open airspace history " + historyPath +
+                               ", radar frames will not be recorded", LOG_ERROR);
+    }
+    recording = history.isOpen();
+    std::thread recorder;
+    if (recording) {
+        recorder = std::thread(&AirspaceLogger::recordFrames, this);
+    }
+
     AirspaceLogMessage msg;
     
     while (true) {
         memset(&msg, 0, sizeof(msg));
         
-        int rcvid = MsgReceive(chid, &msg, sizeof(msg), nullptr);
+        int rcvid = ipcReceive(chid, &msg, sizeof(msg), nullptr);
         if (rcvid == -1) {
-            logAirspaceLoggerMessage("MsgReceive failed: " + 
+            logAirspaceLoggerMessage("Receive failed: " + 
                                    std::string(strerror(errno)), LOG_ERROR);
             sleep(1);  
             continue;
         }
         
-        logAirspaceLoggerMessage("Received message with command type: " + 
-                               std::to_string(msg.commandType), LOG_DEBUG);
+        LOG_AIRSPACE_LOGGER(LOG_DEBUG, "Received message with command type: ", msg.commandType);
         
         if (msg.commandType == COMMAND_LOG_AIRSPACE) {
-            MsgReply(rcvid, EOK, nullptr, 0);
-            
-            logAirspaceLoggerMessage("Received airspace log request for timestamp " + 
-                                   std::to_string(msg.timestamp));
-            
-            if (msg.numPlanes > 0 && msg.numPlanes <= MAX_PLANES) {
-                std::vector<Position> positions;
-                std::vector<Velocity> velocities;
-                
-                for (int i = 0; i < msg.numPlanes; i++) {
-                    positions.push_back(msg.positions[i]);
-                    velocities.push_back(msg.velocities[i]);
-                }
-                
-                logAirspaceState(positions, velocities, msg.timestamp);
-            } else {
-                logAirspaceLoggerMessage("Received invalid plane count: " + 
-                                      std::to_string(msg.numPlanes), LOG_WARNING);
-            }
+            ipcReply(rcvid, EOK, nullptr, 0);
+            checkpoint(msg.timestamp);
         } else if (msg.commandType == COMMAND_EXIT_THREAD) {
             logAirspaceLoggerMessage("Received exit command");
-            MsgReply(rcvid, EOK, nullptr, 0);
+            ipcReply(rcvid, EOK, nullptr, 0);
             break;
         } else {
             logAirspaceLoggerMessage("Unknown command type: " + 
                                    std::to_string(msg.commandType), LOG_WARNING);
-            MsgError(rcvid, ENOSYS);
+            ipcError(rcvid, ENOSYS);
         }
     }
     
-    ChannelDestroy(chid);
+    recording = false;
+    if (recorder.joinable()) {
+        recorder.join();
+    }
+    history.close();
+    
+    ipcChannelDestroy(chid);
     logAirspaceLoggerMessage("AirspaceLogger shutdown complete");
 }
 
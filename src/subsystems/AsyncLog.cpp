@@ -0,0 +1,503 @@
+#include "AsyncLog.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+namespace {
+
+const int MAX_LOG_FILES = 32;
+const uint8_t PADDING_RECORD = 0xFF;
+const size_t TIMESTAMP_LENGTH = 21;            // "[YYYY-mm-dd HH:MM:SS]"
+const size_t MAX_RECORD_BYTES = ASYNC_LOG_QUEUE_BYTES / 4;
+
+#ifdef IOV_MAX
+const int MAX_IOV = IOV_MAX;
+#else
+const int MAX_IOV = 1024;
+#endif
+
+/**
+ * Precedes every record in a queue. `size` covers the header, the text
+ * and padding to the next 8-byte boundary. A record that would wrap is
+ * preceded by a padding record filling the rest of the buffer, so the
+ * text of every record is contiguous and can be handed to writev().
+ */
+struct RecordHeader {
+    uint32_t size;
+    uint16_t length;
+    uint8_t file;
+    uint8_t level;
+};
+
+static_assert(sizeof(RecordHeader) == 8, "records are 8-byte aligned");
+static_assert(ASYNC_LOG_QUEUE_BYTES % 8 == 0, "queue must hold whole records");
+
+/** Ring of one thread's records; `head` and `tail` count bytes ever consumed/produced */
+struct LogQueue {
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    uint64_t cachedHead;                        // Producer's last view of head
+    std::atomic<uint64_t> dropped;              // Records the producer could not fit
+    uint64_t droppedReported;                   // Consumer-owned
+    std::atomic<bool> retired;                  // Owning thread has exited
+    alignas(8) char data[ASYNC_LOG_QUEUE_BYTES];
+
+    LogQueue() : head(0), tail(0), cachedHead(0), dropped(0), droppedReported(0), retired(false) {}
+};
+
+struct LogFile {
+    std::string path;
+    int fd;
+};
+
+/**
+ * Everything the writer owns. Leaked on purpose so threads that log
+ * while the process exits never see it destroyed; replaced in a forked
+ * child, whose copy may have been captured with its mutexes held.
+ */
+struct Registry {
+    std::mutex mutex;                           // Guards queues and files
+    std::vector<LogQueue*> queues;
+    LogFile files[MAX_LOG_FILES];
+    std::atomic<int> fileCount;
+
+    std::mutex drainMutex;                      // Held by whoever consumes the queues
+    std::vector<struct iovec> batches[MAX_LOG_FILES];
+    std::vector<struct iovec> console[2];       // stdout, stderr
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<bool> urgent;
+    std::atomic<bool> writerStarted;
+    std::atomic<bool> stopping;
+    std::atomic<bool> synchronous;              // Forked child, or exit() has begun
+    std::thread writer;
+
+    Registry() : fileCount(0), urgent(false), writerStarted(false), stopping(false),
+                 synchronous(false) {
+        for (int i = 0; i < MAX_LOG_FILES; i++) {
+            files[i].fd = -1;
+        }
+    }
+};
+
+std::atomic<Registry*> registry(nullptr);
+std::atomic<uint64_t> generation(0);           // Bumped in a forked child
+
+/** The calling thread's queue, retired when the thread exits */
+struct ThreadQueue {
+    LogQueue* queue = nullptr;
+    uint64_t generation = 0;
+
+    ~ThreadQueue() {
+        if (queue && generation == ::generation.load(std::memory_order_relaxed)) {
+            queue->retired.store(true, std::memory_order_release);
+        }
+        queue = nullptr;
+    }
+};
+
+thread_local ThreadQueue threadQueue;
+
+/** Second-resolution timestamp, formatted once per second per thread */
+struct TimestampCache {
+    time_t second = -1;
+    char text[32];
+};
+
+thread_local TimestampCache timestampCache;
+
+const char* levelName(LogLevel level, size_t* length) {
+    static const char* names[] = { "DEBUG", "INFO", "WARNING", "ERROR" };
+    static const size_t lengths[] = { 5, 4, 7, 5 };
+    int i = (level >= LOG_DEBUG && level <= LOG_ERROR) ? level : LOG_INFO;
+    *length = lengths[i];
+    return names[i];
+}
+
+void ensureLogDirectories() {
+    mkdir("/tmp/atc", 0777);
+    mkdir("/tmp/atc/logs", 0777);
+}
+
+/** writev() every part, resuming after short writes */
+void writeAll(int fd, struct iovec* iov, int count) {
+    while (count > 0) {
+        int parts = count < MAX_IOV ? count : MAX_IOV;
+        ssize_t written = writev(fd, iov, parts);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        while (parts > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            parts--;
+            count--;
+        }
+        if (parts > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+}
+
+int fileDescriptor(Registry* reg, int file) {
+    LogFile& f = reg->files[file];
+    if (f.fd == -1) {
+        ensureLogDirectories();
+        f.fd = open(f.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+        if (f.fd == -1) {
+            fprintf(stderr, "Failed to open log file: %s\n", f.path.c_str());
+        }
+    }
+    return f.fd;
+}
+
+/**
+ * Write out everything queued so far, one writev() per file. Caller
+ * holds drainMutex.
+ * @return true if any record was written
+ */
+bool drain(Registry* reg) {
+    std::vector<LogQueue*> queues;
+    {
+        std::lock_guard<std::mutex> lock(reg->mutex);
+        queues = reg->queues;
+    }
+
+    std::vector<uint64_t> ends(queues.size());
+    bool any = false;
+    for (size_t q = 0; q < queues.size(); q++) {
+        LogQueue* queue = queues[q];
+        uint64_t pos = queue->head.load(std::memory_order_relaxed);
+        uint64_t tail = queue->tail.load(std::memory_order_acquire);
+        while (pos < tail) {
+            char* slot = queue->data + pos % ASYNC_LOG_QUEUE_BYTES;
+            const RecordHeader* header = reinterpret_cast<const RecordHeader*>(slot);
+            if (header->file != PADDING_RECORD) {
+                struct iovec part = { slot + sizeof(RecordHeader), header->length };
+                reg->batches[header->file].push_back(part);
+                reg->console[header->level >= LOG_WARNING ? 1 : 0].push_back(part);
+                any = true;
+            }
+            pos += header->size;
+        }
+        ends[q] = pos;
+    }
+
+    int fileCount = reg->fileCount.load(std::memory_order_acquire);
+    for (int i = 0; i < fileCount; i++) {
+        std::vector<struct iovec>& batch = reg->batches[i];
+        if (!batch.empty()) {
+            int fd = fileDescriptor(reg, i);
+            if (fd != -1) {
+                writeAll(fd, batch.data(), (int)batch.size());
+            }
+            batch.clear();
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        if (!reg->console[i].empty()) {
+            writeAll(i == 0 ? STDOUT_FILENO : STDERR_FILENO,
+                     reg->console[i].data(), (int)reg->console[i].size());
+            reg->console[i].clear();
+        }
+    }
+
+    std::vector<LogQueue*> finished;
+    for (size_t q = 0; q < queues.size(); q++) {
+        LogQueue* queue = queues[q];
+        queue->head.store(ends[q], std::memory_order_release);
+
+        uint64_t dropped = queue->dropped.load(std::memory_order_relaxed);
+        if (dropped != queue->droppedReported) {
+            fprintf(stderr, "[AsyncLog] %llu log records dropped, queue full\n",
+                    (unsigned long long)(dropped - queue->droppedReported));
+            queue->droppedReported = dropped;
+        }
+
+        if (queue->retired.load(std::memory_order_acquire) &&
+            queue->tail.load(std::memory_order_acquire) == ends[q]) {
+            finished.push_back(queue);
+        }
+    }
+
+    if (!finished.empty()) {
+        std::lock_guard<std::mutex> lock(reg->mutex);
+        for (LogQueue* queue : finished) {
+            for (size_t i = 0; i < reg->queues.size(); i++) {
+                if (reg->queues[i] == queue) {
+                    reg->queues[i] = reg->queues.back();
+                    reg->queues.pop_back();
+                    break;
+                }
+            }
+            delete queue;
+        }
+    }
+    return any;
+}
+
+void writerLoop(Registry* reg) {
+    while (!reg->stopping.load(std::memory_order_acquire)) {
+        {
+            std::unique_lock<std::mutex> lock(reg->wakeMutex);
+            reg->wake.wait_for(lock, std::chrono::milliseconds(ASYNC_LOG_FLUSH_MS), [reg] {
+                return reg->urgent.load(std::memory_order_acquire) ||
+                       reg->stopping.load(std::memory_order_acquire);
+            });
+            reg->urgent.store(false, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lock(reg->drainMutex);
+        drain(reg);
+    }
+}
+
+/** Stop the writer and write what is left; later records are written synchronously */
+void shutdownAtExit() {
+    Registry* reg = registry.load(std::memory_order_acquire);
+    if (!reg || reg->synchronous.load(std::memory_order_acquire)) {
+        return;
+    }
+    if (reg->writerStarted.load(std::memory_order_acquire)) {
+        {
+            std::lock_guard<std::mutex> lock(reg->wakeMutex);
+            reg->stopping.store(true, std::memory_order_release);
+        }
+        reg->wake.notify_one();
+        reg->writer.join();
+    }
+    std::lock_guard<std::mutex> lock(reg->drainMutex);
+    reg->synchronous.store(true, std::memory_order_release);
+    drain(reg);
+}
+
+/** In a forked child, start over with a registry that has no writer */
+void resetInChild() {
+    Registry* parent = registry.load(std::memory_order_relaxed);
+    if (!parent) {
+        return;
+    }
+    Registry* child = new Registry();
+    int count = parent->fileCount.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; i++) {
+        child->files[i].path = parent->files[i].path;
+        child->files[i].fd = parent->files[i].fd;
+    }
+    child->fileCount.store(count, std::memory_order_relaxed);
+    child->synchronous.store(true, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_relaxed);
+    registry.store(child, std::memory_order_release);
+}
+
+Registry* getRegistry() {
+    Registry* reg = registry.load(std::memory_order_acquire);
+    if (reg) {
+        return reg;
+    }
+
+    static std::once_flag once;
+    std::call_once(once, [] {
+        registry.store(new Registry(), std::memory_order_release);
+        pthread_atfork(nullptr, nullptr, resetInChild);
+        atexit(shutdownAtExit);
+    });
+    return registry.load(std::memory_order_acquire);
+}
+
+void startWriter(Registry* reg) {
+    std::lock_guard<std::mutex> lock(reg->mutex);
+    if (!reg->writerStarted.load(std::memory_order_relaxed) &&
+        !reg->synchronous.load(std::memory_order_acquire)) {
+        reg->writer = std::thread(writerLoop, reg);
+        reg->writerStarted.store(true, std::memory_order_release);
+    }
+}
+
+LogQueue* queueForThread(Registry* reg) {
+    uint64_t gen = generation.load(std::memory_order_relaxed);
+    if (threadQueue.queue && threadQueue.generation == gen) {
+        return threadQueue.queue;
+    }
+
+    LogQueue* queue = new LogQueue();
+    {
+        std::lock_guard<std::mutex> lock(reg->mutex);
+        reg->queues.push_back(queue);
+    }
+    threadQueue.queue = queue;
+    threadQueue.generation = gen;
+    if (!reg->writerStarted.load(std::memory_order_acquire)) {
+        startWriter(reg);
+    }
+    return queue;
+}
+
+const char* timestamp() {
+    time_t now = time(nullptr);
+    if (now != timestampCache.second) {
+        struct tm local;
+        localtime_r(&now, &local);
+        strftime(timestampCache.text, sizeof(timestampCache.text), "[%Y-%m-%d %H:%M:%S]", &local);
+        timestampCache.second = now;
+    }
+    return timestampCache.text;
+}
+
+/**
+ * Refresh the producer's view of head; if the ring is still too full to
+ * reach `end`, wake the writer and give it up to ASYNC_LOG_FULL_WAIT_US
+ * to make room.
+ */
+bool waitForSpace(Registry* reg, LogQueue* queue, uint64_t end) {
+    queue->cachedHead = queue->head.load(std::memory_order_acquire);
+    if (end - queue->cachedHead <= ASYNC_LOG_QUEUE_BYTES) {
+        return true;
+    }
+    if (reg->synchronous.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    if (!reg->urgent.exchange(true, std::memory_order_acq_rel)) {
+        reg->wake.notify_one();
+    }
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::microseconds(ASYNC_LOG_FULL_WAIT_US);
+    do {
+        std::this_thread::yield();
+        queue->cachedHead = queue->head.load(std::memory_order_acquire);
+        if (end - queue->cachedHead <= ASYNC_LOG_QUEUE_BYTES) {
+            return true;
+        }
+    } while (std::chrono::steady_clock::now() < deadline);
+    return false;
+}
+
+inline char* append(char* out, const char* text, size_t length) {
+    memcpy(out, text, length);
+    return out + length;
+}
+
+} // namespace
+
+std::atomic<int> asyncLogThreshold(LOG_INFO);
+
+void setLogLevel(LogLevel level) {
+    asyncLogThreshold.store(level, std::memory_order_relaxed);
+}
+
+int asyncLogOpen(const char* path) {
+    Registry* reg = getRegistry();
+    std::lock_guard<std::mutex> lock(reg->mutex);
+    int count = reg->fileCount.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; i++) {
+        if (reg->files[i].path == path) {
+            return i;
+        }
+    }
+    if (count == MAX_LOG_FILES) {
+        return -1;
+    }
+    reg->files[count].path = path;
+    reg->files[count].fd = -1;
+    reg->fileCount.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+void asyncLogWrite(int file, LogLevel level, const char* subsystem,
+                   const char* message, size_t length) {
+    if (file < 0 || file >= MAX_LOG_FILES) {
+        return;
+    }
+    Registry* reg = getRegistry();
+    LogQueue* queue = queueForThread(reg);
+
+    size_t levelLength;
+    const char* levelText = levelName(level, &levelLength);
+    size_t subsystemLength = strlen(subsystem);
+    size_t prefixLength = TIMESTAMP_LENGTH + 2 + subsystemLength + 3 + levelLength + 2;
+    size_t maxMessage = MAX_RECORD_BYTES - sizeof(RecordHeader) - prefixLength - 1;
+    if (length > maxMessage) {
+        length = maxMessage;
+    }
+    size_t textLength = prefixLength + length + 1;
+    size_t recordSize = (sizeof(RecordHeader) + textLength + 7) & ~(size_t)7;
+
+    uint64_t tail = queue->tail.load(std::memory_order_relaxed);
+    size_t offset = tail % ASYNC_LOG_QUEUE_BYTES;
+    size_t contiguous = ASYNC_LOG_QUEUE_BYTES - offset;
+    size_t padding = contiguous < recordSize ? contiguous : 0;
+    if (tail + padding + recordSize - queue->cachedHead > ASYNC_LOG_QUEUE_BYTES &&
+        !waitForSpace(reg, queue, tail + padding + recordSize)) {
+        queue->dropped.store(queue->dropped.load(std::memory_order_relaxed) + 1,
+                             std::memory_order_relaxed);
+        return;
+    }
+
+    if (padding) {
+        RecordHeader* pad = reinterpret_cast<RecordHeader*>(queue->data + offset);
+        pad->size = (uint32_t)padding;
+        pad->length = 0;
+        pad->file = PADDING_RECORD;
+        pad->level = 0;
+        tail += padding;
+        offset = 0;
+    }
+
+    RecordHeader* header = reinterpret_cast<RecordHeader*>(queue->data + offset);
+    header->size = (uint32_t)recordSize;
+    header->length = (uint16_t)textLength;
+    header->file = (uint8_t)file;
+    header->level = (uint8_t)level;
+
+    char* out = queue->data + offset + sizeof(RecordHeader);
+    out = append(out, timestamp(), TIMESTAMP_LENGTH);
+    out = append(out, " [", 2);
+    out = append(out, subsystem, subsystemLength);
+    out = append(out, "] [", 3);
+    out = append(out, levelText, levelLength);
+    out = append(out, "] ", 2);
+    out = append(out, message, length);
+    *out = '\n';
+
+    queue->tail.store(tail + recordSize, std::memory_order_release);
+
+    if (reg->synchronous.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(reg->drainMutex);
+        drain(reg);
+    } else if ((level >= LOG_WARNING ||
+                tail + recordSize - queue->cachedHead > ASYNC_LOG_QUEUE_BYTES / 2) &&
+               !reg->urgent.exchange(true, std::memory_order_acq_rel)) {
+        // Warnings, and queues filling up faster than the flush interval,
+        // do not wait for the writer's next tick
+        reg->wake.notify_one();
+    }
+}
+
+void asyncLogFlush() {
+    Registry* reg = registry.load(std::memory_order_acquire);
+    if (!reg) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(reg->drainMutex);
+    drain(reg);
+}
@@ -7,21 +7,40 @@
 #include <cmath>
 #include <sys/stat.h>
 #include "utils.h"
+#include "EventLog.h"
 #include "shm_utils.h"
 
 CommunicationSystem::CommunicationSystem(const std::string& logPath)
-    : transmissionLogPath(logPath)
+    : transmissionLogPath(logPath), running(true), uplinkSegment(logCommunicationSystemMessage)
 {
     logCommunicationSystemMessage("CommunicationSystem initialized");
 }
 
 
-void CommunicationSystem::send(int planeId, const Command& command) {
-    std::string msg = "Direct send to plane=" + std::to_string(planeId)
+void CommunicationSystem::send(int planeId, Command command) {
+    std::string msg = "Transmit #" + std::to_string(command.sequence)
+                    + " to plane=" + std::to_string(planeId)
                     + " code=" + std::to_string(command.code)
                     + " val(" + std::to_string(command.value[0]) + ","
                               + std::to_string(command.value[1]) + ","
                               + std::to_string(command.value[2]) + ")";
+
+    CommandRingHeader* uplink = openCommandRing(uplinkSegment, SHM_UPLINK);
+    command.transmittedNs = monotonicNanos();
+    if (!uplink) {
+        logCommunicationSystemMessage("Uplink unavailable, dropped command #" +
+                                    std::to_string(command.sequence), LOG_ERROR);
+        return;
+    }
+    if (!commandRingPush(uplink, command)) {
+        logCommunicationSystemMessage("Uplink full (" + std::to_string(uplink->capacity) +
+                                    " pending), dropped command #" +
+                                    std::to_string(command.sequence), LOG_ERROR);
+        return;
+    }
+
+    EVENT_LOG(EVSUB_COMMUNICATION_SYSTEM, EVT_COMMAND_TRANSMITTED, command.sequence, planeId,
+              command.value[0], command.value[1], command.value[2]);
     logTransmission(msg);
     logCommunicationSystemMessage(msg);
 }
@@ -41,26 +60,27 @@ void CommunicationSystem::logTransmission(const std::string& message) {
 void CommunicationSystem::run() {
     logCommunicationSystemMessage("Communication system starting");
     
-    while (true) {
-        bool success = accessSharedMemory<CommandQueue>(
-            SHM_COMMANDS, 
-            sizeof(CommandQueue), 
-            O_RDWR, 
-            false,
-            [this](CommandQueue* cq) {
-                if (cq->head != cq->tail) {
-                    Command cmd = cq->commands[cq->head];
-                    cq->head = (cq->head + 1) % MAX_COMMANDS;
-                    send(cmd.planeId, cmd);
-                } else {
-                    usleep(100000); 
-                }
+    SharedMemorySegment commandSegment(logCommunicationSystemMessage);
+    CommandRingHeader* ring = nullptr;
+    
+    while (running) {
+        if (!ring) {
+            ring = openCommandRing(commandSegment, SHM_COMMANDS);
+            if (!ring) {
+                logCommunicationSystemMessage("Failed to access command queue, retrying...", LOG_WARNING);
+                sleep(1);
+                continue;
             }
-        );
+            logCommunicationSystemMessage("Command ring mapped with capacity " +
+                                        std::to_string(ring->capacity));
+        }
         
-        if (!success) {
-            logCommunicationSystemMessage("Failed to access command queue, retrying...", LOG_WARNING);
-            sleep(1);
+        // Wake up at least once a second to notice stop()
+        Command cmd;
+        if (commandRingPop(ring, cmd, 1000)) {
+            send(cmd.planeId, cmd);
         }
     }
-}
\ No newline at end of file
+    
+    logCommunicationSystemMessage("Communication system stopped");
+}
@@ -5,12 +5,14 @@
 #include <unistd.h>
 #include <cmath>
 #include <cstring>
-#include <sys/neutrino.h>
+#include <algorithm>
+#include "Ipc.h"
 #include <thread> 
 #include <errno.h>
 #include "commandCodes.h"
 #include "utils.h"
 #include "shm_utils.h"
+#include "EventLog.h"
 
 
  ComputerSystem::ComputerSystem(double predTime)
@@ -22,12 +24,23 @@
    MIN_VERTICAL_SEPARATION(1000.0),
    MIN_HORIZONTAL_SEPARATION(3000.0),
    congestionDegreeSeconds(120),
+   displayIntervalMs(DEFAULT_DISPLAY_INTERVAL_MS),
    violationCheckInProgress(false),
    logInProgress(false),
-   emergencyEvent(false)
+   emergencyEvent(false),
+   connections(logComputerSystemMessage),
+   radarReader(logComputerSystemMessage),
+   commandSegment(logComputerSystemMessage),
+   ackSegment(logComputerSystemMessage),
+   nextCommandSequence(1),
+   commandsAcked(0),
+   lastViolationSequence(0),
+   conflictDetector(MIN_HORIZONTAL_SEPARATION, MIN_VERTICAL_SEPARATION, congestionDegreeSeconds)
 {
+ conflictDetector.setThreadPool(&detectionPool);
  logComputerSystemMessage("ComputerSystem initialized with prediction time: " + 
-                        std::to_string(predTime) + "s");
+                        std::to_string(predTime) + "s, conflict detection on " +
+                        std::to_string(detectionPool.size()) + " threads");
 }
 
 
@@ -116,9 +129,9 @@ void ComputerSystem::registerChannelId()
 }
 
 void ComputerSystem::run() {
-    chid = ChannelCreate(0);
+    chid = ipcChannelCreate();
     if (chid == -1) {
-        logComputerSystemMessage("ChannelCreate failed: " + std::string(strerror(errno)), LOG_ERROR);
+        logComputerSystemMessage("Channel creation failed: " + std::string(strerror(errno)), LOG_ERROR);
         return;
     }
 
@@ -145,118 +158,97 @@ void ComputerSystem::createPeriodicTasks()
     struct
     {
         int code;
-        int interval;
+        int intervalMs;
         std::string description;
     } tasks[] = {
-        {AIRSPACE_VIOLATION_CONSTRAINT_TIMER, 1, "Airspace violation check"},
-        {OPERATOR_COMMAND_CHECK_TIMER, 1, "Operator command check"},
-        {LOG_AIRSPACE_TO_CONSOLE_TIMER, 5, "Log airspace to console"},
-        {LOG_AIRSPACE_TO_FILE_TIMER, 20, "Log airspace to file"},
-        {LOG_AIRSPACE_TO_LOGGER_TIMER, 20, "Send log to AirspaceLogger"}
+        {AIRSPACE_VIOLATION_CONSTRAINT_TIMER, 1000, "Airspace violation check"},
+        {OPERATOR_COMMAND_CHECK_TIMER, 1000, "Operator command check"},
+        {LOG_AIRSPACE_TO_CONSOLE_TIMER, displayIntervalMs, "Log airspace to console"},
+        {LOG_AIRSPACE_TO_FILE_TIMER, 20000, "Log airspace to file"},
+        {LOG_AIRSPACE_TO_LOGGER_TIMER, 20000, "Send log to AirspaceLogger"}
     };
     int nTasks = sizeof(tasks) / sizeof(tasks[0]);
 
-    int coid = ConnectAttach(0, 0, chid, _NTO_SIDE_CHANNEL, 0);
-    if (coid == -1)
-    {
-        logComputerSystemMessage("ConnectAttach failed: " + std::string(strerror(errno)), LOG_ERROR);
-        return;
-    }
-
     for (int i = 0; i < nTasks; i++)
     {
-        struct sigevent sev;
-        SIGEV_PULSE_INIT(&sev, coid, SIGEV_PULSE_PRIO_INHERIT, tasks[i].code, 0);
-        timer_t tid;
-        if (timer_create(CLOCK_MONOTONIC, &sev, &tid) == -1)
+        if (ipcTimerCreate(chid, tasks[i].code, tasks[i].intervalMs) == -1)
         {
             logComputerSystemMessage("Failed to create timer for " + 
                                    tasks[i].description + ": " + 
                                    std::string(strerror(errno)), LOG_ERROR);
-            continue;
-        }
-        
-        struct itimerspec its;
-        its.it_value.tv_sec = tasks[i].interval;
-        its.it_value.tv_nsec = 0;
-        its.it_interval.tv_sec = tasks[i].interval;
-        its.it_interval.tv_nsec = 0;
-        
-        if (timer_settime(tid, 0, &its, NULL) == -1) {
-            logComputerSystemMessage("Failed to set timer for " + 
-                                   tasks[i].description + ": " + 
-                                   std::string(strerror(errno)), LOG_ERROR);
         } else {
             logComputerSystemMessage("Created periodic task: " + 
                                    tasks[i].description + " every " + 
-                                   std::to_string(tasks[i].interval) + "s");
+                                   std::to_string(tasks[i].intervalMs) + " ms");
         }
     }
 }
 
 void ComputerSystem::listen()
 {
-    struct
-    {
-        _pulse hdr;
+    union {
         int command;
-    } msg;
-
+        DisplaySubscribeMessage subscription;
+    } message;
+    IpcPulse pulse;
     int rcvid;
-    double currentTime = 0.0;
 
     logComputerSystemMessage("Starting message processing loop");
 
     while (true)
     {
-        rcvid = MsgReceive(chid, &msg, sizeof(msg), NULL);
+        rcvid = ipcReceive(chid, &message, sizeof(message), &pulse);
         if (rcvid == 0)
         {
-            handlePulse(msg.hdr.code, currentTime);
+            handlePulse(pulse.code);
         }
         else if (rcvid > 0)
         {
-            switch (msg.command)
+            switch (message.command)
             {
             case COMMAND_EXIT_THREAD:
                 logComputerSystemMessage("Received exit command");
-                MsgReply(rcvid, EOK, NULL, 0);
+                ipcReply(rcvid, EOK, NULL, 0);
                 return;
+            case COMMAND_DISPLAY_SUBSCRIBE:
+            case COMMAND_DISPLAY_UNSUBSCRIBE:
+                handleSubscription(rcvid, message.subscription);
+                break;
             default:
                 logComputerSystemMessage("Unknown message command: " + 
-                                       std::to_string(msg.command), LOG_WARNING);
-                MsgError(rcvid, ENOSYS);
+                                       std::to_string(message.command), LOG_WARNING);
+                ipcError(rcvid, ENOSYS);
                 break;
             }
         }
         else
         {
-            logComputerSystemMessage("MsgReceive failed: " + 
+            logComputerSystemMessage("Receive failed: " + 
                                    std::string(strerror(errno)), LOG_ERROR);
         }
     }
 }
 
-void ComputerSystem::handlePulse(int code, double &currentTime)
+void ComputerSystem::handlePulse(int code)
 {
-    currentTime += 1.0;
-
     switch (code)
     {
     case AIRSPACE_VIOLATION_CONSTRAINT_TIMER:
+    case EMERGENCY_VIOLATION_CHECK_PULSE:
         if (!violationCheckInProgress.exchange(true))
         {
-            violationCheck();
+            violationCheck(code == EMERGENCY_VIOLATION_CHECK_PULSE);
             violationCheckInProgress = false;
         }
         else
         {
-            logComputerSystemMessage("Skipping violation check, previous check still in progress", LOG_DEBUG);
+            LOG_COMPUTER_SYSTEM(LOG_DEBUG, "Skipping violation check, previous check still in progress");
         }
         break;
 
     case OPERATOR_COMMAND_CHECK_TIMER:
         opConCheck();
+        collectCommandAcks();
         break;
 
     case LOG_AIRSPACE_TO_CONSOLE_TIMER:
@@ -268,12 +260,21 @@ void ComputerSystem::handlePulse(int code, double &currentTime)
         }
         else
         {
-            logComputerSystemMessage("Skipping log operation, previous log still in progress", LOG_DEBUG);
+            LOG_COMPUTER_SYSTEM(LOG_DEBUG, "Skipping log operation, previous log still in progress");
+        }
+
+        if (code == LOG_AIRSPACE_TO_FILE_TIMER)
+        {
+            logComputerSystemMessage("IPC connections: " +
+                                   std::to_string(connections.getConnects()) + " connects, " +
+                                   std::to_string(connections.getReconnects()) + " reconnects, " +
+                                   std::to_string(connections.getFailures()) + " failures");
+            reportCommandLatency();
         }
         break;
 
     case LOG_AIRSPACE_TO_LOGGER_TIMER:
-        sendLogToAirspaceLogger(currentTime);
+        sendLogToAirspaceLogger();
         break;
 
     default:
@@ -282,96 +283,40 @@ void ComputerSystem::handlePulse(int code, double &currentTime)
     }
 }
 
-void ComputerSystem::sendLogToAirspaceLogger(double currentTime)
+void ComputerSystem::sendLogToAirspaceLogger()
 {
-    if (loggerChid == -1 || loggerPid == -1)
+    int coid = connections.get(ENDPOINT_LOGGER);
+    if (coid == -1)
     {
-        bool success = accessSharedMemory<ChannelIds>(
-            SHM_CHANNELS,
-            sizeof(ChannelIds),
-            O_RDONLY,
-            false,
-            [this](ChannelIds* channels) {
-                loggerChid = channels->loggerChid;
-                loggerPid = channels->loggerPid;
-            }
-        );
-
-        if (!success || loggerChid == -1 || loggerPid == -1)
-        {
-            logComputerSystemMessage("AirspaceLogger not ready yet, skipping log", LOG_WARNING);
-            return;
-        }
+        logComputerSystemMessage("AirspaceLogger not reachable, skipping log", LOG_WARNING);
+        return;
     }
 
-    int coid = ConnectAttach(0, loggerPid, loggerChid, _NTO_SIDE_CHANNEL, 0);
-    if (coid == -1)
+    // AirspaceLogger records every radar frame itself; this is a checkpoint,
+    // so only the frame header is read, for its simulation time and size
+    RadarFrameInfo info;
+    if (!radarReader.readInfo(info))
     {
-        logComputerSystemMessage("Failed to connect to AirspaceLogger: " + 
-                               std::string(strerror(errno)), LOG_ERROR);
+        logComputerSystemMessage("No radar frame to checkpoint, skipping log", LOG_WARNING);
         return;
     }
 
     AirspaceLogMessage logMsg;
     logMsg.commandType = COMMAND_LOG_AIRSPACE;
-    logMsg.timestamp = currentTime;
-    logMsg.numPlanes = 0;
-
-    bool success = accessSharedMemory<RadarData>(
-        SHM_RADAR_DATA,
-        sizeof(RadarData),
-        O_RDONLY,
-        false,
-        [&logMsg](RadarData* rd) {
-            logMsg.numPlanes = (rd->numPlanes > MAX_PLANES) ? MAX_PLANES : rd->numPlanes;
-            for (int i = 0; i < logMsg.numPlanes; i++) {
-                logMsg.positions[i] = rd->positions[i];
-                logMsg.velocities[i] = rd->velocities[i];
-            }
-        }
-    );
+    logMsg.timestamp = info.timestamp;
+    logMsg.numPlanes = static_cast<int>(info.numPlanes);
 
-    if (success)
+    if (ipcSend(coid, &logMsg, sizeof(logMsg), NULL, 0) == -1)
     {
-        if (MsgSend(coid, &logMsg, sizeof(logMsg), NULL, 0) == -1)
-        {
-            logComputerSystemMessage("Failed to send log to AirspaceLogger: " + 
-                                   std::string(strerror(errno)), LOG_ERROR);
-        }
-        else
-        {
-            logComputerSystemMessage("Sent airspace log to AirspaceLogger with " + 
-                                   std::to_string(logMsg.numPlanes) + " planes");
-        }
+        logComputerSystemMessage("Failed to send log to AirspaceLogger: " + 
+                               std::string(strerror(errno)), LOG_ERROR);
+        connections.invalidate(ENDPOINT_LOGGER, coid);
     }
-    
-    ConnectDetach(coid);
-}
-
-double ComputerSystem::calculateTimeToMinimumDistance(const Position &pos1, const Velocity &vel1,
-                                                    const Position &pos2, const Velocity &vel2)
-{
-    // Calculate relative velocity
-    double dvx = vel1.vx - vel2.vx;
-    double dvy = vel1.vy - vel2.vy;
-    double dvz = vel1.vz - vel2.vz;
-
-    // Calculate relative position
-    double dx = pos1.x - pos2.x;
-    double dy = pos1.y - pos2.y;
-    double dz = pos1.z - pos2.z;
-
-    // Calculate time to minimum distance (first derivative of distance function set to zero)
-    double t = 0;
-    double denom = dvx * dvx + dvy * dvy + dvz * dvz;
-
-    if (denom > 0.001)
-    { // Avoid division by near-zero
-        t = -(dx * dvx + dy * dvy + dz * dvz) / denom;
+    else
+    {
+        logComputerSystemMessage("Sent airspace checkpoint to AirspaceLogger with " + 
+                               std::to_string(logMsg.numPlanes) + " planes");
     }
-
-    // If time is negative, closest approach already happened
-    return (t > 0) ? t : 0;
 }
 
 bool ComputerSystem::checkSeparation(const Position &p1, const Position &p2) const
@@ -406,100 +351,111 @@ bool ComputerSystem::predictSeparation(const Position &pos1, const Velocity &vel
     return checkSeparation(fut1, fut2);
 }
 
-void ComputerSystem::violationCheck()
+void ComputerSystem::violationCheck(bool force)
 {
-    bool success = accessSharedMemory<RadarData>(
-        SHM_RADAR_DATA,
-        sizeof(RadarData),
-        O_RDONLY,
-        false,
-        [this](RadarData* rd) {
-            positionsSnapshot.clear();
-            velocitiesSnapshot.clear();
-            
-            for (int i = 0; i < rd->numPlanes; i++)
-            {positionsSnapshot.push_back(rd->positions[i]);
-                velocitiesSnapshot.push_back(rd->velocities[i]);
-            }
-        }
-    );
+    // Nothing to re-check if Radar has not published a new frame since the last pass
+    uint64_t sequence = 0;
+    if (!force && radarReader.peekSequence(sequence) && 
+        lastViolationSequence != 0 && sequence == lastViolationSequence) {
+        LOG_COMPUTER_SYSTEM(LOG_DEBUG, "Radar frame unchanged, skipping violation check");
+        return;
+    }
+
+    std::vector<RadarTrack> tracks;
+    RadarFrameInfo info;
+    bool success = radarReader.read(tracks, &info);
 
     if (!success) {
         logComputerSystemMessage("Failed to read radar data for violation check", LOG_ERROR);
         return;
     }
+    lastViolationSequence = info.sequence;
+
+    positionsSnapshot.clear();
+    velocitiesSnapshot.clear();
+    positionsSnapshot.reserve(tracks.size());
+    velocitiesSnapshot.reserve(tracks.size());
 
-    int n = static_cast<int>(positionsSnapshot.size());
-    for (int i = 0; i < n; i++)
+    for (const RadarTrack& t : tracks)
     {
-        for (int j = i + 1; j < n; j++)
-        {
-            checkForFutureViolation(
-                positionsSnapshot[i], velocitiesSnapshot[i],
-                positionsSnapshot[j], velocitiesSnapshot[j],
-                positionsSnapshot[i].planeId,
-                positionsSnapshot[j].planeId);
-        }
+        positionsSnapshot.push_back({t.planeId, t.x, t.y, t.z, t.timestamp});
+        velocitiesSnapshot.push_back({t.planeId, t.vx, t.vy, t.vz, t.timestamp});
     }
+
+    conflictDetector.setHorizon(congestionDegreeSeconds);
+    conflictDetector.detect(tracks, info.timestamp, conflicts);
+    conflictIds.clear();
+    for (const Conflict& c : conflicts) {
+        conflictIds.push_back(c.plane1);
+        conflictIds.push_back(c.plane2);
+    }
+    std::sort(conflictIds.begin(), conflictIds.end());
+    conflictIds.erase(std::unique(conflictIds.begin(), conflictIds.end()), conflictIds.end());
+    LOG_COMPUTER_SYSTEM(LOG_DEBUG, "Violation check evaluated ",
+                        conflictDetector.getPairsEvaluated(), " pairs (",
+                        conflictDetector.getChangedCount(), " aircraft changed",
+                        (conflictDetector.wasRebuilt() ? ", full pass)" : ")"));
+    EVENT_LOG(EVSUB_COMPUTER_SYSTEM, EVT_VIOLATION_CHECK, conflictDetector.getPairsEvaluated(),
+              conflictDetector.getChangedCount(), conflicts.size(), conflictDetector.wasRebuilt());
+
+    reportViolations(conflicts, info.timestamp);
 }
 
-void ComputerSystem::checkForFutureViolation(const Position &pos1, const Velocity &vel1,
-                                           const Position &pos2, const Velocity &vel2,
-                                           int plane1, int plane2)
+void ComputerSystem::reportViolations(const std::vector<Conflict> &found, double frameTimestamp)
 {
-    double timeToClosestApproach = calculateTimeToMinimumDistance(pos1, vel1, pos2, vel2);
+    if (found.empty()) {
+        return;
+    }
 
-    if (timeToClosestApproach <= congestionDegreeSeconds)
-    {
-        // Calculate positions at closest approach
-        Vec3 p1 = {pos1.x, pos1.y, pos1.z};
-        p1 = p1.sum(Vec3{vel1.vx, vel1.vy, vel1.vz}.scalarMultiplication(timeToClosestApproach));
+    size_t n = std::min(found.size(), (size_t)MAX_ALERTS_PER_BATCH);
+    if (n < found.size()) {
+        logComputerSystemMessage("Alert batch truncated from " + std::to_string(found.size()) +
+                               " to " + std::to_string(n) + " conflicts", LOG_WARNING);
+    }
 
-        Vec3 p2 = {pos2.x, pos2.y, pos2.z};
-        p2 = p2.sum(Vec3{vel2.vx, vel2.vy, vel2.vz}.scalarMultiplication(timeToClosestApproach));
+    alertBatch.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        alertBatch[i] = { found[i].plane1, found[i].plane2, found[i].timeToClosestApproach };
+        LOG_COMPUTER_SYSTEM(LOG_DEBUG, "ALERT: Planes ", found[i].plane1, " and ", found[i].plane2,
+                            " will violate separation in ", found[i].timeToClosestApproach,
+                            " seconds");
+        EVENT_LOG(EVSUB_COMPUTER_SYSTEM, EVT_CONFLICT, found[i].plane1, found[i].plane2,
+                  found[i].timeToClosestApproach);
+    }
 
-        // Check separation at closest approach
-        double dx = fabs(p1.x - p2.x);
-        double dy = fabs(p1.y - p2.y);
-        double dz = fabs(p1.z - p2.z);
+    // One message per detection cycle: header followed by every alert
+    OperatorConsoleAlertBatchMessage msg;
+    msg.systemCommandType = OPCON_CONSOLE_COMMAND_ALERT_BATCH;
+    msg.numAlerts = (uint32_t)n;
+    msg.frameTimestamp = frameTimestamp;
 
-        double horizontalSeparation = sqrt(dx * dx + dy * dy);
+    IpcIov iov[2] = {
+        { &msg, sizeof(msg) },
+        { alertBatch.data(), n * sizeof(ConflictAlert) }
+    };
 
-        // Check if they violate separation
-        if (dz < MIN_VERTICAL_SEPARATION && horizontalSeparation < MIN_HORIZONTAL_SEPARATION)
-        {
-            int coid = ConnectAttach(0, operatorPid, operatorChid, _NTO_SIDE_CHANNEL, 0);
-            if (coid != -1)
-            {
-                OperatorConsoleCommandMessage alert;
-                alert.systemCommandType = OPCON_CONSOLE_COMMAND_ALERT;
-                alert.plane1 = plane1;
-                alert.plane2 = plane2;
-                alert.collisionTimeSeconds = timeToClosestApproach;
-                OperatorConsoleResponseMessage r;
-                
-                if (MsgSend(coid, &alert, sizeof(alert), &r, sizeof(r)) == -1) {
-                    logComputerSystemMessage("Failed to send violation alert to operator: " + 
-                                           std::string(strerror(errno)), LOG_ERROR);
-                }
-                
-                ConnectDetach(coid);
+    int coid = connections.get(ENDPOINT_OPERATOR);
+    if (coid == -1) {
+        logComputerSystemMessage("OperatorConsole not reachable, " + std::to_string(n) +
+                               " alerts not delivered", LOG_ERROR);
+        return;
+    }
 
-                logComputerSystemMessage("ALERT: Planes " + std::to_string(plane1) + 
-                                       " and " + std::to_string(plane2) +
-                                       " will violate separation in " + 
-                                       std::to_string(timeToClosestApproach) + " seconds", LOG_WARNING);
-            }
-        }
+    if (ipcSendv(coid, iov, 2, NULL, 0) == -1) {
+        logComputerSystemMessage("Failed to send violation alerts to operator: " + 
+                               std::string(strerror(errno)), LOG_ERROR);
+        connections.invalidate(ENDPOINT_OPERATOR, coid);
+    } else {
+        logComputerSystemMessage("ALERT: " + std::to_string(n) +
+                               " predicted separation violations sent to operator", LOG_WARNING);
     }
 }
 
 void ComputerSystem::opConCheck()
 {
-    int coid = ConnectAttach(0, operatorPid, operatorChid, _NTO_SIDE_CHANNEL, 0);
+    int coid = connections.get(ENDPOINT_OPERATOR);
     if (coid == -1) {
-        logComputerSystemMessage("Failed to connect to OperatorConsole: " + 
-                               std::string(strerror(errno)), LOG_ERROR);
+        logComputerSystemMessage("OperatorConsole not reachable", LOG_ERROR);
         return;
     }
 
@@ -507,14 +463,13 @@ void ComputerSystem::opConCheck()
     sendMsg.systemCommandType = OPCON_CONSOLE_COMMAND_GET_USER_COMMAND;
     OperatorConsoleResponseMessage rcvMsg;
 
-    if (MsgSend(coid, &sendMsg, sizeof(sendMsg), &rcvMsg, sizeof(rcvMsg)) == -1)
+    if (ipcSend(coid, &sendMsg, sizeof(sendMsg), &rcvMsg, sizeof(rcvMsg)) == -1)
     {
         logComputerSystemMessage("Failed to get user command from OperatorConsole: " + 
                                std::string(strerror(errno)), LOG_ERROR);
-        ConnectDetach(coid);
+        connections.invalidate(ENDPOINT_OPERATOR, coid);
         return;
     }
-    ConnectDetach(coid);
 
     switch (rcvMsg.userCommandType)
     {
@@ -536,7 +491,8 @@ void ComputerSystem::opConCheck()
     case OPCON_USER_COMMAND_SET_PLANE_VELOCITY:
         logComputerSystemMessage("Sending velocity update for plane " + 
                                std::to_string(rcvMsg.planeNumber));
-        sendVelocityUpdateToComm(rcvMsg.planeNumber, rcvMsg.newVelocity);
+        sendVelocityUpdateToComm(rcvMsg.planeNumber, rcvMsg.newVelocity,
+                                 rcvMsg.issuedNs > 0 ? rcvMsg.issuedNs : monotonicNanos());
         break;
         
     default:
@@ -548,71 +504,143 @@ void ComputerSystem::opConCheck()
 
 void ComputerSystem::logSystem(bool toFile) {
     // Read the current plane data
-    std::vector<int> ids;
-    std::vector<Vec3> poss, vels;
+    std::vector<RadarTrack> tracks;
+    std::vector<AircraftDisplayEntry> entries;
     
-    bool success = accessSharedMemory<RadarData>(
-        SHM_RADAR_DATA,
-        sizeof(RadarData),
-        O_RDONLY,
-        false,
-        [&ids, &poss, &vels](RadarData* rd) {
-            for (int i = 0; i < rd->numPlanes; i++) {
-                // Only include valid data
-                if (rd->positions[i].planeId >= 0) {
-                    ids.push_back(rd->positions[i].planeId);
-                    Vec3 p = {rd->positions[i].x, rd->positions[i].y, rd->positions[i].z};
-                    Vec3 v = {rd->velocities[i].vx, rd->velocities[i].vy, rd->velocities[i].vz};
-                    poss.push_back(p);
-                    vels.push_back(v);
-                }
+    bool success = radarReader.read(tracks);
+    if (success) {
+        entries.reserve(tracks.size());
+        for (const RadarTrack& t : tracks) {
+            // Only include valid data
+            if (t.planeId >= 0) {
+                // DataDisplay keeps aircraft in conflict visible by id however busy the grid
+                uint32_t flags = std::binary_search(conflictIds.begin(), conflictIds.end(), t.planeId) ?
+                                 AIRCRAFT_IN_CONFLICT : 0;
+                entries.push_back({t.planeId, flags, {t.x, t.y, t.z}, {t.vx, t.vy, t.vz}});
             }
         }
-    );
+    }
     
-    if (!success || ids.empty()) {
+    if (!success || entries.empty()) {
         logComputerSystemMessage("No valid radar data for logging", LOG_WARNING);
         return;
     }
+
+    if (displays.size() > 0) {
+        sendToSubscribers(toFile ? COMMAND_LOG : COMMAND_GRID, entries);
+    }
+
+    // The display in /shm_channels gets the whole airspace, unless it subscribed to part of it
+    int displayChid;
+    pid_t displayPid;
+    if (connections.peer(ENDPOINT_DISPLAY, displayChid, displayPid) && displays.contains(displayPid, displayChid)) {
+        return;
+    }
     
     dataDisplayCommandMessage msg;
     memset(&msg, 0, sizeof(msg));
     
     msg.commandType = (toFile) ? COMMAND_LOG : COMMAND_GRID;
     
-    size_t n = ids.size();
-    if (n > MAX_PLANES) {
-        logComputerSystemMessage("Too many planes for message, truncating to " + 
-                               std::to_string(MAX_PLANES), LOG_WARNING);
-        n = MAX_PLANES;
-    }
-    
+    size_t n = entries.size();
     msg.commandBody.multiple.numberOfAircrafts = n;
     
-    for (size_t i = 0; i < n; i++) {
-        msg.commandBody.multiple.planeIDArray[i] = ids[i];
-        msg.commandBody.multiple.positionArray[i] = poss[i];
-        msg.commandBody.multiple.velocityArray[i] = vels[i];
-    }
+    IpcIov iov[2] = {
+        { &msg, sizeof(msg) },
+        { entries.data(), n * sizeof(AircraftDisplayEntry) }
+    };
     
-    int coid = ConnectAttach(0, displayPid, displayChid, _NTO_SIDE_CHANNEL, 0);
+    int coid = connections.get(ENDPOINT_DISPLAY);
     if (coid != -1) {
-        if (MsgSend(coid, &msg, sizeof(msg), NULL, 0) == -1) {
+        if (ipcSendv(coid, iov, 2, NULL, 0) == -1) {
             logComputerSystemMessage("Failed to send log data to DataDisplay: " + 
                                    std::string(strerror(errno)), LOG_ERROR);
+            connections.invalidate(ENDPOINT_DISPLAY, coid);
+        } else if (toFile) {
+            logComputerSystemMessage("Sent log data to DataDisplay with " + std::to_string(n) + " planes");
         } else {
-            logComputerSystemMessage("Sent " + std::string(toFile ? "log" : "grid") + 
-                                   " data to DataDisplay with " + std::to_string(n) + " planes");
+            // Grids go out up to 10 times a second; keep them out of the log at INFO
+            LOG_COMPUTER_SYSTEM(LOG_DEBUG, "Sent grid data to DataDisplay with ", n, " planes");
         }
-        ConnectDetach(coid);
     } else {
-        logComputerSystemMessage("Failed to connect to DataDisplay: " + 
-                               std::string(strerror(errno)), LOG_ERROR);
+        logComputerSystemMessage("DataDisplay not reachable", LOG_ERROR);
+    }
+}
+
+void ComputerSystem::sendToSubscribers(int commandType, const std::vector<AircraftDisplayEntry>& entries)
+{
+    // Each display is sent from its own thread; this loop never waits on one
+    displays.index(entries.data(), entries.size());
+    for (size_t i = 0; i < displays.size();) {
+        DisplaySubscriptions::Subscriber& display = displays.at(i);
+        if (int error = display.sender->failure()) {
+            // Gone: it subscribes again if it comes back
+            logComputerSystemMessage("Dropping display subscription of PID " + std::to_string(display.pid) +
+                                   ": " + std::string(strerror(error)), LOG_WARNING);
+            displays.remove(i);
+            continue;
+        }
+        if (!display.sender->ready()) {
+            if (display.skipped++ == 0) {
+                logComputerSystemMessage("Display PID " + std::to_string(display.pid) +
+                                       " is still receiving earlier grids, skipping grids", LOG_WARNING);
+            }
+            i++;
+            continue;
+        }
+        if (display.skipped > 0) {
+            logComputerSystemMessage("Display PID " + std::to_string(display.pid) + " caught up after " +
+                                   std::to_string(display.skipped) + " skipped grids");
+            display.skipped = 0;
+        }
+
+        DisplaySelectStats stats;
+        displays.select(display.viewport, displayEntries, &stats);
+        display.sender->post(commandType, displayEntries);
+        LOG_COMPUTER_SYSTEM(LOG_DEBUG, "Sending display ", display.pid, " ", stats.selected, " of ",
+                            entries.size(), " planes, ", stats.tested, " tested in ", stats.buckets, " buckets");
+        i++;
+    }
+}
+
+void ComputerSystem::handleSubscription(int rcvid, const DisplaySubscribeMessage& request)
+{
+    const DisplayViewport& v = request.viewport;
+    if (request.commandType == COMMAND_DISPLAY_UNSUBSCRIBE) {
+        if (displays.unsubscribe(request.pid, request.chid)) {
+            logComputerSystemMessage("Display PID " + std::to_string(request.pid) + " unsubscribed");
+        }
+        ipcReply(rcvid, EOK, NULL, 0);
+        return;
+    }
+
+    bool known = displays.contains(request.pid, request.chid);
+    if (request.pid <= 0 || request.chid <= 0 || !displays.subscribe(request.pid, request.chid, v)) {
+        logComputerSystemMessage("Refusing display subscription of PID " + std::to_string(request.pid) +
+                               ", " + std::to_string(displays.size()) + " displays subscribed", LOG_WARNING);
+        ipcError(rcvid, request.pid <= 0 || request.chid <= 0 ? EINVAL : ENOSPC);
+        return;
+    }
+    ipcReply(rcvid, EOK, NULL, 0);
+    // Displays renew their subscription every few seconds
+    if (!known) {
+        logComputerSystemMessage("Display PID " + std::to_string(request.pid) + " subscribed to x " +
+                               std::to_string(v.min[0]) + ".." + std::to_string(v.max[0]) + ", y " +
+                               std::to_string(v.min[1]) + ".." + std::to_string(v.max[1]) + ", altitude " +
+                               std::to_string(v.min[2]) + ".." + std::to_string(v.max[2]));
     }
 }
 
 void ComputerSystem::processEmergencyEvents() {
     logComputerSystemMessage("Emergency event processing thread started");
+
+    // The check itself runs in the message loop: the conflict detector, its
+    // thread pool and the conflict list belong to that thread
+    int selfCoid = ipcConnect(getpid(), chid);
+    if (selfCoid == -1) {
+        logComputerSystemMessage("Failed to connect to own channel for emergency checks: " +
+                               std::string(strerror(errno)), LOG_ERROR);
+    }
     
     while (true) {
         std::unique_lock<std::mutex> lock(eventMutex);
@@ -621,10 +649,15 @@ void ComputerSystem::processEmergencyEvents() {
         if (emergencyEvent) {
             emergencyEvent = false;
             
-            violationCheck();
+            if (selfCoid == -1) {
+                logComputerSystemMessage("No connection to own channel, emergency violation check skipped", LOG_ERROR);
+            } else if (ipcSendPulse(selfCoid, EMERGENCY_VIOLATION_CHECK_PULSE, 0) == -1) {
+                logComputerSystemMessage("Failed to request emergency violation check: " +
+                                       std::string(strerror(errno)), LOG_ERROR);
+            }
             
             // Signal operator console about emergency
-            int coid = ConnectAttach(0, 0, operatorChid, _NTO_SIDE_CHANNEL, 0);
+            int coid = connections.get(ENDPOINT_OPERATOR);
             if (coid != -1) {
                 OperatorConsoleCommandMessage alert;
                 alert.systemCommandType = OPCON_CONSOLE_COMMAND_ALERT;
@@ -633,14 +666,13 @@ void ComputerSystem::processEmergencyEvents() {
                 alert.collisionTimeSeconds = 0; // Immediate
                 OperatorConsoleResponseMessage r;
                 
-                if (MsgSend(coid, &alert, sizeof(alert), &r, sizeof(r)) == -1) {
+                if (ipcSend(coid, &alert, sizeof(alert), &r, sizeof(r)) == -1) {
                     logComputerSystemMessage("Failed to send emergency alert: " + 
                                            std::string(strerror(errno)), LOG_ERROR);
+                    connections.invalidate(ENDPOINT_OPERATOR, coid);
                 } else {
                     logComputerSystemMessage("Emergency event processed and alert sent to operator");
                 }
-                
-                ConnectDetach(coid);
             }
         }
     }
@@ -667,30 +699,18 @@ void ComputerSystem::sendDisplayCommand(int planeNumber)
     stackMsg.msg.commandType = COMMAND_ONE_PLANE;
     stackMsg.msg.commandBody.one.aircraftID = planeNumber;
     
-    bool success = accessSharedMemory<RadarData>(
-        SHM_RADAR_DATA,
-        sizeof(RadarData),
-        O_RDONLY,
-        false,
-        [&found, &stackMsg, planeNumber](RadarData* rd) {
-            for (int i = 0; i < rd->numPlanes; i++) {
-                if (rd->positions[i].planeId == planeNumber) {
-                    found = true;
-                    stackMsg.msg.commandBody.one.position = {
-                        rd->positions[i].x, 
-                        rd->positions[i].y, 
-                        rd->positions[i].z
-                    };
-                    stackMsg.msg.commandBody.one.velocity = {
-                        rd->velocities[i].vx, 
-                        rd->velocities[i].vy, 
-                        rd->velocities[i].vz
-                    };
-                    break;
-                }
+    std::vector<RadarTrack> tracks;
+    bool success = radarReader.read(tracks);
+    if (success) {
+        for (const RadarTrack& t : tracks) {
+            if (t.planeId == planeNumber) {
+                found = true;
+                stackMsg.msg.commandBody.one.position = {t.x, t.y, t.z};
+                stackMsg.msg.commandBody.one.velocity = {t.vx, t.vy, t.vz};
+                break;
             }
         }
-    );
+    }
 
     if (!success || !found) {
         logComputerSystemMessage("Plane " + std::to_string(planeNumber) + " not found", LOG_WARNING);
@@ -698,61 +718,126 @@ void ComputerSystem::sendDisplayCommand(int planeNumber)
     }
 
     // Send to DataDisplay with correct PID
-    int coid = ConnectAttach(0, displayPid, displayChid, _NTO_SIDE_CHANNEL, 0);
+    int coid = connections.get(ENDPOINT_DISPLAY);
     if (coid != -1) {
-        if (MsgSend(coid, &stackMsg, sizeof(stackMsg), NULL, 0) == -1) {
+        if (ipcSend(coid, &stackMsg, sizeof(stackMsg), NULL, 0) == -1) {
             logComputerSystemMessage("Failed to send plane info to DataDisplay: " + 
                                    std::string(strerror(errno)), LOG_ERROR);
+            connections.invalidate(ENDPOINT_DISPLAY, coid);
         } else {
             logComputerSystemMessage("Sent info for plane " + std::to_string(planeNumber) + 
                                    " to DataDisplay");
         }
-        ConnectDetach(coid);
     } else {
-        logComputerSystemMessage("Failed to connect to DataDisplay: " + 
-                               std::string(strerror(errno)), LOG_ERROR);
+        logComputerSystemMessage("DataDisplay not reachable", LOG_ERROR);
     }
 }
 
-void ComputerSystem::sendVelocityUpdateToComm(int planeNumber, Vec3 newVel)
+void ComputerSystem::sendVelocityUpdateToComm(int planeNumber, Vec3 newVel, int64_t issuedNs)
 {
     // Queue command for CommunicationSystem
-    bool success = accessSharedMemory<CommandQueue>(
-        SHM_COMMANDS,
-        sizeof(CommandQueue),
-        O_RDWR,
-        false,
-        [this, planeNumber, newVel](CommandQueue* cq) {
-            int next = (cq->tail + 1) % MAX_COMMANDS;
-            if (next == cq->head) {
-                logComputerSystemMessage("Command queue full, cannot send velocity update", LOG_WARNING);
-                return;
-            }
-            
-            Command cmd;
-            cmd.planeId = planeNumber;
-            cmd.code = CMD_VELOCITY;
-            cmd.value[0] = newVel.x;
-            cmd.value[1] = newVel.y;
-            cmd.value[2] = newVel.z;
-            cmd.timestamp = time(nullptr);
-            
-            cq->commands[cq->tail] = cmd;
-            cq->tail = next;
-            
-            logComputerSystemMessage("Queued velocity update for plane " + 
-                                   std::to_string(planeNumber) + ": (" +
-                                   std::to_string(newVel.x) + ", " +
-                                   std::to_string(newVel.y) + ", " +
-                                   std::to_string(newVel.z) + ")");
-        }
-    );
-    
-    if (!success) {
+    CommandRingHeader* ring = openCommandRing(commandSegment, SHM_COMMANDS);
+    if (!ring) {
         logComputerSystemMessage("Failed to access command queue for velocity update", LOG_ERROR);
+        return;
+    }
+    
+    Command cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.planeId = planeNumber;
+    cmd.code = CMD_VELOCITY;
+    cmd.value[0] = newVel.x;
+    cmd.value[1] = newVel.y;
+    cmd.value[2] = newVel.z;
+    cmd.timestamp = time(nullptr);
+    cmd.sequence = nextCommandSequence;
+    cmd.issuedNs = issuedNs;
+    cmd.status = CMD_STATUS_PENDING;
+    
+    // Recorded before the push so it precedes CommunicationSystem's event
+    EVENT_LOG(EVSUB_COMPUTER_SYSTEM, EVT_COMMAND_QUEUED, cmd.sequence, planeNumber,
+              newVel.x, newVel.y, newVel.z);
+    if (!commandRingPush(ring, cmd)) {
+        logComputerSystemMessage("Command queue full (" + std::to_string(ring->capacity) +
+                               " pending), cannot send velocity update", LOG_WARNING);
+        return;
+    }
+    
+    nextCommandSequence++;
+    
+    logComputerSystemMessage("Queued velocity update #" + std::to_string(cmd.sequence) +
+                           " for plane " + std::to_string(planeNumber) + ": (" +
+                           std::to_string(newVel.x) + ", " +
+                           std::to_string(newVel.y) + ", " +
+                           std::to_string(newVel.z) + ")");
+}
+
+void ComputerSystem::collectCommandAcks()
+{
+    CommandRingHeader* acks = openCommandRing(ackSegment, SHM_COMMAND_ACKS);
+    if (!acks) {
+        return;
+    }
+
+    Command cmd;
+    while (commandRingTryPop(acks, cmd)) {
+        commandsAcked++;
+        EVENT_LOG(EVSUB_COMPUTER_SYSTEM, EVT_COMMAND_ACKNOWLEDGED, cmd.sequence, cmd.planeId,
+                  cmd.status, (cmd.appliedNs - cmd.issuedNs) / 1e6);
+
+        if (cmd.status != CMD_STATUS_APPLIED) {
+            logComputerSystemMessage("Command #" + std::to_string(cmd.sequence) + " for plane " +
+                                   std::to_string(cmd.planeId) + " rejected by aircraft (status " +
+                                   std::to_string(cmd.status) + ")", LOG_WARNING);
+            continue;
+        }
+
+        double uplinkMs = (cmd.transmittedNs - cmd.issuedNs) / 1e6;
+        double applyMs = (cmd.appliedNs - cmd.transmittedNs) / 1e6;
+        double totalMs = (cmd.appliedNs - cmd.issuedNs) / 1e6;
+        uplinkLatencies.push_back(uplinkMs);
+        applyLatencies.push_back(applyMs);
+        totalLatencies.push_back(totalMs);
+
+        logComputerSystemMessage("Command #" + std::to_string(cmd.sequence) + " applied to plane " +
+                               std::to_string(cmd.planeId) + " " + std::to_string(totalMs) +
+                               " ms after it was issued");
     }
 }
 
+static std::string latencyPercentiles(std::vector<double>& samples)
+{
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    char buf[128];
+    snprintf(buf, sizeof(buf), "p50 %.2f / p95 %.2f / p99 %.2f / max %.2f ms",
+             samples[n / 2], samples[std::min(n - 1, n * 95 / 100)],
+             samples[std::min(n - 1, n * 99 / 100)], samples[n - 1]);
+    return buf;
+}
+
+void ComputerSystem::reportCommandLatency()
+{
+    uint64_t issued = nextCommandSequence - 1;
+    if (totalLatencies.empty()) {
+        if (issued > commandsAcked) {
+            logComputerSystemMessage(std::to_string(issued - commandsAcked) +
+                                   " commands awaiting acknowledgement", LOG_WARNING);
+        }
+        return;
+    }
+
+    logComputerSystemMessage("Command latency over " + std::to_string(totalLatencies.size()) +
+                           " commands (" + std::to_string(issued - commandsAcked) +
+                           " unacknowledged): issue->uplink " + latencyPercentiles(uplinkLatencies) +
+                           ", uplink->applied " + latencyPercentiles(applyLatencies) +
+                           ", issue->applied " + latencyPercentiles(totalLatencies));
+
+    uplinkLatencies.clear();
+    applyLatencies.clear();
+    totalLatencies.clear();
+}
+
 void ComputerSystem::update(double currentTime)
 {
     (void)currentTime;
@@ -0,0 +1,333 @@
+#include "ConflictDetector.h"
+#include "CpaKernel.h"
+#include <algorithm>
+#include <cmath>
+
+// Extra padding on the swept boxes to absorb floating point rounding
+static const double SWEEP_PADDING_EPSILON = 1.0;
+
+// Tasks per worker when splitting a pass, so stealing can even out the load
+static const size_t TASKS_PER_WORKER = 8;
+
+// Smallest task sizes worth handing to another thread
+static const size_t MIN_CELL_ENTRIES_PER_TASK = 256;
+static const size_t MIN_CANDIDATES_PER_TASK = 512;
+
+ConflictDetector::ConflictDetector(double minHSep, double minVSep, double horizon)
+    : minHorizontalSeparation(minHSep),
+      minVerticalSeparation(minVSep),
+      horizonSeconds(horizon),
+      cellSize(minHSep),
+      pool(nullptr)
+{
+}
+
+void ConflictDetector::loadSnapshot(const std::vector<RadarTrack>& tracks)
+{
+    const size_t n = tracks.size();
+    ids.resize(n);
+    x.resize(n);  y.resize(n);  z.resize(n);
+    vx.resize(n); vy.resize(n); vz.resize(n);
+
+    for (size_t i = 0; i < n; i++) {
+        const RadarTrack& t = tracks[i];
+        ids[i] = t.planeId;
+        x[i] = t.x;   y[i] = t.y;   z[i] = t.z;
+        vx[i] = t.vx; vy[i] = t.vy; vz[i] = t.vz;
+    }
+}
+
+CpaReference ConflictDetector::reference(uint32_t i) const
+{
+    return { x[i], y[i], z[i], vx[i], vy[i], vz[i] };
+}
+
+void ConflictDetector::ensureScratch(WorkerScratch& s, size_t count)
+{
+    if (s.resultTime.size() < count) {
+        s.resultTime.resize(count);
+        s.resultHorizontal.resize(count);
+        s.resultVertical.resize(count);
+    }
+}
+
+void ConflictDetector::collectConflicts(WorkerScratch& s, uint32_t i, const uint32_t* others,
+                                        size_t count) const
+{
+    for (size_t k = 0; k < count; k++) {
+        if (s.resultTime[k] <= horizonSeconds &&
+            s.resultVertical[k] < minVerticalSeparation &&
+            s.resultHorizontal[k] < minHorizontalSeparation) {
+            uint32_t j = others ? others[k] : (uint32_t)(i + 1 + k);
+            s.conflicts.push_back({ids[i], ids[j], s.resultTime[k]});
+        }
+    }
+}
+
+void ConflictDetector::collectApproaches(WorkerScratch& s, uint32_t i, const uint32_t* others,
+                                         size_t count) const
+{
+    for (size_t k = 0; k < count; k++) {
+        s.approaches.push_back({i, others[k], s.resultTime[k],
+                                s.resultHorizontal[k], s.resultVertical[k]});
+    }
+}
+
+void ConflictDetector::prepareWorkers()
+{
+    scratch.resize(pool ? pool->size() : 1);
+    for (WorkerScratch& s : scratch) {
+        s.candidates.clear();
+        s.conflicts.clear();
+        s.approaches.clear();
+    }
+}
+
+void ConflictDetector::runTasks(size_t taskCount, const ThreadPool::Task& fn)
+{
+    taskSpans.resize(taskCount);
+    if (pool) {
+        pool->parallelFor(taskCount, fn);
+    } else {
+        for (size_t t = 0; t < taskCount; t++) {
+            fn(t, 0);
+        }
+    }
+}
+
+void ConflictDetector::splitRuns(size_t count, size_t targetSize,
+                                 const std::function<bool(size_t)>& isRunStart)
+{
+    // Task boundaries only fall where a new run starts, so a run (one cell,
+    // or one reference aircraft) is never split across tasks
+    taskBounds.clear();
+    taskBounds.push_back(0);
+    size_t next = targetSize;
+    for (size_t p = 1; p < count; p++) {
+        if (p >= next && isRunStart(p)) {
+            taskBounds.push_back(p);
+            next = p + targetSize;
+        }
+    }
+    taskBounds.push_back(count);
+}
+
+void ConflictDetector::detectBruteForce(const std::vector<RadarTrack>& tracks,
+                                        std::vector<Conflict>& conflicts)
+{
+    conflicts.clear();
+    loadSnapshot(tracks);
+    prepareWorkers();
+
+    const uint32_t n = (uint32_t)ids.size();
+    WorkerScratch& s = scratch[0];
+    ensureScratch(s, n);
+    CpaResults out = { s.resultTime.data(), s.resultHorizontal.data(), s.resultVertical.data() };
+
+    // Candidates j > i are contiguous in the snapshot, so no gather is needed
+    for (uint32_t i = 0; i + 1 < n; i++) {
+        CpaCandidates cand = { &x[i + 1], &y[i + 1], &z[i + 1],
+                               &vx[i + 1], &vy[i + 1], &vz[i + 1] };
+        size_t count = n - i - 1;
+        cpaBatch(reference(i), cand, count, out);
+        collectConflicts(s, i, nullptr, count);
+    }
+    conflicts.swap(s.conflicts);
+}
+
+void ConflictDetector::buildSweptBoxes()
+{
+    const size_t n = ids.size();
+    minX.resize(n); maxX.resize(n);
+    minY.resize(n); maxY.resize(n);
+    minZ.resize(n); maxZ.resize(n);
+
+    // Padding by half the minima on each box makes the boxes of any
+    // conflicting pair overlap
+    const double padH = minHorizontalSeparation / 2 + SWEEP_PADDING_EPSILON;
+    const double padV = minVerticalSeparation / 2 + SWEEP_PADDING_EPSILON;
+    const double h = horizonSeconds > 0 ? horizonSeconds : 0;
+
+    double extentSum = 0;
+    for (size_t i = 0; i < n; i++) {
+        double ex = x[i] + vx[i] * h;
+        double ey = y[i] + vy[i] * h;
+        double ez = z[i] + vz[i] * h;
+
+        minX[i] = std::min(x[i], ex) - padH;  maxX[i] = std::max(x[i], ex) + padH;
+        minY[i] = std::min(y[i], ey) - padH;  maxY[i] = std::max(y[i], ey) + padH;
+        minZ[i] = std::min(z[i], ez) - padV;  maxZ[i] = std::max(z[i], ez) + padV;
+
+        extentSum += (maxX[i] - minX[i]) + (maxY[i] - minY[i]);
+    }
+
+    // Size cells to the average swept extent so each box touches a few cells
+    cellSize = minHorizontalSeparation;
+    if (n > 0) {
+        cellSize = std::max(cellSize, extentSum / (2.0 * n));
+    }
+}
+
+static inline uint64_t cellKey(int64_t cx, int64_t cy)
+{
+    return ((uint64_t)(uint32_t)(int32_t)cx << 32) | (uint64_t)(uint32_t)(int32_t)cy;
+}
+
+void ConflictDetector::buildCells()
+{
+    const size_t n = ids.size();
+    cellEntries.clear();
+    cellEntries.reserve(n * 4);
+
+    for (size_t i = 0; i < n; i++) {
+        int64_t cx0 = (int64_t)floor(minX[i] / cellSize);
+        int64_t cx1 = (int64_t)floor(maxX[i] / cellSize);
+        int64_t cy0 = (int64_t)floor(minY[i] / cellSize);
+        int64_t cy1 = (int64_t)floor(maxY[i] / cellSize);
+
+        for (int64_t cx = cx0; cx <= cx1; cx++) {
+            for (int64_t cy = cy0; cy <= cy1; cy++) {
+                cellEntries.push_back({cellKey(cx, cy), (uint32_t)i});
+            }
+        }
+    }
+
+    std::sort(cellEntries.begin(), cellEntries.end());
+}
+
+bool ConflictDetector::boxesOverlap(uint32_t a, uint32_t b) const
+{
+    return minX[a] <= maxX[b] && minX[b] <= maxX[a] &&
+           minY[a] <= maxY[b] && minY[b] <= maxY[a] &&
+           minZ[a] <= maxZ[b] && minZ[b] <= maxZ[a];
+}
+
+void ConflictDetector::collectCandidates()
+{
+    const size_t m = cellEntries.size();
+    const size_t workers = scratch.size();
+    splitRuns(m, std::max(MIN_CELL_ENTRIES_PER_TASK, m / (workers * TASKS_PER_WORKER) + 1),
+              [this](size_t p) { return cellEntries[p].first != cellEntries[p - 1].first; });
+
+    runTasks(taskBounds.size() - 1, [this](size_t task, size_t worker) {
+        std::vector<std::pair<uint32_t, uint32_t>>& out = scratch[worker].candidates;
+        taskSpans[task] = { (uint32_t)worker, out.size(), out.size() };
+
+        size_t begin = taskBounds[task];
+        const size_t last = taskBounds[task + 1];
+        while (begin < last) {
+            uint64_t key = cellEntries[begin].first;
+            size_t end = begin + 1;
+            while (end < last && cellEntries[end].first == key) {
+                end++;
+            }
+
+            for (size_t p = begin; p < end; p++) {
+                uint32_t a = cellEntries[p].second;
+                for (size_t q = p + 1; q < end; q++) {
+                    uint32_t b = cellEntries[q].second;
+                    if (!boxesOverlap(a, b)) {
+                        continue;
+                    }
+
+                    // A pair can share several cells; only keep it in the cell
+                    // holding the low corner of the two boxes' intersection
+                    double cornerX = std::max(minX[a], minX[b]);
+                    double cornerY = std::max(minY[a], minY[b]);
+                    uint64_t owner = cellKey((int64_t)floor(cornerX / cellSize),
+                                             (int64_t)floor(cornerY / cellSize));
+                    if (owner == key) {
+                        out.push_back({a, b});
+                    }
+                }
+            }
+
+            begin = end;
+        }
+        taskSpans[task].end = out.size();
+    });
+
+    mergeTaskOutput(&WorkerScratch::candidates, candidates);
+
+    // Entries within a cell are sorted by index, so a < b; sort pairs to
+    // report conflicts in the same order as the brute-force scan
+    std::sort(candidates.begin(), candidates.end());
+}
+
+void ConflictDetector::runBroadPhase(const std::vector<RadarTrack>& tracks)
+{
+    loadSnapshot(tracks);
+    prepareWorkers();
+
+    buildSweptBoxes();
+    buildCells();
+    collectCandidates();
+}
+
+void ConflictDetector::detect(const std::vector<RadarTrack>& tracks,
+                              std::vector<Conflict>& conflicts)
+{
+    runBroadPhase(tracks);
+    narrowPhase(false);
+    mergeTaskOutput(&WorkerScratch::conflicts, conflicts);
+}
+
+void ConflictDetector::findApproaches(const std::vector<RadarTrack>& tracks,
+                                      std::vector<PairApproach>& approaches)
+{
+    runBroadPhase(tracks);
+    narrowPhase(true);
+    mergeTaskOutput(&WorkerScratch::approaches, approaches);
+}
+
+void ConflictDetector::narrowPhase(bool keepAllPairs)
+{
+    const size_t m = candidates.size();
+    const size_t workers = scratch.size();
+    splitRuns(m, std::max(MIN_CANDIDATES_PER_TASK, m / (workers * TASKS_PER_WORKER) + 1),
+              [this](size_t p) { return candidates[p].first != candidates[p - 1].first; });
+
+    // Candidates are sorted by first index; gather each run into a
+    // structure-of-arrays block and evaluate it in one kernel call
+    runTasks(taskBounds.size() - 1, [this, keepAllPairs](size_t task, size_t worker) {
+        WorkerScratch& s = scratch[worker];
+        size_t start = keepAllPairs ? s.approaches.size() : s.conflicts.size();
+        taskSpans[task] = { (uint32_t)worker, start, start };
+
+        size_t begin = taskBounds[task];
+        const size_t last = taskBounds[task + 1];
+        while (begin < last) {
+            uint32_t i = candidates[begin].first;
+            size_t end = begin;
+            s.gatherIndex.clear();
+            while (end < last && candidates[end].first == i) {
+                s.gatherIndex.push_back(candidates[end].second);
+                end++;
+            }
+
+            size_t count = s.gatherIndex.size();
+            s.gatherX.resize(count);  s.gatherY.resize(count);  s.gatherZ.resize(count);
+            s.gatherVx.resize(count); s.gatherVy.resize(count); s.gatherVz.resize(count);
+            for (size_t k = 0; k < count; k++) {
+                uint32_t j = s.gatherIndex[k];
+                s.gatherX[k] = x[j];   s.gatherY[k] = y[j];   s.gatherZ[k] = z[j];
+                s.gatherVx[k] = vx[j]; s.gatherVy[k] = vy[j]; s.gatherVz[k] = vz[j];
+            }
+
+            ensureScratch(s, count);
+            CpaCandidates cand = { s.gatherX.data(), s.gatherY.data(), s.gatherZ.data(),
+                                   s.gatherVx.data(), s.gatherVy.data(), s.gatherVz.data() };
+            CpaResults out = { s.resultTime.data(), s.resultHorizontal.data(),
+                               s.resultVertical.data() };
+            cpaBatch(reference(i), cand, count, out);
+            if (keepAllPairs) {
+                collectApproaches(s, i, s.gatherIndex.data(), count);
+            } else {
+                collectConflicts(s, i, s.gatherIndex.data(), count);
+            }
+
+            begin = end;
+        }
+        taskSpans[task].end = keepAllPairs ? s.approaches.size() : s.conflicts.size();
+    });
+}
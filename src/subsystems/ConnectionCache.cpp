@@ -0,0 +1,133 @@
+#include "ConnectionCache.h"
+#include <fcntl.h>
+#include <cstring>
+#include <errno.h>
+#include "Ipc.h"
+#include "utils.h"
+
+ConnectionCache::ConnectionCache(LogFunction log)
+    : logFunction(log), channelsSegment(log), connects(0), reconnects(0), failures(0)
+{
+    for (Connection& c : connections) {
+        c = { -1, -1, -1 };
+    }
+}
+
+ConnectionCache::~ConnectionCache()
+{
+    clear();
+}
+
+const char* ConnectionCache::endpointName(IpcEndpoint endpoint)
+{
+    switch (endpoint) {
+    case ENDPOINT_OPERATOR: return "OperatorConsole";
+    case ENDPOINT_DISPLAY:  return "DataDisplay";
+    case ENDPOINT_LOGGER:   return "AirspaceLogger";
+    case ENDPOINT_COMPUTER: return "ComputerSystem";
+    default:                return "unknown";
+    }
+}
+
+bool ConnectionCache::lookup(IpcEndpoint endpoint, int& chid, pid_t& pid)
+{
+    if (!channelsSegment.isOpen() &&
+        !channelsSegment.open(SHM_CHANNELS, sizeof(ChannelIds), O_RDONLY, false, 1)) {
+        return false;
+    }
+
+    const volatile ChannelIds* channels = channelsSegment.as<ChannelIds>();
+    switch (endpoint) {
+    case ENDPOINT_OPERATOR: chid = channels->operatorChid; pid = channels->operatorPid; break;
+    case ENDPOINT_DISPLAY:  chid = channels->displayChid;  pid = channels->displayPid;  break;
+    case ENDPOINT_LOGGER:   chid = channels->loggerChid;   pid = channels->loggerPid;   break;
+    case ENDPOINT_COMPUTER: chid = channels->computerChid; pid = channels->computerPid; break;
+    default: return false;
+    }
+    return chid > 0 && pid > 0;
+}
+
+bool ConnectionCache::peer(IpcEndpoint endpoint, int& chid, pid_t& pid)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return lookup(endpoint, chid, pid);
+}
+
+void ConnectionCache::detach(Connection& c)
+{
+    if (c.coid != -1) {
+        ipcDisconnect(c.coid);
+    }
+    c = { -1, -1, -1 };
+}
+
+int ConnectionCache::get(IpcEndpoint endpoint)
+{
+    if (endpoint < 0 || endpoint >= ENDPOINT_COUNT) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Connection& c = connections[endpoint];
+
+    int chid;
+    pid_t pid;
+    if (!lookup(endpoint, chid, pid)) {
+        failures.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+
+    if (c.coid != -1 && c.chid == chid && c.pid == pid) {
+        return c.coid;
+    }
+
+    // First use, peer restarted, or the previous connection failed
+    bool reconnect = c.pid != -1;
+    if (c.coid != -1 && (c.chid != chid || c.pid != pid)) {
+        logFunction(std::string("Peer ") + endpointName(endpoint) + " moved from " +
+                    std::to_string(c.chid) + ":" + std::to_string(c.pid) + " to " +
+                    std::to_string(chid) + ":" + std::to_string(pid) + ", reconnecting",
+                    LOG_WARNING);
+    }
+    detach(c);
+
+    int coid = ipcConnect(pid, chid);
+    if (coid == -1) {
+        failures.fetch_add(1, std::memory_order_relaxed);
+        logFunction(std::string("Failed to connect to ") + endpointName(endpoint) + ": " +
+                    std::string(strerror(errno)), LOG_ERROR);
+        return -1;
+    }
+
+    c = { coid, chid, pid };
+    connects.fetch_add(1, std::memory_order_relaxed);
+    if (reconnect) {
+        reconnects.fetch_add(1, std::memory_order_relaxed);
+    }
+    return coid;
+}
+
+void ConnectionCache::invalidate(IpcEndpoint endpoint, int coid)
+{
+    if (endpoint < 0 || endpoint >= ENDPOINT_COUNT) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    failures.fetch_add(1, std::memory_order_relaxed);
+
+    // Another thread may already have replaced the connection
+    Connection& c = connections[endpoint];
+    if (c.coid == coid) {
+        ipcDisconnect(c.coid);
+        c.coid = -1;    // Keep chid/pid so the next connect counts as a reconnect
+    }
+}
+
+void ConnectionCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Connection& c : connections) {
+        detach(c);
+    }
+}
@@ -0,0 +1,153 @@
+#include "CpaKernel.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CPA_HAVE_AVX2_KERNEL 1
+#endif
+
+// Relative speeds below this (squared, m^2/s^2) are treated as parallel tracks
+static const double PARALLEL_THRESHOLD = 0.001;
+
+static inline void cpaOne(const CpaReference& r,
+                          double x, double y, double z,
+                          double vx, double vy, double vz,
+                          double& t, double& h, double& v)
+{
+    double dx = r.x - x;
+    double dy = r.y - y;
+    double dz = r.z - z;
+    double dvx = r.vx - vx;
+    double dvy = r.vy - vy;
+    double dvz = r.vz - vz;
+
+    // Time to minimum distance (first derivative of distance function set to zero)
+    t = 0;
+    double denom = dvx * dvx + dvy * dvy + dvz * dvz;
+    if (denom > PARALLEL_THRESHOLD) {
+        t = -(dx * dvx + dy * dvy + dz * dvz) / denom;
+    }
+
+    // If time is negative, closest approach already happened
+    t = (t > 0) ? t : 0;
+
+    double sx = fabs((r.x + r.vx * t) - (x + vx * t));
+    double sy = fabs((r.y + r.vy * t) - (y + vy * t));
+    h = sqrt(sx * sx + sy * sy);
+    v = fabs((r.z + r.vz * t) - (z + vz * t));
+}
+
+void cpaBatchScalar(const CpaReference& ref, const CpaCandidates& cand,
+                    size_t count, CpaResults& out)
+{
+    for (size_t i = 0; i < count; i++) {
+        cpaOne(ref, cand.x[i], cand.y[i], cand.z[i], cand.vx[i], cand.vy[i], cand.vz[i],
+               out.timeToClosestApproach[i], out.horizontalSeparation[i],
+               out.verticalSeparation[i]);
+    }
+}
+
+#ifdef CPA_HAVE_AVX2_KERNEL
+
+// Only mul/add/sub/div/sqrt are used (no FMA) so every lane rounds exactly
+// like the scalar kernel
+__attribute__((target("avx2")))
+void cpaBatchAvx2(const CpaReference& ref, const CpaCandidates& cand,
+                  size_t count, CpaResults& out)
+{
+    const __m256d rx = _mm256_set1_pd(ref.x);
+    const __m256d ry = _mm256_set1_pd(ref.y);
+    const __m256d rz = _mm256_set1_pd(ref.z);
+    const __m256d rvx = _mm256_set1_pd(ref.vx);
+    const __m256d rvy = _mm256_set1_pd(ref.vy);
+    const __m256d rvz = _mm256_set1_pd(ref.vz);
+    const __m256d threshold = _mm256_set1_pd(PARALLEL_THRESHOLD);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d cx = _mm256_loadu_pd(cand.x + i);
+        __m256d cy = _mm256_loadu_pd(cand.y + i);
+        __m256d cz = _mm256_loadu_pd(cand.z + i);
+        __m256d cvx = _mm256_loadu_pd(cand.vx + i);
+        __m256d cvy = _mm256_loadu_pd(cand.vy + i);
+        __m256d cvz = _mm256_loadu_pd(cand.vz + i);
+
+        __m256d dx = _mm256_sub_pd(rx, cx);
+        __m256d dy = _mm256_sub_pd(ry, cy);
+        __m256d dz = _mm256_sub_pd(rz, cz);
+        __m256d dvx = _mm256_sub_pd(rvx, cvx);
+        __m256d dvy = _mm256_sub_pd(rvy, cvy);
+        __m256d dvz = _mm256_sub_pd(rvz, cvz);
+
+        __m256d denom = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dvx, dvx),
+                                                    _mm256_mul_pd(dvy, dvy)),
+                                      _mm256_mul_pd(dvz, dvz));
+        __m256d num = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dvx),
+                                                  _mm256_mul_pd(dy, dvy)),
+                                    _mm256_mul_pd(dz, dvz));
+
+        // t = -num / denom where denom is large enough, then clamp to t > 0
+        __m256d t = _mm256_div_pd(_mm256_xor_pd(num, signMask), denom);
+        t = _mm256_and_pd(t, _mm256_cmp_pd(denom, threshold, _CMP_GT_OQ));
+        t = _mm256_and_pd(t, _mm256_cmp_pd(t, zero, _CMP_GT_OQ));
+
+        __m256d sx = _mm256_sub_pd(_mm256_add_pd(rx, _mm256_mul_pd(rvx, t)),
+                                   _mm256_add_pd(cx, _mm256_mul_pd(cvx, t)));
+        __m256d sy = _mm256_sub_pd(_mm256_add_pd(ry, _mm256_mul_pd(rvy, t)),
+                                   _mm256_add_pd(cy, _mm256_mul_pd(cvy, t)));
+        __m256d sz = _mm256_sub_pd(_mm256_add_pd(rz, _mm256_mul_pd(rvz, t)),
+                                   _mm256_add_pd(cz, _mm256_mul_pd(cvz, t)));
+        sx = _mm256_andnot_pd(signMask, sx);
+        sy = _mm256_andnot_pd(signMask, sy);
+        sz = _mm256_andnot_pd(signMask, sz);
+
+        __m256d h = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(sx, sx),
+                                                 _mm256_mul_pd(sy, sy)));
+
+        _mm256_storeu_pd(out.timeToClosestApproach + i, t);
+        _mm256_storeu_pd(out.horizontalSeparation + i, h);
+        _mm256_storeu_pd(out.verticalSeparation + i, sz);
+    }
+
+    for (; i < count; i++) {
+        cpaOne(ref, cand.x[i], cand.y[i], cand.z[i], cand.vx[i], cand.vy[i], cand.vz[i],
+               out.timeToClosestApproach[i], out.horizontalSeparation[i],
+               out.verticalSeparation[i]);
+    }
+}
+
+#endif // CPA_HAVE_AVX2_KERNEL
+
+bool cpaAvx2Supported()
+{
+#ifdef CPA_HAVE_AVX2_KERNEL
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+static CpaKernelFn selectKernel()
+{
+#ifdef CPA_HAVE_AVX2_KERNEL
+    if (cpaAvx2Supported()) {
+        return cpaBatchAvx2;
+    }
+#endif
+    return cpaBatchScalar;
+}
+
+void cpaBatch(const CpaReference& ref, const CpaCandidates& cand,
+              size_t count, CpaResults& out)
+{
+    static const CpaKernelFn kernel = selectKernel();
+    kernel(ref, cand, count, out);
+}
+
+const char* cpaKernelName()
+{
+    return (selectKernel() == cpaBatchScalar) ? "scalar" : "avx2";
+}
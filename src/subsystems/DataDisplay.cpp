@@ -5,20 +5,28 @@
 #include <unistd.h>
 #include <errno.h>
 #include <cstring>
-#include <sstream>
-#include <sys/neutrino.h>
+#include "Ipc.h"
 #include <sys/mman.h>
 #include "utils.h"
 #include "shm_utils.h"
 #include <math.h>
-#include <iomanip> 
-#include <sstream>
+#include <sys/uio.h>
+#include <algorithm>
+#include <ctime>
 
 
-DataDisplay::DataDisplay(const std::string& logPath)
-    : chid(-1), fd(-1), logPath(logPath)
+DataDisplay::DataDisplay(const std::string& logPath, const GridView& view)
+    : chid(-1), fd(-1), logPath(logPath), grid(view), liveFd(-1), liveFrames(0),
+      connections(logDataDisplayMessage), subscribed(false), running(true)
 {
     logDataDisplayMessage("DataDisplay initialized with log path: " + logPath);
+    const GridView& shown = grid.getView();
+    static const char* const details[] = { "auto", "ids", "counts", "density" };
+    LOG_DATA_DISPLAY(LOG_INFO, "Grid of ", shown.columns, "x", shown.rows, " cells of ",
+                     shown.cellSize / shown.zoom, " m centred on (", shown.centerX, ",", shown.centerY,
+                     "), detail ", details[shown.detail], ", shaded above ", shown.densityAbove, " aircraft, ",
+                     shown.bands, " altitude bands of ", shown.bandHeight, " m, side profile of ",
+                     shown.profileRows, " rows of ", shown.profileRowHeight, " m, both from ", shown.altitudeFloor, " m");
 }
 
 int DataDisplay::getChid() const {
@@ -49,16 +57,25 @@ void DataDisplay::registerChannelId() {
 void DataDisplay::run() {
     ensureLogDirectories();
     
-    chid = ChannelCreate(0);
+    chid = ipcChannelCreate();
     
     if (chid == -1) {
-        logDataDisplayMessage("ChannelCreate failed: " + std::string(strerror(errno)), LOG_ERROR);
+        logDataDisplayMessage("Channel creation failed: " + std::string(strerror(errno)), LOG_ERROR);
         return;
     }
     
     logDataDisplayMessage("Channel created with ID: " + std::to_string(chid));
     
-    registerChannelId();
+    if (sector.empty()) {
+        registerChannelId();
+    } else {
+        pid = getpid();
+        logDataDisplayMessage("Sector display " + sector + ", not registered as the main display");
+    }
+    std::thread subscription(&DataDisplay::renewSubscription, this);
+    if (ipcTimerCreate(chid, DISPLAY_STOP_CHECK_TIMER, 1000) == -1) {
+        logDataDisplayMessage("Failed to create stop check timer: " + std::string(strerror(errno)), LOG_ERROR);
+    }
     
     fd = open(logPath.c_str(), O_CREAT|O_WRONLY|O_APPEND, 0666);
     if (fd == -1) {
@@ -67,12 +84,27 @@ void DataDisplay::run() {
         logDataDisplayMessage("Log file opened successfully: " + logPath);
     }
 
+    if (!livePath.empty()) {
+        liveFd = open(livePath.c_str(), O_WRONLY | O_NOCTTY | O_CREAT | O_APPEND, 0666);
+        if (liveFd == -1) {
+            logDataDisplayMessage("Failed to open live display " + livePath + ": " + std::string(strerror(errno)) +
+                                ", logging grids instead", LOG_ERROR);
+        } else {
+            logDataDisplayMessage("Drawing grids live on " + livePath);
+        }
+    }
+
     receiveMessage();
+    running = false;
+    subscription.join();
 
     if (fd != -1) {
         close(fd);
     }
-    ChannelDestroy(chid);
+    if (liveFd != -1) {
+        close(liveFd);
+    }
+    ipcChannelDestroy(chid);
     
     logDataDisplayMessage("DataDisplay shutdown complete");
 }
@@ -82,30 +114,36 @@ void DataDisplay::receiveMessage() {
         dataDisplayCommandMessage msg;
     } buffer;
     
+    std::vector<AircraftDisplayEntry> entries;
+    IpcPulse pulse;
     int rcvid;
     
     logDataDisplayMessage("Starting message processing loop");
     
-    while (true) {
+    // The stop check timer wakes the loop to notice stop()
+    while (running) {
         memset(&buffer, 0, sizeof(buffer));
         
-        rcvid = MsgReceive(chid, &buffer, sizeof(buffer), nullptr);
+        rcvid = ipcReceive(chid, &buffer, sizeof(buffer), &pulse);
         if (rcvid == -1) {
-            logDataDisplayMessage("MsgReceive failed: " + std::string(strerror(errno)), LOG_ERROR);
+            logDataDisplayMessage("Receive failed: " + std::string(strerror(errno)), LOG_ERROR);
             sleep(1); 
             continue;
         }
+        if (rcvid == 0) {
+            continue;
+        }
         
         dataDisplayCommandMessage& msg = buffer.msg;
         
-        logDataDisplayMessage("Received message with command type: " + std::to_string(msg.commandType), LOG_DEBUG);
+        LOG_DATA_DISPLAY(LOG_DEBUG, "Received message with command type: ", msg.commandType);
         
         switch (msg.commandType) {
             case COMMAND_ONE_PLANE: {
-                MsgReply(rcvid, EOK, nullptr, 0);
+                ipcReply(rcvid, EOK, nullptr, 0);
                 
-                logDataDisplayMessage("Processing COMMAND_ONE_PLANE for aircraft: " + 
-                                   std::to_string(msg.commandBody.one.aircraftID), LOG_DEBUG);
+                LOG_DATA_DISPLAY(LOG_DEBUG, "Processing COMMAND_ONE_PLANE for aircraft: ",
+                                 msg.commandBody.one.aircraftID);
                 
                 if (isfinite(msg.commandBody.one.position.x) && 
                     isfinite(msg.commandBody.one.position.y) && 
@@ -133,13 +171,25 @@ void DataDisplay::receiveMessage() {
             case COMMAND_MULTIPLE_PLANE:
             case COMMAND_GRID:
             case COMMAND_LOG: {
-                MsgReply(rcvid, EOK, nullptr, 0);
-                
-                if (msg.commandBody.multiple.numberOfAircrafts > MAX_PLANES) {
+                size_t numberOfAircrafts = msg.commandBody.multiple.numberOfAircrafts;
+                if (numberOfAircrafts > MAX_RADAR_CAPACITY) {
                     logDataDisplayMessage("Invalid number of aircraft: " + 
-                                       std::to_string(msg.commandBody.multiple.numberOfAircrafts), LOG_ERROR);
+                                       std::to_string(numberOfAircrafts), LOG_ERROR);
+                    ipcError(rcvid, EINVAL);
+                    break;
+                }
+                
+                // The aircraft entries follow the fixed message header
+                entries.resize(numberOfAircrafts);
+                long bytes = (long)(numberOfAircrafts * sizeof(AircraftDisplayEntry));
+                if (bytes > 0 &&
+                    ipcRead(rcvid, entries.data(), bytes, sizeof(dataDisplayCommandMessage)) != bytes) {
+                    logDataDisplayMessage("Failed to read aircraft entries: " + 
+                                       std::string(strerror(errno)), LOG_ERROR);
+                    ipcError(rcvid, EBADMSG);
                     break;
                 }
+                ipcReply(rcvid, EOK, nullptr, 0);
                 
                 std::string cmdTypeStr;
                 if (msg.commandType == COMMAND_GRID) {
@@ -150,17 +200,17 @@ void DataDisplay::receiveMessage() {
                     cmdTypeStr = "MULTIPLE_PLANE";
                 }
                 
-                logDataDisplayMessage("Processing " + cmdTypeStr + " for " + 
-                                   std::to_string(msg.commandBody.multiple.numberOfAircrafts) + " aircraft", LOG_DEBUG);
+                LOG_DATA_DISPLAY(LOG_DEBUG, "Processing ", cmdTypeStr, " for ", numberOfAircrafts,
+                                 " aircraft");
                 
                 // Handle each command type
                 if (msg.commandType == COMMAND_MULTIPLE_PLANE) {
                     // Display info for each plane
-                    for (size_t i = 0; i < msg.commandBody.multiple.numberOfAircrafts; i++) {
+                    for (size_t i = 0; i < numberOfAircrafts; i++) {
                         // Validate data before using
-                        Vec3& pos = msg.commandBody.multiple.positionArray[i];
-                        Vec3& vel = msg.commandBody.multiple.velocityArray[i];
-                        int planeId = msg.commandBody.multiple.planeIDArray[i];
+                        const Vec3& pos = entries[i].position;
+                        const Vec3& vel = entries[i].velocity;
+                        int planeId = entries[i].planeId;
                         
                         if (!isfinite(pos.x) || !isfinite(pos.y) || !isfinite(pos.z) ||
                             !isfinite(vel.x) || !isfinite(vel.y) || !isfinite(vel.z)) {
@@ -178,105 +228,147 @@ void DataDisplay::receiveMessage() {
                         
                         logDataDisplayMessage(planeInfo);
                     }
-                } else if (msg.commandType == COMMAND_GRID) {
-                    // Generate and display grid
-                    std::string grid = generateGrid(msg.commandBody.multiple);
-                    logDataDisplayMessage("GRID:\n" + grid);
-                } else if (msg.commandType == COMMAND_LOG) {
-                    // Generate grid and log it
-                    std::string grid = generateGrid(msg.commandBody.multiple);
-                    logDataDisplayMessage("LOG:\n" + grid);
-                    
-                    if (fd != -1) {
-                        std::string s = printTimeStamp() + " LOG:\n" + grid + "\n";
-                        if (write(fd, s.c_str(), s.size()) == -1) {
-                            logDataDisplayMessage("Failed to write to log file: " + 
-                                                std::string(strerror(errno)), LOG_ERROR);
-                        }
-                    }
+                } else {
+                    logGrid(msg.commandType == COMMAND_GRID ? "GRID:" : "LOG:", entries,
+                            msg.commandType == COMMAND_LOG);
                 }
                 break;
             }
             
             case COMMAND_EXIT_THREAD:
                 logDataDisplayMessage("Received exit command");
-                MsgReply(rcvid, EOK, nullptr, 0);
+                ipcReply(rcvid, EOK, nullptr, 0);
                 return;
                 
             default:
                 logDataDisplayMessage("Unknown command type: " + 
                                     std::to_string(msg.commandType), LOG_WARNING);
-                MsgError(rcvid, ENOSYS);
+                ipcError(rcvid, ENOSYS);
                 break;
         }
     }
 }
 
-std::string centerText(const std::string &text, int width) {
-    if ((int)text.size() >= width)
-        return text;
-    int totalPadding = width - text.size();
-    int leftPadding = totalPadding / 2;
-    int rightPadding = totalPadding - leftPadding;
-    return std::string(leftPadding, ' ') + text + std::string(rightPadding, ' ');
+void DataDisplay::renewSubscription() {
+    while (running) {
+        subscribe();
+        for (int waited = 0; running && waited < DISPLAY_SUBSCRIBE_INTERVAL_MS; waited += 100) {
+            usleep(100000);
+        }
+    }
+    unsubscribe();
+}
+
+void DataDisplay::subscribe() {
+    int coid = connections.get(ENDPOINT_COMPUTER);
+    DisplaySubscribeMessage request;
+    memset(&request, 0, sizeof(request));
+    request.commandType = COMMAND_DISPLAY_SUBSCRIBE;
+    request.chid = chid;
+    request.pid = pid;
+    request.viewport = grid.getViewport();
+    if (coid == -1 || ipcSend(coid, &request, sizeof(request), nullptr, 0) == -1) {
+        // ComputerSystem may not be up yet; the timer tries again
+        if (subscribed) {
+            logDataDisplayMessage("Lost subscription to ComputerSystem: " + std::string(strerror(errno)),
+                                LOG_WARNING);
+        }
+        if (coid != -1) {
+            connections.invalidate(ENDPOINT_COMPUTER, coid);
+        }
+        subscribed = false;
+        return;
+    }
+    if (!subscribed) {
+        const DisplayViewport& v = request.viewport;
+        LOG_DATA_DISPLAY(LOG_INFO, "Subscribed to ComputerSystem for x ", v.min[0], "..", v.max[0],
+                         ", y ", v.min[1], "..", v.max[1], ", altitude ", v.min[2], "..", v.max[2]);
+    }
+    subscribed = true;
 }
 
+void DataDisplay::unsubscribe() {
+    int coid = connections.get(ENDPOINT_COMPUTER);
+    if (!subscribed || coid == -1) {
+        return;
+    }
+    DisplaySubscribeMessage request;
+    memset(&request, 0, sizeof(request));
+    request.commandType = COMMAND_DISPLAY_UNSUBSCRIBE;
+    request.chid = chid;
+    request.pid = pid;
+    ipcSend(coid, &request, sizeof(request), nullptr, 0);
+    subscribed = false;
+}
 
-std::string DataDisplay::generateGrid(const multipleAircraftDisplay& airspaceInfo) {
-    constexpr int rowSize = 25;
-    constexpr int colSize = 25;
-    constexpr int cell = 4000;
-    constexpr int cellWidth = 5;
-    std::string grid[rowSize][colSize];
-    
-    if (airspaceInfo.numberOfAircrafts > MAX_PLANES) {
-        logDataDisplayMessage("Invalid airspace data: too many aircraft", LOG_ERROR);
-        return "Error: Invalid data received";
+void DataDisplay::logGrid(const char* label, const std::vector<AircraftDisplayEntry>& aircraft,
+                          bool toFile) {
+    const std::string& frame = grid.render(aircraft.data(), aircraft.size());
+    if (liveFd != -1) {
+        drawLive();
     }
-    
-    // Place planes in grid
-    for (size_t i = 0; i < airspaceInfo.numberOfAircrafts; i++) {
-        // Validate data for this aircraft
-        if (!isfinite(airspaceInfo.positionArray[i].x) || 
-            !isfinite(airspaceInfo.positionArray[i].y)) {
-            continue; 
+    // Live, the grids sent for the console are on the terminal; only logged ones go in the log
+    const bool shaded = (grid.getDetail() == GRID_DETAIL_DENSITY);
+    if (liveFd == -1 || toFile) {
+        gridMessage.clear();
+        if (!sector.empty()) {
+            gridMessage += sector;
+            gridMessage += ' ';
         }
-        
-        double px = airspaceInfo.positionArray[i].x;
-        double py = airspaceInfo.positionArray[i].y;
-        int planeId = airspaceInfo.planeIDArray[i];
-        
-        // Find cell for this plane
-        for (int r = 0; r < rowSize; r++) {
-            double yMin = cell * r, yMax = cell * (r + 1);
-            if (py >= yMin && py < yMax) {
-                for (int c = 0; c < colSize; c++) {
-                    double xMin = cell * c, xMax = cell * (c + 1);
-                    if (px >= xMin && px < xMax) {
-                        if (!grid[r][c].empty())
-                            grid[r][c] += ",";
-                        std::stringstream ss;
-                        ss << std::setw(2) << std::setfill(' ') << planeId;
-                        grid[r][c] += ss.str();
-                    }
-                }
-            }
+        gridMessage += label;
+        if (shaded) {
+            gridMessage += "  ";
+            gridMessage += GRID_DENSITY_LEGEND;
         }
+        gridMessage += '\n';
+        gridMessage += frame;
+        logDataDisplayMessage(gridMessage);
     }
-    
-    // Generate the grid as a string, centering each cell’s content.
-    std::stringstream out;
-    for (int r = 0; r < rowSize; r++) {
-        out << "\n";
-        for (int c = 0; c < colSize; c++) {
-            // If cell is empty, use a single space.
-            std::string cellContent = grid[r][c].empty() ? " " : grid[r][c];
-            // Center the cell content in a fixed width.
-            out << "|" << centerText(cellContent, cellWidth);
+
+    // Same layout as before: "[time] LOG:\n", a blank line, the grid, a blank line.
+    // Shaded grids carry the legend on the LOG: line.
+    if (toFile && fd != -1) {
+        std::string stamp = printTimeStamp();
+        static const std::string shadedHeader = std::string(" LOG: ") + GRID_DENSITY_LEGEND + "\n";
+        struct iovec iov[4] = {
+            { &stamp[0], stamp.size() },
+            shaded ? iovec{ const_cast<char*>(shadedHeader.data()), shadedHeader.size() }
+                   : iovec{ const_cast<char*>(" LOG:\n"), 6 },
+            { const_cast<char*>(frame.data()), frame.size() },
+            { const_cast<char*>("\n"), 1 }
+        };
+        if (writev(fd, iov, 4) == -1) {
+            logDataDisplayMessage("Failed to write to log file: " + std::string(strerror(errno)), LOG_ERROR);
         }
     }
-    out << "\n";
-    return out.str();
+}
+
+void DataDisplay::drawLive() {
+    if (liveFrames++ % LIVE_REPAINT_FRAMES == 0) {
+        grid.repaint();
+    }
+    // Status on line 1, the grid below it
+    const std::string& update = grid.terminalUpdate(2);
+    char status[224];
+    time_t now = time(nullptr);
+    char clock[16];
+    strftime(clock, sizeof(clock), "%H:%M:%S", localtime(&now));
+    bool shaded = (grid.getDetail() == GRID_DETAIL_DENSITY);
+    int statusLength = snprintf(status, sizeof(status), "\x1b[1;1H\x1b[2K%s %s  %zu aircraft in view  "
+                                "%zu cells changed  %s", sector.empty() ? "Airspace" : sector.c_str(), clock,
+                                grid.getPlotted(), grid.getCellsChanged(),
+                                shaded ? GRID_DENSITY_LEGEND : "");
+    struct iovec iov[2] = {
+        { status, (size_t)std::min(statusLength, (int)sizeof(status) - 1) },
+        { const_cast<char*>(update.data()), update.size() }
+    };
+    if (writev(liveFd, iov, 2) == -1) {
+        logDataDisplayMessage("Failed to draw live display: " + std::string(strerror(errno)), LOG_ERROR);
+        grid.repaint();
+        return;
+    }
+    LOG_DATA_DISPLAY(LOG_DEBUG, "Live grid: ", grid.getPlotted(), " aircraft, ", grid.getCellsChanged(),
+                     " cells changed, ", iov[0].iov_len + update.size(), " bytes");
 }
 
 void DataDisplay::displayAirspace(double currentTime, const std::vector<Position>& positions) {
@@ -0,0 +1,297 @@
+#include "DisplaySubscriptions.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "Ipc.h"
+#include "utils.h"
+
+// Frames posted and not yet sent, the one in flight included
+static const int DISPLAY_SENDER_FRAMES = 2;
+
+struct DisplaySender::State {
+    pid_t pid;
+    int chid;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool started;
+    bool stopping;
+    bool inFlight;
+    int error;
+    int first;                  // Oldest slot the thread has not taken
+    int waiting;                // Slots the thread has not taken
+    int commands[DISPLAY_SENDER_FRAMES];
+    std::vector<AircraftDisplayEntry> frames[DISPLAY_SENDER_FRAMES];
+    std::vector<AircraftDisplayEntry> sending;  // Only touched by the thread
+};
+
+DisplaySender::DisplaySender(pid_t pid, int chid)
+    : state(std::make_shared<State>())
+{
+    state->pid = pid;
+    state->chid = chid;
+    state->started = false;
+    state->stopping = false;
+    state->inFlight = false;
+    state->error = 0;
+    state->first = 0;
+    state->waiting = 0;
+}
+
+DisplaySender::~DisplaySender()
+{
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->stopping = true;
+    state->wake.notify_one();
+}
+
+bool DisplaySender::ready() const
+{
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->waiting + (state->inFlight ? 1 : 0) < DISPLAY_SENDER_FRAMES && state->error == 0;
+}
+
+int DisplaySender::failure() const
+{
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->error;
+}
+
+bool DisplaySender::post(int commandType, std::vector<AircraftDisplayEntry>& aircraft)
+{
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->waiting + (state->inFlight ? 1 : 0) >= DISPLAY_SENDER_FRAMES || state->error != 0) {
+        return false;
+    }
+    int slot = (state->first + state->waiting) % DISPLAY_SENDER_FRAMES;
+    state->frames[slot].swap(aircraft);
+    state->commands[slot] = commandType;
+    state->waiting++;
+    if (!state->started) {
+        std::thread(&DisplaySender::run, state).detach();
+        state->started = true;
+    }
+    state->wake.notify_one();
+    return true;
+}
+
+void DisplaySender::run(std::shared_ptr<State> s)
+{
+    int coid = -1;
+    std::unique_lock<std::mutex> lock(s->mutex);
+    while (true) {
+        s->wake.wait(lock, [&s]() { return s->waiting > 0 || s->stopping; });
+        if (s->stopping) {
+            break;
+        }
+        // The slot keeps the buffer sent last, for post() to swap out again
+        s->sending.swap(s->frames[s->first]);
+        int commandType = s->commands[s->first];
+        s->first = (s->first + 1) % DISPLAY_SENDER_FRAMES;
+        s->waiting--;
+        s->inFlight = true;
+        lock.unlock();
+
+        dataDisplayCommandMessage msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.commandType = commandType;
+        msg.commandBody.multiple.numberOfAircrafts = s->sending.size();
+        IpcIov iov[2] = {
+            { &msg, sizeof(msg) },
+            { s->sending.data(), s->sending.size() * sizeof(AircraftDisplayEntry) }
+        };
+        if (coid == -1) {
+            coid = ipcConnect(s->pid, s->chid);
+        }
+        int error = 0;
+        if (coid == -1 || ipcSendv(coid, iov, 2, NULL, 0) == -1) {
+            error = errno ? errno : EIO;
+        }
+
+        lock.lock();
+        s->inFlight = false;
+        if (error != 0) {
+            s->error = error;
+            break;
+        }
+    }
+    lock.unlock();
+    if (coid != -1) {
+        ipcDisconnect(coid);
+    }
+}
+
+DisplaySubscriptions::DisplaySubscriptions(double cellSize)
+    : cellSize(cellSize), frame(nullptr), frameCount(0), indexed(false)
+{
+    columns = std::max(1, (int)std::ceil((AIRSPACE_X_MAX - AIRSPACE_X_MIN) / cellSize));
+    rows = std::max(1, (int)std::ceil((AIRSPACE_Y_MAX - AIRSPACE_Y_MIN) / cellSize));
+    bucketStart.assign((size_t)columns * rows + 1, 0);
+}
+
+bool DisplaySubscriptions::subscribe(pid_t pid, int chid, const DisplayViewport& viewport)
+{
+    for (Subscriber& s : subscribers) {
+        if (s.pid == pid && s.chid == chid) {
+            s.viewport = viewport;
+            return true;
+        }
+    }
+    if (subscribers.size() >= MAX_DISPLAY_SUBSCRIPTIONS) {
+        return false;
+    }
+    subscribers.push_back({ pid, chid, viewport, std::unique_ptr<DisplaySender>(new DisplaySender(pid, chid)), 0 });
+    return true;
+}
+
+bool DisplaySubscriptions::unsubscribe(pid_t pid, int chid)
+{
+    for (size_t i = 0; i < subscribers.size(); i++) {
+        if (subscribers[i].pid == pid && subscribers[i].chid == chid) {
+            remove(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void DisplaySubscriptions::remove(size_t i)
+{
+    subscribers.erase(subscribers.begin() + i);
+}
+
+bool DisplaySubscriptions::contains(pid_t pid, int chid) const
+{
+    for (const Subscriber& s : subscribers) {
+        if (s.pid == pid && s.chid == chid) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int DisplaySubscriptions::column(double x) const
+{
+    // Outside the sector (or NaN) goes in the edge buckets
+    double f = (x - AIRSPACE_X_MIN) / cellSize;
+    return !(f >= 0) ? 0 : (f >= columns ? columns - 1 : (int)f);
+}
+
+int DisplaySubscriptions::row(double y) const
+{
+    double f = (y - AIRSPACE_Y_MIN) / cellSize;
+    return !(f >= 0) ? 0 : (f >= rows ? rows - 1 : (int)f);
+}
+
+double DisplaySubscriptions::edge(int index, int count, double origin) const
+{
+    return (index <= 0) ? -HUGE_VAL : (index >= count ? HUGE_VAL : origin + index * cellSize);
+}
+
+void DisplaySubscriptions::index(const AircraftDisplayEntry* aircraft, size_t count)
+{
+    frame = aircraft;
+    frameCount = count;
+    indexed = false;
+}
+
+void DisplaySubscriptions::buildIndex()
+{
+    const AircraftDisplayEntry* aircraft = frame;
+    const size_t count = frameCount;
+    if (bucketOf.size() < count) {
+        bucketOf.resize(count);
+    }
+    sorted.resize(count);
+
+    // Counting sort by bucket, keeping frame order within each
+    std::fill(bucketStart.begin(), bucketStart.end(), 0);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t bucket = (uint32_t)(row(aircraft[i].position.y) * columns + column(aircraft[i].position.x));
+        bucketOf[i] = bucket;
+        bucketStart[bucket + 1]++;
+    }
+    for (size_t b = 1; b < bucketStart.size(); b++) {
+        bucketStart[b] += bucketStart[b - 1];
+    }
+    for (size_t i = 0; i < count; i++) {
+        sorted[bucketStart[bucketOf[i]]++] = aircraft[i];
+    }
+    // Each start now holds the next bucket's start; shift them back
+    for (size_t b = bucketStart.size() - 1; b > 0; b--) {
+        bucketStart[b] = bucketStart[b - 1];
+    }
+    bucketStart[0] = 0;
+    indexed = true;
+}
+
+void DisplaySubscriptions::scan(const DisplayViewport& viewport, std::vector<AircraftDisplayEntry>& out) const
+{
+    for (size_t i = 0; i < frameCount; i++) {
+        const Vec3& p = frame[i].position;
+        if (p.x >= viewport.min[0] && p.x <= viewport.max[0] && p.y >= viewport.min[1] &&
+            p.y <= viewport.max[1] && p.z >= viewport.min[2] && p.z <= viewport.max[2]) {
+            out.push_back(frame[i]);
+        }
+    }
+}
+
+void DisplaySubscriptions::select(const DisplayViewport& viewport, std::vector<AircraftDisplayEntry>& out,
+                                  DisplaySelectStats* stats)
+{
+    DisplaySelectStats local = { 0, 0, 0 };
+    out.clear();
+    if (!(viewport.min[0] <= viewport.max[0] && viewport.min[1] <= viewport.max[1] &&
+          viewport.min[2] <= viewport.max[2])) {
+        if (stats) {
+            *stats = local;
+        }
+        return;
+    }
+
+    int c0 = column(viewport.min[0]), c1 = column(viewport.max[0]);
+    int r0 = row(viewport.min[1]), r1 = row(viewport.max[1]);
+    size_t covered = (size_t)(c1 - c0 + 1) * (r1 - r0 + 1);
+    if (subscribers.size() <= 1 || covered * 4 > (size_t)columns * rows * 3) {
+        // Indexing would cost about as much as the scanning it saves
+        scan(viewport, out);
+        local.tested = frameCount;
+    } else {
+        if (!indexed) {
+            buildIndex();
+        }
+        const bool everyAltitude = viewport.min[2] == -HUGE_VAL && viewport.max[2] == HUGE_VAL;
+        for (int r = r0; r <= r1; r++) {
+            bool rowInside = edge(r, rows, AIRSPACE_Y_MIN) >= viewport.min[1] &&
+                             edge(r + 1, rows, AIRSPACE_Y_MIN) <= viewport.max[1];
+            for (int c = c0; c <= c1; c++) {
+                size_t bucket = (size_t)r * columns + c;
+                const AircraftDisplayEntry* first = sorted.data() + bucketStart[bucket];
+                const AircraftDisplayEntry* last = sorted.data() + bucketStart[bucket + 1];
+                local.buckets++;
+                bool inside = rowInside && edge(c, columns, AIRSPACE_X_MIN) >= viewport.min[0] &&
+                              edge(c + 1, columns, AIRSPACE_X_MIN) <= viewport.max[0];
+                if (inside && everyAltitude) {
+                    out.insert(out.end(), first, last);
+                    continue;
+                }
+                local.tested += last - first;
+                for (const AircraftDisplayEntry* e = first; e < last; e++) {
+                    const Vec3& p = e->position;
+                    if ((inside || (p.x >= viewport.min[0] && p.x <= viewport.max[0] &&
+                                    p.y >= viewport.min[1] && p.y <= viewport.max[1])) &&
+                        p.z >= viewport.min[2] && p.z <= viewport.max[2]) {
+                        out.push_back(*e);
+                    }
+                }
+            }
+        }
+    }
+    local.selected = out.size();
+    if (stats) {
+        *stats = local;
+    }
+}
@@ -0,0 +1,142 @@
+#include "EventLog.h"
+#include <mutex>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "utils.h"
+
+const EventInfo EVENT_CATALOG[EVT_COUNT] = {
+    { "radar.frame",          LOG_DEBUG,   2, { "tracks", "sequence" } },
+    { "track.position",       LOG_DEBUG,   4, { "plane", "x", "y", "z" } },
+    { "track.stopped",        LOG_WARNING, 4, { "plane", "x", "y", "z" } },
+    { "command.queued",       LOG_INFO,    5, { "sequence", "plane", "vx", "vy", "vz" } },
+    { "command.transmitted",  LOG_INFO,    5, { "sequence", "plane", "vx", "vy", "vz" } },
+    { "command.applied",      LOG_INFO,    6, { "sequence", "plane", "status", "vx", "vy", "vz" } },
+    { "command.acknowledged", LOG_INFO,    4, { "sequence", "plane", "status", "issueToApplyMs" } },
+    { "violation.check",      LOG_DEBUG,   4, { "pairs", "changed", "conflicts", "fullPass" } },
+    { "conflict",             LOG_WARNING, 3, { "plane1", "plane2", "timeToClosestApproach" } },
+};
+
+const char* const EVENT_SUBSYSTEM_NAMES[EVSUB_COUNT] = {
+    "ATCController",
+    "Radar",
+    "ComputerSystem",
+    "OperatorConsole",
+    "DataDisplay",
+    "CommunicationSystem",
+    "AirspaceLogger",
+};
+
+std::atomic<int> eventLogState(EVENT_LOG_UNKNOWN);
+
+namespace {
+
+EventLogHeader* mappedHeader = nullptr;
+EventRecord* mappedRecords = nullptr;
+
+int64_t clockNanos(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+} // namespace
+
+bool eventLogCreate(const char* path, uint64_t records) {
+    // Bounded before the file is touched, so the size below cannot overflow
+    if (records == 0 || records > MAX_EVENT_LOG_RECORDS) {
+        logSystemMessage("Invalid event log size " + std::to_string(records) + " records, at most " +
+                         std::to_string(MAX_EVENT_LOG_RECORDS), LOG_ERROR);
+        return false;
+    }
+    ensureLogDirectories();
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd == -1) {
+        logSystemMessage("Failed to create event log " + std::string(path) + ": " +
+                         strerror(errno), LOG_ERROR);
+        return false;
+    }
+
+    size_t size = sizeof(EventLogHeader) + records * sizeof(EventRecord);
+    if (ftruncate(fd, (off_t)size) == -1) {
+        logSystemMessage("Failed to size event log " + std::string(path) + ": " +
+                         strerror(errno), LOG_ERROR);
+        close(fd);
+        return false;
+    }
+
+    // Records stay sparse until written; only the header is initialized
+    void* addr = mmap(nullptr, sizeof(EventLogHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    EventLogHeader* header = static_cast<EventLogHeader*>(addr);
+    header->recordSize = sizeof(EventRecord);
+    header->capacity = records;
+    header->createdMonotonicNs = clockNanos(CLOCK_MONOTONIC);
+    header->createdRealtimeNs = clockNanos(CLOCK_REALTIME);
+    header->next.store(0, std::memory_order_relaxed);
+    header->dropped.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = EVENT_LOG_MAGIC;
+    munmap(addr, sizeof(EventLogHeader));
+    return true;
+}
+
+bool eventLogOpen(const char* path) {
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(EventLogHeader)) {
+        close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    EventLogHeader* header = static_cast<EventLogHeader*>(addr);
+    if (header->magic != EVENT_LOG_MAGIC || header->recordSize != sizeof(EventRecord) ||
+        sizeof(EventLogHeader) + header->capacity * sizeof(EventRecord) > (size_t)st.st_size) {
+        munmap(addr, st.st_size);
+        return false;
+    }
+
+    mappedHeader = header;
+    mappedRecords = reinterpret_cast<EventRecord*>(static_cast<char*>(addr) + sizeof(EventLogHeader));
+    eventLogState.store(EVENT_LOG_ON, std::memory_order_release);
+    return true;
+}
+
+bool eventLogAttach() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        if (eventLogState.load(std::memory_order_acquire) != EVENT_LOG_UNKNOWN) {
+            return;
+        }
+        const char* path = getenv(EVENT_LOG_ENV);
+        if (!path || !*path || !eventLogOpen(path)) {
+            eventLogState.store(EVENT_LOG_OFF, std::memory_order_release);
+        }
+    });
+    return eventLogState.load(std::memory_order_acquire) == EVENT_LOG_ON;
+}
+
+EventRecord* eventLogClaim() {
+    uint64_t slot = mappedHeader->next.fetch_add(1, std::memory_order_relaxed);
+    if (slot >= mappedHeader->capacity) {
+        mappedHeader->dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return &mappedRecords[slot];
+}
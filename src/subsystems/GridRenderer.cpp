@@ -0,0 +1,399 @@
+#include "GridRenderer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+size_t formatNumber(int32_t value, char* out) {
+    char digits[12];
+    size_t n = 0;
+    uint32_t v = (value < 0) ? 0u - (uint32_t)value : (uint32_t)value;
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    if (value < 0) {
+        digits[n++] = '-';
+    }
+    size_t length = 0;
+    while (n > 0) {
+        out[length++] = digits[--n];
+    }
+    return length;
+}
+
+/** Format `id` right-aligned in at least two characters, as the grid always has */
+size_t formatId(int32_t id, char* out) {
+    if (id >= 0 && id < 10) {
+        out[0] = ' ';
+        out[1] = (char)('0' + id);
+        return 2;
+    }
+    return formatNumber(id, out);
+}
+
+} // namespace
+
+GridRenderer::GridRenderer(const GridView& initial)
+    : occupiedCount(0), writtenCount(0), previousCount(0), plotted(0), drawn(GRID_DETAIL_IDS),
+      repaintPending(true), rendersSinceUpdate(0), cellsChanged(0) {
+    if (!setView(initial)) {
+        setView(GridView());
+    }
+}
+
+bool GridRenderer::isValid(const GridView& view) {
+    return view.columns >= 1 && view.columns <= MAX_GRID_COLUMNS && view.rows >= 1 && view.rows <= MAX_GRID_ROWS &&
+           view.cellWidth >= 1 && view.cellWidth <= MAX_GRID_CELL_WIDTH &&
+           view.detail >= GRID_DETAIL_AUTO && view.detail <= GRID_DETAIL_DENSITY &&
+           view.bands >= 0 && view.bands <= MAX_GRID_BANDS && view.bandHeight > 0 &&
+           std::isfinite(view.bandHeight) && view.profileRows >= 0 && view.profileRows <= MAX_GRID_ROWS &&
+           view.profileRowHeight > 0 && std::isfinite(view.profileRowHeight) && std::isfinite(view.altitudeFloor) &&
+           view.cellSize > 0 && view.zoom > 0 && std::isfinite(view.cellSize / view.zoom) &&
+           view.cellSize / view.zoom > 0 && std::isfinite(view.centerX) && std::isfinite(view.centerY);
+}
+
+bool GridRenderer::setView(const GridView& next) {
+    if (!isValid(next)) {
+        return false;
+    }
+    view = next;
+    cellMetres = view.cellSize / view.zoom;
+    left = view.centerX - view.columns * cellMetres / 2;
+    top = view.centerY - view.rows * cellMetres / 2;
+    rowBytes = 1 + (size_t)view.columns * (view.cellWidth + 1);
+
+    // Plan views, each band's above the one below, then the side profile
+    const int planViews = std::max(1, view.bands);
+    const bool titled = view.bands > 0 || view.profileRows > 0;
+    planCells = (uint32_t)(view.columns * view.rows);
+    profileFirst = planViews * planCells;
+    lines = (size_t)planViews * view.rows + view.profileRows + (titled ? planViews + (view.profileRows > 0) : 0);
+    size_t cells = profileFirst + (size_t)view.columns * view.profileRows;
+
+    // A blank frame: "\n|     |     ...|     " per row, then "\n"
+    frame.assign(lines * rowBytes + 1, ' ');
+    cellOffset.resize(cells);
+    size_t line = 0;
+    auto blankRows = [&](uint32_t firstCell, int rows) {
+        for (int r = 0; r < rows; r++, line++) {
+            char* row = &frame[line * rowBytes];
+            row[0] = '\n';
+            for (int c = 0; c < view.columns; c++) {
+                row[1 + c * (view.cellWidth + 1)] = '|';
+                cellOffset[firstCell + r * view.columns + c] = (uint32_t)(line * rowBytes + c * (view.cellWidth + 1) + 2);
+            }
+        }
+    };
+    for (int band = planViews - 1; band >= 0; band--) {
+        if (view.bands > 0) {
+            double from = view.altitudeFloor + band * view.bandHeight;
+            title(line++, "Plan view, altitude %.0f to %.0f m", from, from + view.bandHeight);
+        } else if (titled) {
+            title(line++, "Plan view, every altitude", 0, 0);
+        }
+        blankRows(band * planCells, view.rows);
+    }
+    if (view.profileRows > 0) {
+        title(line++, "Side profile, x across and altitude up, %.0f to %.0f m", view.altitudeFloor,
+              view.altitudeFloor + view.profileRows * view.profileRowHeight);
+        blankRows(profileFirst, view.profileRows);
+    }
+    frame.back() = '\n';
+
+    cellCount.assign(cells, 0);
+    cellEnd.assign(cells, 0);
+    occupied.assign(cells + 1, 0);     // The branch-free push writes one past the last occupied cell
+    occupiedCount = 0;
+    written.assign(cells, 0);
+    writtenCount = 0;
+    previous.assign(cells, 0);
+    previousCount = 0;
+    repaintPending = true;
+    return true;
+}
+
+DisplayViewport GridRenderer::getViewport() const {
+    DisplayViewport v;
+    v.min[0] = left;
+    v.max[0] = left + view.columns * cellMetres;
+    v.min[1] = top;
+    v.max[1] = top + view.rows * cellMetres;
+    if (view.bands == 0) {
+        // One plan view of every altitude
+        v.min[2] = -HUGE_VAL;
+        v.max[2] = HUGE_VAL;
+    } else {
+        v.min[2] = view.altitudeFloor;
+        v.max[2] = view.altitudeFloor + std::max(view.bands * view.bandHeight, view.profileRows * view.profileRowHeight);
+    }
+    return v;
+}
+
+void GridRenderer::title(size_t line, const char* format, double from, double to) {
+    char text[96];
+    int length = snprintf(text, sizeof(text), format, from, to);
+    char* row = &frame[line * rowBytes];
+    row[0] = '\n';
+    for (size_t c = 0; c < (size_t)std::max(0, length) && c < sizeof(text) - 1 && c + 1 < rowBytes; c++) {
+        row[1 + c] = text[c];
+    }
+}
+
+const std::string& GridRenderer::render(const AircraftDisplayEntry* aircraft, size_t count) {
+    // Cells are a few characters wide: plain loops beat memset and memcpy calls
+    char* text = &frame[0];
+    const int width = view.cellWidth;
+    std::swap(previous, written);
+    previousCount = writtenCount;
+    for (size_t k = 0; k < previousCount; k++) {
+        char* cell = text + previous[k];
+        for (int c = 0; c < width; c++) {
+            cell[c] = ' ';
+        }
+    }
+
+    // Bin each aircraft into the views it shows in: a plan view and the side
+    // profile. Count how many each occupied cell holds.
+    const size_t perAircraft = (view.profileRows > 0) ? 2 : 1;
+    if (binCell.size() < count * perAircraft) {
+        binCell.resize(count * perAircraft);
+        binId.resize(count * perAircraft);
+        flagged.resize(count * perAircraft);
+    }
+    uint32_t* counts = cellCount.data();
+    uint32_t* occupiedCells = occupied.data();
+    size_t nOccupied = 0;
+    size_t nBins = 0;
+    size_t nFlagged = 0;
+    plotted = 0;
+    for (size_t i = 0; i < count; i++) {
+        // Divided, not scaled by a reciprocal, so cell edges fall exactly on multiples of the cell size
+        double fx = (aircraft[i].position.x - left) / cellMetres;
+        double fy = (aircraft[i].position.y - top) / cellMetres;
+        // Also false for NaN
+        if (!(fx >= 0 && fx < view.columns && fy >= 0 && fy < view.rows)) {
+            continue;
+        }
+        plotted++;
+        uint32_t column = (uint32_t)fx;
+        uint32_t cells[2];
+        size_t n = 0;
+        if (view.bands == 0) {
+            cells[n++] = (uint32_t)fy * view.columns + column;
+        } else {
+            double fb = (aircraft[i].position.z - view.altitudeFloor) / view.bandHeight;
+            if (fb >= 0 && fb < view.bands) {
+                cells[n++] = (uint32_t)fb * planCells + (uint32_t)fy * view.columns + column;
+            }
+        }
+        if (view.profileRows > 0) {
+            double fz = (aircraft[i].position.z - view.altitudeFloor) / view.profileRowHeight;
+            if (fz >= 0 && fz < view.profileRows) {
+                // Highest row first
+                cells[n++] = profileFirst + (view.profileRows - 1 - (uint32_t)fz) * view.columns + column;
+            }
+        }
+        for (size_t k = 0; k < n; k++) {
+            uint32_t cell = cells[k];
+            binCell[nBins] = cell;
+            binId[nBins++] = aircraft[i].planeId;
+            // Branch-free: whether a cell is new is as good as random
+            occupiedCells[nOccupied] = cell;
+            nOccupied += (counts[cell]++ == 0);
+            if (aircraft[i].flags & AIRCRAFT_IN_CONFLICT) {
+                flagged[nFlagged++] = (uint64_t)cell << 32 | i;
+            }
+        }
+    }
+    occupiedCount = nOccupied;
+
+    drawn = view.detail;
+    if (drawn == GRID_DETAIL_AUTO) {
+        drawn = (plotted > view.densityAbove) ? GRID_DETAIL_DENSITY : GRID_DETAIL_IDS;
+    }
+
+    // Counting sort by cell; cells are laid out in the order first seen.
+    // Counted and shaded frames need no ids.
+    if (drawn == GRID_DETAIL_IDS) {
+        uint32_t next = 0;
+        for (size_t k = 0; k < nOccupied; k++) {
+            cellEnd[occupiedCells[k]] = next;
+            next += counts[occupiedCells[k]];
+        }
+        if (ids.size() < nBins) {
+            ids.resize(nBins);
+        }
+        for (size_t b = 0; b < nBins; b++) {
+            ids[cellEnd[binCell[b]]++] = binId[b];
+        }
+    }
+    // Few aircraft are in conflict: sorting them groups them by cell, in input order
+    const uint64_t* flaggedBegin = flagged.data();
+    const uint64_t* flaggedEnd = flaggedBegin + nFlagged;
+    std::sort(flagged.begin(), flagged.begin() + nFlagged);
+
+    const bool mayOverflow = (view.detail == GRID_DETAIL_IDS);
+    for (size_t k = 0; k < nOccupied; k++) {
+        uint32_t cell = occupiedCells[k];
+        uint32_t n = counts[cell];
+        written[k] = cellOffset[cell];
+        char* out = text + written[k];
+        counts[cell] = 0;
+        if (drawn == GRID_DETAIL_IDS && writeIds(out, &ids[cellEnd[cell] - n], n, 0, mayOverflow)) {
+            continue;
+        }
+
+        // Summarised: aircraft in conflict by id, else the count or shade
+        const uint64_t* f = nFlagged ? std::lower_bound(flaggedBegin, flaggedEnd, (uint64_t)cell << 32)
+                                     : flaggedEnd;
+        if (f != flaggedEnd && (*f >> 32) == cell) {
+            // More than this many ids cannot fit, so the '+' still shows
+            int32_t inConflict[MAX_GRID_CELL_WIDTH + 1];
+            uint32_t m = 0;
+            for (; f != flaggedEnd && (*f >> 32) == cell && m <= (uint32_t)MAX_GRID_CELL_WIDTH; f++) {
+                inConflict[m++] = aircraft[(uint32_t)*f].planeId;
+            }
+            writeIds(out, inConflict, m, '!', true);
+        } else if (drawn == GRID_DETAIL_DENSITY) {
+            writeShade(out, n);
+        } else {
+            writeCount(out, n);
+        }
+    }
+    writtenCount = nOccupied;
+    rendersSinceUpdate++;
+    return frame;
+}
+
+void GridRenderer::moveCursor(int line, int column) {
+    char buffer[32];
+    size_t n = 0;
+    buffer[n++] = '\x1b';
+    buffer[n++] = '[';
+    n += formatNumber(line, buffer + n);
+    buffer[n++] = ';';
+    n += formatNumber(column, buffer + n);
+    buffer[n++] = 'H';
+    ansi.append(buffer, n);
+}
+
+const std::string& GridRenderer::terminalUpdate(int firstLine) {
+    ansi.clear();
+    const size_t width = (size_t)view.cellWidth;
+    if (repaintPending || rendersSinceUpdate > 1 || shown.size() != frame.size()) {
+        // Clear from the grid down, then draw every row
+        moveCursor(firstLine, 1);
+        ansi += "\x1b[J";
+        for (size_t line = 0; line < lines; line++) {
+            moveCursor(firstLine + (int)line, 1);
+            ansi.append(frame, line * rowBytes + 1, rowBytes - 1);
+        }
+        shown = frame;
+        cellsChanged = cellOffset.size();
+        repaintPending = false;
+    } else {
+        // Cells written by either of the last two renders are the only ones that can differ
+        cellsChanged = 0;
+        const uint32_t* lists[2] = { previous.data(), written.data() };
+        size_t counts[2] = { previousCount, writtenCount };
+        for (int l = 0; l < 2; l++) {
+            for (size_t k = 0; k < counts[l]; k++) {
+                uint32_t offset = lists[l][k];
+                if (frame.compare(offset, width, shown, offset, width) == 0) {
+                    continue;
+                }
+                moveCursor(firstLine + (int)(offset / rowBytes), (int)(offset % rowBytes));
+                ansi.append(frame, offset, width);
+                shown.replace(offset, width, frame, offset, width);
+                cellsChanged++;
+            }
+        }
+    }
+    moveCursor(firstLine + (int)lines, 1);
+    rendersSinceUpdate = 0;
+    return ansi;
+}
+
+bool GridRenderer::writeIds(char* out, const int32_t* cellIds, uint32_t n, char marker, bool overflow) {
+    const size_t width = (size_t)view.cellWidth;
+    char text[MAX_GRID_CELL_WIDTH + 12];
+    size_t length = 0;
+    if (marker) {
+        text[length++] = marker;
+    }
+    const size_t start = length;
+    bool more = false;
+    for (uint32_t k = 0; k < n; k++) {
+        char id[12];
+        // After a marker, ids are not padded: "!1,2"
+        size_t idLength = marker ? formatNumber(cellIds[k], id) : formatId(cellIds[k], id);
+        size_t needed = idLength + (length > start ? 1 : 0);
+        // Keep room for the '+' unless this is the last id
+        size_t room = (k + 1 == n) ? width : width - 1;
+        if (length + needed > room) {
+            more = true;
+            break;
+        }
+        if (length > start) {
+            text[length++] = ',';
+        }
+        for (size_t c = 0; c < idLength; c++) {
+            text[length++] = id[c];
+        }
+    }
+    if (more) {
+        if (!overflow) {
+            return false;
+        }
+        if (length < width) {
+            text[length++] = '+';
+        }
+    }
+    out += (width - length) / 2;
+    for (size_t c = 0; c < length; c++) {
+        out[c] = text[c];
+    }
+    return true;
+}
+
+void GridRenderer::writeCount(char* out, uint32_t n) {
+    const size_t width = (size_t)view.cellWidth;
+    char digits[12];
+    size_t digitsLength = formatNumber((int32_t)std::min<uint32_t>(n, INT32_MAX), digits);
+    char text[MAX_GRID_CELL_WIDTH];
+    size_t length = 0;
+    if (digitsLength + 2 <= width) {
+        text[length++] = '[';
+        for (size_t c = 0; c < digitsLength; c++) {
+            text[length++] = digits[c];
+        }
+        text[length++] = ']';
+    } else if (digitsLength <= width) {
+        for (size_t c = 0; c < digitsLength; c++) {
+            text[length++] = digits[c];
+        }
+    } else {
+        // "99+": more than the largest count that fits
+        while (length + 1 < width) {
+            text[length++] = '9';
+        }
+        text[length++] = '+';
+    }
+    out += (width - length) / 2;
+    for (size_t c = 0; c < length; c++) {
+        out[c] = text[c];
+    }
+}
+
+void GridRenderer::writeShade(char* out, uint32_t n) {
+    // Level k holds up to 2^(k-1) aircraft; the last level holds the rest
+    size_t level = 0;
+    while (level + 1 < sizeof(GRID_DENSITY_SHADES) - 1 && (1u << level) < n) {
+        level++;
+    }
+    for (int c = 0; c < view.cellWidth; c++) {
+        out[c] = GRID_DENSITY_SHADES[level];
+    }
+}
@@ -0,0 +1,146 @@
+#include "HistoryQuery.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+template <typename T>
+bool overlaps(const HistoryQuery& query, const T* min, const T* max) {
+    for (int d = 0; d < 3; d++) {
+        if (max[d] < query.min[d] || min[d] > query.max[d]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool contains(const HistoryQuery& query, const HistoryTrackPoint& p) {
+    return p.x >= query.min[0] && p.x <= query.max[0] &&
+           p.y >= query.min[1] && p.y <= query.max[1] &&
+           p.z >= query.min[2] && p.z <= query.max[2];
+}
+
+/** Round as the residual codec does, so decoded frames match span reads */
+double quantized(double v, double quantum) {
+    return llround(v / quantum) * quantum;
+}
+
+} // namespace
+
+bool queryHistory(const AirspaceHistoryReader& reader, const HistoryQuery& query,
+                  std::vector<HistoryTrackPoint>& points, HistoryQueryStats* stats) {
+    HistoryQueryStats local;
+    HistoryQueryStats& st = stats ? *stats : local;
+    st = HistoryQueryStats();
+    points.clear();
+
+    std::vector<int32_t> ids(query.ids);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    const uint64_t first = reader.seek(query.fromNs);
+    const uint64_t end = (query.toNs == INT64_MAX) ? reader.tickCount() : reader.seek(query.toNs + 1);
+    bool intact = true;
+
+    // Frames without a summary: decode whole and filter
+    HistoryFrame frame;
+    auto decodeFrames = [&](uint64_t from, uint64_t to) {
+        for (uint64_t i = from; i < to; i++) {
+            if (!reader.readFrame(i, frame)) {
+                intact = false;
+                continue;
+            }
+            st.framesDecoded++;
+            for (size_t k = 0; k < frame.size(); k++) {
+                if (!ids.empty() && !std::binary_search(ids.begin(), ids.end(), frame.ids[k])) {
+                    continue;
+                }
+                HistoryTrackPoint p = { i, frame.ids[k],
+                    quantized(frame.x[k], HISTORY_POSITION_QUANTUM),
+                    quantized(frame.y[k], HISTORY_POSITION_QUANTUM),
+                    quantized(frame.z[k], HISTORY_POSITION_QUANTUM),
+                    quantized(frame.vx[k], HISTORY_VELOCITY_QUANTUM),
+                    quantized(frame.vy[k], HISTORY_VELOCITY_QUANTUM),
+                    quantized(frame.vz[k], HISTORY_VELOCITY_QUANTUM) };
+                if (!query.boxed || contains(query, p)) {
+                    points.push_back(p);
+                }
+            }
+        }
+    };
+
+    // First summary that ends after `first`
+    uint64_t lo = 0, hi = reader.blockCount();
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        const HistoryBlockSummary& s = reader.block(mid);
+        if (s.firstTick + s.ticks <= first) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    uint64_t tick = first;     // Frames before it are done
+    for (uint64_t b = lo; b < reader.blockCount() && reader.block(b).firstTick < end; b++) {
+        const HistoryBlockSummary& s = reader.block(b);
+        if (s.firstTick > tick) {
+            decodeFrames(tick, s.firstTick);
+        }
+        tick = std::max(tick, std::min(s.firstTick + s.ticks, end));
+
+        st.blocks++;
+        if (query.boxed && !overlaps(query, s.min, s.max)) {
+            st.blocksSkipped++;
+            continue;
+        }
+        const HistoryAircraftSpan* spans = reader.spans(s);
+        if (!spans) {
+            intact = false;
+            continue;
+        }
+
+        auto readSpan = [&](const HistoryAircraftSpan& span) {
+            uint64_t spanFirst = s.firstTick + span.firstTick;
+            if (spanFirst + span.ticks <= first || spanFirst >= end) {
+                return;
+            }
+            if (query.boxed && !overlaps(query, span.min, span.max)) {
+                st.spansSkipped++;
+                return;
+            }
+            size_t before = points.size();
+            if (!reader.readSpan(s, span, first, end, points)) {
+                intact = false;
+            }
+            st.spansRead++;
+            if (query.boxed) {
+                points.erase(std::remove_if(points.begin() + before, points.end(),
+                                            [&query](const HistoryTrackPoint& p) { return !contains(query, p); }),
+                             points.end());
+            }
+        };
+
+        if (ids.empty()) {
+            for (uint32_t i = 0; i < s.spans; i++) {
+                readSpan(spans[i]);
+            }
+        } else {
+            for (int32_t id : ids) {
+                const HistoryAircraftSpan* found = std::lower_bound(spans, spans + s.spans, id,
+                    [](const HistoryAircraftSpan& span, int32_t value) { return span.id < value; });
+                for (; found < spans + s.spans && found->id == id; found++) {
+                    readSpan(*found);
+                }
+            }
+        }
+    }
+    if (tick < end) {
+        decodeFrames(tick, end);
+    }
+
+    std::sort(points.begin(), points.end(), [](const HistoryTrackPoint& a, const HistoryTrackPoint& b) {
+        return a.tick != b.tick ? a.tick < b.tick : a.id < b.id;
+    });
+    return intact;
+}
@@ -0,0 +1,367 @@
+#include "IncrementalConflictDetector.h"
+#include "CpaKernel.h"
+#include <algorithm>
+#include <cmath>
+
+// Dead-reckoning error (m) beyond which a track counts as a trajectory change
+static const double POSITION_TOLERANCE = 1.0;
+
+// Slack (m) on the never-conflicts test to absorb rounding between a cached
+// result and a fresh one
+static const double SEPARATION_MARGIN = 1.0;
+
+// Fall back to a full pass when more than 1/N of the aircraft changed
+static const size_t REBUILD_CHANGED_FRACTION = 8;
+
+// Cells per side of the partner grid, at most
+static const int MAX_GRID_SIDE = 1024;
+
+IncrementalConflictDetector::IncrementalConflictDetector(double minHSep, double minVSep,
+                                                         double horizon, double interval)
+    : detector(minHSep, minVSep, horizon),
+      minHorizontalSeparation(minHSep),
+      minVerticalSeparation(minVSep),
+      horizonSeconds(horizon),
+      rebuildInterval(interval),
+      haveBaseline(false),
+      lastRebuildTime(0),
+      lastFrameTime(0),
+      rebuildHorizon(horizon),
+      cycle(0),
+      nextRevision(1),
+      gridMinX(0), gridMinY(0), gridCellSize(minHSep),
+      gridColumns(1), gridRows(1),
+      maxHorizontalSpeed(0),
+      pairsEvaluated(0),
+      lastCycleRebuilt(false)
+{
+}
+
+void IncrementalConflictDetector::reset()
+{
+    aircraft.clear();
+    pairs.clear();
+    haveBaseline = false;
+}
+
+uint64_t IncrementalConflictDetector::pairKey(int a, int b)
+{
+    if (a > b) {
+        std::swap(a, b);
+    }
+    return ((uint64_t)(uint32_t)a << 32) | (uint64_t)(uint32_t)b;
+}
+
+bool IncrementalConflictDetector::mayEverConflict(double horizontal, double vertical) const
+{
+    // After the closest approach the 3D distance only grows, so a pair whose
+    // minimum distance clears the diagonal of the minima never conflicts
+    double h = minHorizontalSeparation + SEPARATION_MARGIN;
+    double v = minVerticalSeparation + SEPARATION_MARGIN;
+    return horizontal * horizontal + vertical * vertical < h * h + v * v;
+}
+
+size_t IncrementalConflictDetector::loadFrame(const std::vector<RadarTrack>& tracks,
+                                              double frameTime)
+{
+    cycle++;
+    const size_t n = tracks.size();
+    x.resize(n);  y.resize(n);  z.resize(n);
+    vx.resize(n); vy.resize(n); vz.resize(n);
+    changedFlags.assign(n, 0);
+    changedIndices.clear();
+
+    for (size_t i = 0; i < n; i++) {
+        const RadarTrack& t = tracks[i];
+        x[i] = t.x;   y[i] = t.y;   z[i] = t.z;
+        vx[i] = t.vx; vy[i] = t.vy; vz[i] = t.vz;
+
+        auto it = aircraft.find(t.planeId);
+        bool changed = (it == aircraft.end());
+        if (!changed) {
+            const AircraftState& s = it->second;
+            double dt = frameTime - s.refTime;
+            changed = s.epoch != t.velocityEpoch ||
+                      s.vx != t.vx || s.vy != t.vy || s.vz != t.vz ||
+                      fabs(s.x + s.vx * dt - t.x) > POSITION_TOLERANCE ||
+                      fabs(s.y + s.vy * dt - t.y) > POSITION_TOLERANCE ||
+                      fabs(s.z + s.vz * dt - t.z) > POSITION_TOLERANCE;
+        }
+
+        AircraftState& s = aircraft[t.planeId];
+        if (changed) {
+            s = { t.velocityEpoch, nextRevision++, frameTime,
+                  t.x, t.y, t.z, t.vx, t.vy, t.vz, 0, 0 };
+            changedFlags[i] = 1;
+            changedIndices.push_back((uint32_t)i);
+        }
+        s.index = (uint32_t)i;
+        s.lastSeen = cycle;
+    }
+
+    // Aircraft that left the frame; their pairs are dropped lazily
+    for (auto it = aircraft.begin(); it != aircraft.end();) {
+        if (it->second.lastSeen != cycle) {
+            it = aircraft.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    return changedIndices.size();
+}
+
+void IncrementalConflictDetector::storePair(const RadarTrack& a, const RadarTrack& b,
+                                            double frameTime, double t,
+                                            double horizontal, double vertical)
+{
+    // Keys and revisions are ordered by plane ID, lowest first
+    int firstId = std::min(a.planeId, b.planeId);
+    int secondId = std::max(a.planeId, b.planeId);
+    PairState& p = pairs[pairKey(firstId, secondId)];
+    p.firstRevision = aircraft[firstId].revision;
+    p.secondRevision = aircraft[secondId].revision;
+    p.closestApproachTime = frameTime + t;
+    p.horizontalSeparation = horizontal;
+    p.verticalSeparation = vertical;
+}
+
+void IncrementalConflictDetector::rebuild(const std::vector<RadarTrack>& tracks,
+                                          double frameTime)
+{
+    // Pairs the broad phase drops cannot conflict before the next rebuild
+    // as long as both aircraft keep their trajectories
+    detector.setHorizon(horizonSeconds + rebuildInterval);
+    detector.findApproaches(tracks, approaches);
+    pairsEvaluated = approaches.size();
+
+    pairs.clear();
+    for (auto& entry : aircraft) {
+        AircraftState& s = entry.second;
+        const RadarTrack& t = tracks[s.index];
+        s.refTime = frameTime;
+        s.x = t.x; s.y = t.y; s.z = t.z;
+    }
+
+    for (const PairApproach& a : approaches) {
+        if (mayEverConflict(a.horizontalSeparation, a.verticalSeparation)) {
+            storePair(tracks[a.first], tracks[a.second], frameTime,
+                      a.timeToClosestApproach, a.horizontalSeparation, a.verticalSeparation);
+        }
+    }
+
+    haveBaseline = true;
+    lastRebuildTime = frameTime;
+    rebuildHorizon = horizonSeconds;
+    lastCycleRebuilt = true;
+}
+
+void IncrementalConflictDetector::buildGrid()
+{
+    const size_t n = x.size();
+    double maxX = x[0], maxY = y[0];
+    gridMinX = x[0];
+    gridMinY = y[0];
+    maxHorizontalSpeed = 0;
+    for (size_t i = 0; i < n; i++) {
+        gridMinX = std::min(gridMinX, x[i]);  maxX = std::max(maxX, x[i]);
+        gridMinY = std::min(gridMinY, y[i]);  maxY = std::max(maxY, y[i]);
+        maxHorizontalSpeed = std::max(maxHorizontalSpeed, sqrt(vx[i] * vx[i] + vy[i] * vy[i]));
+    }
+
+    // About one aircraft per cell, but no finer than the separation minimum
+    double width = maxX - gridMinX, height = maxY - gridMinY;
+    gridCellSize = std::max(minHorizontalSeparation, std::max(width, height) / sqrt((double)n));
+    gridCellSize = std::max(gridCellSize, std::max(width, height) / (MAX_GRID_SIDE - 1));
+    gridColumns = (int)(width / gridCellSize) + 1;
+    gridRows = (int)(height / gridCellSize) + 1;
+
+    // Counting sort of the aircraft by cell
+    gridStart.assign((size_t)gridColumns * gridRows + 1, 0);
+    gridCellOf.resize(n);
+    gridOrder.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        int cx = std::min(gridColumns - 1, (int)((x[i] - gridMinX) / gridCellSize));
+        int cy = std::min(gridRows - 1, (int)((y[i] - gridMinY) / gridCellSize));
+        gridCellOf[i] = (uint32_t)cy * gridColumns + cx;
+        gridStart[gridCellOf[i] + 1]++;
+    }
+    for (size_t k = 1; k < gridStart.size(); k++) {
+        gridStart[k] += gridStart[k - 1];
+    }
+    for (size_t i = 0; i < n; i++) {
+        gridOrder[gridStart[gridCellOf[i]]++] = (uint32_t)i;
+    }
+    for (size_t k = gridStart.size() - 1; k > 0; k--) {
+        gridStart[k] = gridStart[k - 1];
+    }
+    gridStart[0] = 0;
+}
+
+void IncrementalConflictDetector::findPartners(uint32_t c, double window)
+{
+    // Swept boxes over the window, padded by half the minima, overlap for
+    // any pair that loses separation within it (as in ConflictDetector)
+    const double padH = minHorizontalSeparation / 2 + SEPARATION_MARGIN;
+    const double padV = minVerticalSeparation / 2 + SEPARATION_MARGIN;
+    const double cMinX = std::min(x[c], x[c] + vx[c] * window) - padH;
+    const double cMaxX = std::max(x[c], x[c] + vx[c] * window) + padH;
+    const double cMinY = std::min(y[c], y[c] + vy[c] * window) - padH;
+    const double cMaxY = std::max(y[c], y[c] + vy[c] * window) + padH;
+    const double cMinZ = std::min(z[c], z[c] + vz[c] * window) - padV;
+    const double cMaxZ = std::max(z[c], z[c] + vz[c] * window) + padV;
+
+    // A partner starts within its own sweep and padding of that box
+    const double reachH = maxHorizontalSpeed * window + padH;
+    auto column = [this](double px) {
+        return std::max(0, std::min(gridColumns - 1, (int)floor((px - gridMinX) / gridCellSize)));
+    };
+    auto row = [this](double py) {
+        return std::max(0, std::min(gridRows - 1, (int)floor((py - gridMinY) / gridCellSize)));
+    };
+    const int cx0 = column(cMinX - reachH), cx1 = column(cMaxX + reachH);
+    const int cy0 = row(cMinY - reachH), cy1 = row(cMaxY + reachH);
+
+    partners.clear();
+    for (int cy = cy0; cy <= cy1; cy++) {
+        const uint32_t* first = gridOrder.data() + gridStart[(size_t)cy * gridColumns + cx0];
+        const uint32_t* last = gridOrder.data() + gridStart[(size_t)cy * gridColumns + cx1 + 1];
+        for (const uint32_t* it = first; it < last; it++) {
+            uint32_t j = *it;
+            // Pairs of two changed aircraft are evaluated once, from the later one
+            if (j == c || (changedFlags[j] && j < c)) {
+                continue;
+            }
+            double ex = x[j] + vx[j] * window, ey = y[j] + vy[j] * window, ez = z[j] + vz[j] * window;
+            if (std::min(x[j], ex) - padH <= cMaxX && std::max(x[j], ex) + padH >= cMinX &&
+                std::min(y[j], ey) - padH <= cMaxY && std::max(y[j], ey) + padH >= cMinY &&
+                std::min(z[j], ez) - padV <= cMaxZ && std::max(z[j], ez) + padV >= cMinZ) {
+                partners.push_back(j);
+            }
+        }
+    }
+}
+
+void IncrementalConflictDetector::refreshChanged(const std::vector<RadarTrack>& tracks,
+                                                 double frameTime)
+{
+    // Results must hold for every frame up to the next rebuild, each looking
+    // a horizon ahead
+    const double window = horizonSeconds + std::max(0.0, lastRebuildTime + rebuildInterval - frameTime);
+    buildGrid();
+
+    // A changed aircraft is checked against every aircraft that can come
+    // near it; the result holds for as long as neither aircraft changes again
+    for (uint32_t c : changedIndices) {
+        findPartners(c, window);
+        const size_t count = partners.size();
+        if (count == 0) {
+            continue;
+        }
+        partnerX.resize(count);  partnerY.resize(count);  partnerZ.resize(count);
+        partnerVx.resize(count); partnerVy.resize(count); partnerVz.resize(count);
+        resultTime.resize(count);
+        resultHorizontal.resize(count);
+        resultVertical.resize(count);
+        for (size_t k = 0; k < count; k++) {
+            uint32_t j = partners[k];
+            partnerX[k] = x[j];   partnerY[k] = y[j];   partnerZ[k] = z[j];
+            partnerVx[k] = vx[j]; partnerVy[k] = vy[j]; partnerVz[k] = vz[j];
+        }
+
+        CpaReference ref = { x[c], y[c], z[c], vx[c], vy[c], vz[c] };
+        CpaCandidates cand = { partnerX.data(), partnerY.data(), partnerZ.data(),
+                               partnerVx.data(), partnerVy.data(), partnerVz.data() };
+        CpaResults out = { resultTime.data(), resultHorizontal.data(), resultVertical.data() };
+        cpaBatch(ref, cand, count, out);
+        pairsEvaluated += count;
+
+        for (size_t k = 0; k < count; k++) {
+            if (mayEverConflict(resultHorizontal[k], resultVertical[k])) {
+                storePair(tracks[c], tracks[partners[k]], frameTime,
+                          resultTime[k], resultHorizontal[k], resultVertical[k]);
+            }
+        }
+    }
+}
+
+void IncrementalConflictDetector::evaluatePairs(const std::vector<RadarTrack>& tracks,
+                                                double frameTime)
+{
+    found.clear();
+
+    for (auto it = pairs.begin(); it != pairs.end();) {
+        int firstId = (int)(uint32_t)(it->first >> 32);
+        int secondId = (int)(uint32_t)it->first;
+        PairState& p = it->second;
+
+        auto a = aircraft.find(firstId);
+        auto b = aircraft.find(secondId);
+        if (a == aircraft.end() || b == aircraft.end() ||
+            a->second.revision != p.firstRevision ||
+            b->second.revision != p.secondRevision) {
+            it = pairs.erase(it);
+            continue;
+        }
+
+        uint32_t i = a->second.index;
+        uint32_t j = b->second.index;
+        double t = p.closestApproachTime - frameTime;
+
+        if (t <= 0) {
+            // Closest approach has passed; the current separation decides
+            CpaReference ref = { x[i], y[i], z[i], vx[i], vy[i], vz[i] };
+            CpaCandidates cand = { &x[j], &y[j], &z[j], &vx[j], &vy[j], &vz[j] };
+            CpaResults out = { &t, &p.horizontalSeparation, &p.verticalSeparation };
+            cpaBatch(ref, cand, 1, out);
+            p.closestApproachTime = frameTime + t;
+            pairsEvaluated++;
+
+            if (!mayEverConflict(p.horizontalSeparation, p.verticalSeparation)) {
+                it = pairs.erase(it);
+                continue;
+            }
+        }
+
+        if (t <= horizonSeconds &&
+            p.verticalSeparation < minVerticalSeparation &&
+            p.horizontalSeparation < minHorizontalSeparation) {
+            found.push_back({std::min(i, j), std::max(i, j), t});
+        }
+        ++it;
+    }
+}
+
+void IncrementalConflictDetector::detect(const std::vector<RadarTrack>& tracks,
+                                         double frameTime, std::vector<Conflict>& conflicts)
+{
+    conflicts.clear();
+    pairsEvaluated = 0;
+    lastCycleRebuilt = false;
+
+    const size_t n = tracks.size();
+    size_t changed = loadFrame(tracks, frameTime);
+
+    bool needRebuild = !haveBaseline ||
+                       frameTime < lastFrameTime ||
+                       frameTime - lastRebuildTime >= rebuildInterval ||
+                       horizonSeconds != rebuildHorizon ||
+                       changed * REBUILD_CHANGED_FRACTION > n;
+
+    if (needRebuild) {
+        rebuild(tracks, frameTime);
+    } else if (changed > 0) {
+        refreshChanged(tracks, frameTime);
+    }
+    lastFrameTime = frameTime;
+
+    evaluatePairs(tracks, frameTime);
+
+    // Report in the same order as a full pass: by frame index of each pair
+    std::sort(found.begin(), found.end());
+    conflicts.reserve(found.size());
+    for (const FoundConflict& f : found) {
+        conflicts.push_back({tracks[f.first].planeId, tracks[f.second].planeId,
+                             f.timeToClosestApproach});
+    }
+}
@@ -0,0 +1,773 @@
+#include "Ipc.h"
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include <climits>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include "shm_utils.h"
+
+namespace {
+
+const uint32_t CHANNEL_MAGIC = 0x41544343;     // "ATCC"
+const uint32_t RING_SIZE = 1024;               // Power of two
+const size_t INITIAL_MAILBOX_CAPACITY = 4096;
+
+enum RingEntryKind : uint32_t {
+    ENTRY_MESSAGE = 1,
+    ENTRY_PULSE = 2
+};
+
+enum MailboxState : uint32_t {
+    MAILBOX_IDLE = 0,
+    MAILBOX_PENDING = 1,
+    MAILBOX_REPLIED = 2
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+              std::atomic<uint32_t>::is_always_lock_free,
+              "futex words must be plain lock-free 32-bit atomics");
+
+/**
+ * Slot of the bounded multi-producer ring (Vyukov). A producer owns the
+ * cell when sequence == position and publishes it with position + 1; the
+ * consumer frees it for the next lap with position + RING_SIZE.
+ */
+struct RingCell {
+    std::atomic<uint64_t> sequence;
+    uint32_t kind;
+    int32_t code;
+    int32_t value;
+    int32_t senderPid;
+    int32_t senderCoid;
+};
+
+/** Layout of a channel segment, /atc_ch_<pid>_<chid> */
+struct ChannelHeader {
+    uint32_t magic;
+    int32_t ownerPid;
+    std::atomic<uint32_t> closed;
+    std::atomic<uint32_t> doorbell;     // Futex word, bumped on every push
+    std::atomic<uint32_t> sleepers;
+    alignas(64) std::atomic<uint64_t> enqueuePos;
+    alignas(64) std::atomic<uint64_t> dequeuePos;
+    alignas(64) RingCell cells[RING_SIZE];
+};
+
+/**
+ * Layout of a connection mailbox, /atc_mb_<pid>_<coid>: this header followed
+ * by `capacity` bytes holding the request, then the reply. Only the client
+ * grows it, and only while no request is pending.
+ */
+struct alignas(64) MailboxHeader {
+    std::atomic<uint32_t> state;        // Futex word the sender sleeps on
+    std::atomic<uint32_t> waiting;
+    std::atomic<uint32_t> closed;
+    int32_t status;
+    int32_t error;
+    uint64_t capacity;
+    uint64_t requestBytes;
+    uint64_t replyCapacity;
+    uint64_t replyBytes;
+};
+
+inline char* mailboxData(MailboxHeader* mb) {
+    return reinterpret_cast<char*>(mb + 1);
+}
+
+// Segments report nothing themselves: failures reach the caller as errno
+
+struct Channel {
+    int chid;
+    std::string name;
+    SharedMemorySegment segment{nullptr};
+    // Client mailboxes seen on this channel, keyed by (pid, coid)
+    std::unordered_map<uint64_t, std::unique_ptr<SharedMemorySegment>> mailboxes;
+
+    ChannelHeader* header() const { return segment.as<ChannelHeader>(); }
+};
+
+struct Connection {
+    pid_t pid;
+    int chid;
+    int coid;
+    std::string mailboxName;
+    SharedMemorySegment channelSegment{nullptr};
+    SharedMemorySegment mailboxSegment{nullptr};
+    std::mutex sendMutex;               // One request in flight per connection
+
+    ChannelHeader* channel() const { return channelSegment.as<ChannelHeader>(); }
+    MailboxHeader* mailbox() const { return mailboxSegment.as<MailboxHeader>(); }
+};
+
+struct Timer {
+    int fd;
+    int chid;
+    int code;
+};
+
+/** Process-wide IPC state; never destroyed so the timer thread can outlive main() */
+struct Registry {
+    std::mutex mutex;
+    int nextChid = 1;
+    int nextCoid = 1;                   // Never reused, so mailbox names stay unique
+    std::unordered_map<int, std::shared_ptr<Channel>> channels;
+    std::unordered_map<int, std::shared_ptr<Connection>> connections;
+
+    std::mutex pendingMutex;
+    std::vector<MailboxHeader*> pending;    // Indexed by rcvid - 1
+    std::vector<int> freeRcvids;
+
+    std::mutex timerMutex;
+    int epollFd = -1;
+    std::vector<Timer> timers;
+};
+
+Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+int spinIterations() {
+    static const int n = std::thread::hardware_concurrency() > 1 ? 2000 : 0;
+    return n;
+}
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+int futexWait(std::atomic<uint32_t>* word, uint32_t expected, const timespec* timeout) {
+    return (int)syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT,
+                        expected, timeout, nullptr, 0);
+}
+
+void futexWake(std::atomic<uint32_t>* word, int count) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+}
+
+bool processAlive(pid_t pid) {
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+std::string channelName(pid_t pid, int chid) {
+    return "/atc_ch_" + std::to_string(pid) + "_" + std::to_string(chid);
+}
+
+std::string mailboxName(pid_t pid, int coid) {
+    return "/atc_mb_" + std::to_string(pid) + "_" + std::to_string(coid);
+}
+
+uint64_t mailboxKey(int32_t pid, int32_t coid) {
+    return ((uint64_t)(uint32_t)pid << 32) | (uint32_t)coid;
+}
+
+bool ringTryPush(ChannelHeader* ch, const RingCell& entry) {
+    uint64_t pos = ch->enqueuePos.load(std::memory_order_relaxed);
+    RingCell* cell;
+    for (;;) {
+        cell = &ch->cells[pos & (RING_SIZE - 1)];
+        uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+        int64_t diff = (int64_t)seq - (int64_t)pos;
+        if (diff == 0) {
+            if (ch->enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = ch->enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->kind = entry.kind;
+    cell->code = entry.code;
+    cell->value = entry.value;
+    cell->senderPid = entry.senderPid;
+    cell->senderCoid = entry.senderCoid;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+
+    ch->doorbell.fetch_add(1, std::memory_order_seq_cst);
+    if (ch->sleepers.load(std::memory_order_seq_cst) != 0) {
+        futexWake(&ch->doorbell, INT_MAX);
+    }
+    return true;
+}
+
+bool ringTryPop(ChannelHeader* ch, RingCell& entry) {
+    uint64_t pos = ch->dequeuePos.load(std::memory_order_relaxed);
+    RingCell* cell;
+    for (;;) {
+        cell = &ch->cells[pos & (RING_SIZE - 1)];
+        uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+        int64_t diff = (int64_t)seq - (int64_t)(pos + 1);
+        if (diff == 0) {
+            if (ch->dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = ch->dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    entry.kind = cell->kind;
+    entry.code = cell->code;
+    entry.value = cell->value;
+    entry.senderPid = cell->senderPid;
+    entry.senderCoid = cell->senderCoid;
+    cell->sequence.store(pos + RING_SIZE, std::memory_order_release);
+    return true;
+}
+
+/** Push, yielding while the ring is full; fails if the receiver is gone */
+bool ringPush(ChannelHeader* ch, const RingCell& entry) {
+    for (int attempt = 0; ; attempt++) {
+        if (ch->closed.load(std::memory_order_acquire)) {
+            errno = ESRCH;
+            return false;
+        }
+        if (ringTryPush(ch, entry)) {
+            return true;
+        }
+        if ((attempt & 1023) == 1023 && !processAlive(ch->ownerPid)) {
+            errno = ESRCH;
+            return false;
+        }
+        sched_yield();
+    }
+}
+
+/** Block until an entry is available */
+bool ringPop(ChannelHeader* ch, RingCell& entry) {
+    for (;;) {
+        if (ringTryPop(ch, entry)) {
+            return true;
+        }
+        for (int i = 0; i < spinIterations(); i++) {
+            cpuRelax();
+            if (ringTryPop(ch, entry)) {
+                return true;
+            }
+        }
+        if (ch->closed.load(std::memory_order_acquire)) {
+            errno = EBADF;
+            return false;
+        }
+
+        uint32_t bell = ch->doorbell.load(std::memory_order_seq_cst);
+        ch->sleepers.fetch_add(1, std::memory_order_seq_cst);
+        if (ringTryPop(ch, entry)) {
+            ch->sleepers.fetch_sub(1, std::memory_order_seq_cst);
+            return true;
+        }
+        futexWait(&ch->doorbell, bell, nullptr);
+        ch->sleepers.fetch_sub(1, std::memory_order_seq_cst);
+    }
+}
+
+std::shared_ptr<Channel> findChannel(int chid) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto it = r.channels.find(chid);
+    return it == r.channels.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<Connection> findConnection(int coid) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto it = r.connections.find(coid);
+    return it == r.connections.end() ? nullptr : it->second;
+}
+
+/** Map a sender's mailbox on first use, and follow it when the sender grows it */
+MailboxHeader* mapMailbox(Channel& ch, int32_t pid, int32_t coid) {
+    std::unique_ptr<SharedMemorySegment>& seg = ch.mailboxes[mailboxKey(pid, coid)];
+    if (!seg) {
+        // Drop mailboxes of connections that have since been closed
+        for (auto it = ch.mailboxes.begin(); it != ch.mailboxes.end(); ) {
+            if (it->second && it->second->as<MailboxHeader>()->closed.load(std::memory_order_acquire)) {
+                it = ch.mailboxes.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        seg.reset(new SharedMemorySegment(nullptr));
+        std::string name = mailboxName(pid, coid);
+        if (!seg->open(name, sizeof(MailboxHeader), O_RDWR, false, 1)) {
+            ch.mailboxes.erase(mailboxKey(pid, coid));
+            return nullptr;
+        }
+        // Both sides hold a mapping now; nothing is left behind if either crashes
+        shm_unlink(name.c_str());
+    }
+
+    size_t needed = sizeof(MailboxHeader) + seg->as<MailboxHeader>()->capacity;
+    if (seg->size() < needed && !seg->remap(needed)) {
+        return nullptr;
+    }
+    return seg->as<MailboxHeader>();
+}
+
+int addPending(MailboxHeader* mb) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.pendingMutex);
+    if (!r.freeRcvids.empty()) {
+        int rcvid = r.freeRcvids.back();
+        r.freeRcvids.pop_back();
+        r.pending[rcvid - 1] = mb;
+        return rcvid;
+    }
+    r.pending.push_back(mb);
+    return (int)r.pending.size();
+}
+
+MailboxHeader* findPending(int rcvid, bool release) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.pendingMutex);
+    if (rcvid <= 0 || (size_t)rcvid > r.pending.size() || !r.pending[rcvid - 1]) {
+        return nullptr;
+    }
+    MailboxHeader* mb = r.pending[rcvid - 1];
+    if (release) {
+        r.pending[rcvid - 1] = nullptr;
+        r.freeRcvids.push_back(rcvid);
+    }
+    return mb;
+}
+
+void completeRequest(MailboxHeader* mb) {
+    mb->state.store(MAILBOX_REPLIED, std::memory_order_seq_cst);
+    if (mb->waiting.load(std::memory_order_seq_cst) != 0) {
+        futexWake(&mb->state, 1);
+    }
+}
+
+/** Wait for the reply; fails if the receiver exits or destroys its channel first */
+bool awaitReply(Connection& c) {
+    MailboxHeader* mb = c.mailbox();
+    for (int i = 0; i < spinIterations(); i++) {
+        if (mb->state.load(std::memory_order_acquire) != MAILBOX_PENDING) {
+            return true;
+        }
+        cpuRelax();
+    }
+
+    const timespec livenessCheck = { 1, 0 };
+    while (mb->state.load(std::memory_order_acquire) == MAILBOX_PENDING) {
+        mb->waiting.store(1, std::memory_order_seq_cst);
+        if (mb->state.load(std::memory_order_seq_cst) != MAILBOX_PENDING) {
+            mb->waiting.store(0, std::memory_order_relaxed);
+            break;
+        }
+        int rc = futexWait(&mb->state, MAILBOX_PENDING, &livenessCheck);
+        mb->waiting.store(0, std::memory_order_relaxed);
+
+        if (rc == -1 && errno == ETIMEDOUT &&
+            mb->state.load(std::memory_order_acquire) == MAILBOX_PENDING &&
+            (c.channel()->closed.load(std::memory_order_acquire) || !processAlive(c.pid))) {
+            mb->state.store(MAILBOX_IDLE, std::memory_order_relaxed);
+            errno = ESRCH;
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Make room for size bytes in the mailbox; only called with sendMutex held */
+bool ensureMailboxCapacity(Connection& c, size_t size) {
+    MailboxHeader* mb = c.mailbox();
+    if (mb->capacity >= size) {
+        return true;
+    }
+    size_t capacity = mb->capacity;
+    while (capacity < size) {
+        capacity *= 2;
+    }
+    if (!c.mailboxSegment.resize(sizeof(MailboxHeader) + capacity)) {
+        errno = ENOMEM;
+        return false;
+    }
+    c.mailbox()->capacity = capacity;
+    return true;
+}
+
+void timerLoop(int epollFd) {
+    Registry& r = registry();
+    epoll_event events[16];
+
+    for (;;) {
+        int n = epoll_wait(epollFd, events, 16, -1);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            logSystemMessage("Timer epoll_wait failed: " + std::string(strerror(errno)), LOG_ERROR);
+            return;
+        }
+
+        for (int i = 0; i < n; i++) {
+            Timer timer;
+            {
+                std::lock_guard<std::mutex> lock(r.timerMutex);
+                timer = r.timers[events[i].data.u32];
+            }
+
+            uint64_t expirations;
+            if (read(timer.fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                continue;
+            }
+
+            std::shared_ptr<Channel> ch = findChannel(timer.chid);
+            if (!ch) {
+                continue;
+            }
+            // Like a QNX timer pulse, an overrun is delivered as one pulse
+            RingCell entry = {};
+            entry.kind = ENTRY_PULSE;
+            entry.code = timer.code;
+            entry.value = (int32_t)expirations;
+            if (!ringTryPush(ch->header(), entry)) {
+                logSystemMessage("Channel " + std::to_string(timer.chid) +
+                               " full, dropped timer pulse " + std::to_string(timer.code),
+                               LOG_WARNING);
+            }
+        }
+    }
+}
+
+} // namespace
+
+int ipcChannelCreate()
+{
+    Registry& r = registry();
+    std::shared_ptr<Channel> ch = std::make_shared<Channel>();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        ch->chid = r.nextChid++;
+    }
+    ch->name = channelName(getpid(), ch->chid);
+
+    // A crashed predecessor with our PID may have left the name behind
+    shm_unlink(ch->name.c_str());
+    if (!ch->segment.open(ch->name, sizeof(ChannelHeader), O_RDWR, true, 1)) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    ChannelHeader* h = ch->header();
+    h->ownerPid = getpid();
+    h->closed.store(0, std::memory_order_relaxed);
+    h->doorbell.store(0, std::memory_order_relaxed);
+    h->sleepers.store(0, std::memory_order_relaxed);
+    h->enqueuePos.store(0, std::memory_order_relaxed);
+    h->dequeuePos.store(0, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < RING_SIZE; i++) {
+        h->cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    h->magic = CHANNEL_MAGIC;
+
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.channels[ch->chid] = ch;
+    return ch->chid;
+}
+
+int ipcChannelDestroy(int chid)
+{
+    Registry& r = registry();
+    std::shared_ptr<Channel> ch;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto it = r.channels.find(chid);
+        if (it == r.channels.end()) {
+            errno = EINVAL;
+            return -1;
+        }
+        ch = it->second;
+        r.channels.erase(it);
+    }
+
+    // Senders blocked on this channel notice on their next liveness check
+    ChannelHeader* h = ch->header();
+    h->closed.store(1, std::memory_order_release);
+    h->doorbell.fetch_add(1, std::memory_order_seq_cst);
+    futexWake(&h->doorbell, INT_MAX);
+    shm_unlink(ch->name.c_str());
+    return 0;
+}
+
+int ipcReceive(int chid, void* buf, size_t size, IpcPulse* pulse)
+{
+    std::shared_ptr<Channel> ch = findChannel(chid);
+    if (!ch) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (;;) {
+        RingCell entry;
+        if (!ringPop(ch->header(), entry)) {
+            return -1;
+        }
+
+        if (entry.kind == ENTRY_PULSE) {
+            if (pulse) {
+                pulse->code = entry.code;
+                pulse->value = entry.value;
+            }
+            return 0;
+        }
+
+        MailboxHeader* mb = mapMailbox(*ch, entry.senderPid, entry.senderCoid);
+        if (!mb) {
+            // The sender vanished before we could map its request
+            continue;
+        }
+        size_t n = std::min((size_t)mb->requestBytes, size);
+        memcpy(buf, mailboxData(mb), n);
+        return addPending(mb);
+    }
+}
+
+long ipcRead(int rcvid, void* buf, size_t bytes, size_t offset)
+{
+    MailboxHeader* mb = findPending(rcvid, false);
+    if (!mb) {
+        errno = ESRCH;
+        return -1;
+    }
+    if (offset >= mb->requestBytes) {
+        return 0;
+    }
+    size_t n = std::min(bytes, (size_t)mb->requestBytes - offset);
+    memcpy(buf, mailboxData(mb) + offset, n);
+    return (long)n;
+}
+
+int ipcReply(int rcvid, int status, const void* msg, size_t size)
+{
+    MailboxHeader* mb = findPending(rcvid, true);
+    if (!mb) {
+        errno = ESRCH;
+        return -1;
+    }
+    size_t n = std::min(size, (size_t)mb->replyCapacity);
+    if (n > 0) {
+        memcpy(mailboxData(mb), msg, n);
+    }
+    mb->replyBytes = n;
+    mb->status = status;
+    mb->error = 0;
+    completeRequest(mb);
+    return 0;
+}
+
+int ipcError(int rcvid, int err)
+{
+    MailboxHeader* mb = findPending(rcvid, true);
+    if (!mb) {
+        errno = ESRCH;
+        return -1;
+    }
+    mb->replyBytes = 0;
+    mb->status = -1;
+    mb->error = err;
+    completeRequest(mb);
+    return 0;
+}
+
+int ipcConnect(pid_t pid, int chid)
+{
+    Registry& r = registry();
+    std::shared_ptr<Connection> c = std::make_shared<Connection>();
+    c->pid = pid;
+    c->chid = chid;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        c->coid = r.nextCoid++;
+    }
+
+    if (!c->channelSegment.open(channelName(pid, chid), sizeof(ChannelHeader), O_RDWR, false, 1) ||
+        c->channel()->magic != CHANNEL_MAGIC ||
+        c->channel()->closed.load(std::memory_order_acquire)) {
+        errno = ESRCH;
+        return -1;
+    }
+
+    c->mailboxName = mailboxName(getpid(), c->coid);
+    shm_unlink(c->mailboxName.c_str());
+    if (!c->mailboxSegment.open(c->mailboxName, sizeof(MailboxHeader) + INITIAL_MAILBOX_CAPACITY,
+                                O_RDWR, true, 1)) {
+        errno = ENOMEM;
+        return -1;
+    }
+    c->mailbox()->capacity = INITIAL_MAILBOX_CAPACITY;
+
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.connections[c->coid] = c;
+    return c->coid;
+}
+
+int ipcDisconnect(int coid)
+{
+    Registry& r = registry();
+    std::shared_ptr<Connection> c;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        auto it = r.connections.find(coid);
+        if (it == r.connections.end()) {
+            errno = EINVAL;
+            return -1;
+        }
+        c = it->second;
+        r.connections.erase(it);
+    }
+
+    std::lock_guard<std::mutex> lock(c->sendMutex);
+    c->mailbox()->closed.store(1, std::memory_order_release);
+    shm_unlink(c->mailboxName.c_str());
+    return 0;
+}
+
+int ipcSend(int coid, const void* msg, size_t size, void* reply, size_t replySize)
+{
+    IpcIov iov = { msg, size };
+    return ipcSendv(coid, &iov, 1, reply, replySize);
+}
+
+int ipcSendv(int coid, const IpcIov* iov, int parts, void* reply, size_t replySize)
+{
+    std::shared_ptr<Connection> c = findConnection(coid);
+    if (!c) {
+        errno = EBADF;
+        return -1;
+    }
+
+    size_t total = 0;
+    for (int i = 0; i < parts; i++) {
+        total += iov[i].len;
+    }
+
+    std::lock_guard<std::mutex> lock(c->sendMutex);
+    if (!ensureMailboxCapacity(*c, std::max(total, replySize))) {
+        return -1;
+    }
+
+    MailboxHeader* mb = c->mailbox();
+    char* data = mailboxData(mb);
+    for (int i = 0; i < parts; i++) {
+        memcpy(data, iov[i].base, iov[i].len);
+        data += iov[i].len;
+    }
+    mb->requestBytes = total;
+    mb->replyCapacity = reply ? replySize : 0;
+    mb->replyBytes = 0;
+    mb->state.store(MAILBOX_PENDING, std::memory_order_relaxed);
+
+    RingCell entry = {};
+    entry.kind = ENTRY_MESSAGE;
+    entry.senderPid = getpid();
+    entry.senderCoid = coid;
+    if (!ringPush(c->channel(), entry)) {
+        mb->state.store(MAILBOX_IDLE, std::memory_order_relaxed);
+        return -1;
+    }
+
+    if (!awaitReply(*c)) {
+        return -1;
+    }
+    mb->state.store(MAILBOX_IDLE, std::memory_order_relaxed);
+
+    if (mb->error != 0) {
+        errno = mb->error;
+        return -1;
+    }
+    if (reply && mb->replyBytes > 0) {
+        memcpy(reply, mailboxData(mb), mb->replyBytes);
+    }
+    return mb->status;
+}
+
+int ipcSendPulse(int coid, int code, int value)
+{
+    std::shared_ptr<Connection> c = findConnection(coid);
+    if (!c) {
+        errno = EBADF;
+        return -1;
+    }
+
+    RingCell entry = {};
+    entry.kind = ENTRY_PULSE;
+    entry.code = code;
+    entry.value = value;
+    return ringPush(c->channel(), entry) ? 0 : -1;
+}
+
+int ipcTimerCreate(int chid, int code, int intervalMs)
+{
+    if (!findChannel(chid)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.timerMutex);
+
+    if (r.epollFd == -1) {
+        r.epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (r.epollFd == -1) {
+            return -1;
+        }
+        std::thread(timerLoop, r.epollFd).detach();
+    }
+
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+
+    struct itimerspec its;
+    its.it_value.tv_sec = intervalMs / 1000;
+    its.it_value.tv_nsec = (long)(intervalMs % 1000) * 1000000L;
+    its.it_interval = its.it_value;
+    if (timerfd_settime(fd, 0, &its, nullptr) == -1) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+
+    int id = (int)r.timers.size();
+    r.timers.push_back({ fd, chid, code });
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u32 = (uint32_t)id;
+    if (epoll_ctl(r.epollFd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        int err = errno;
+        close(fd);
+        r.timers.pop_back();
+        errno = err;
+        return -1;
+    }
+    return id;
+}
@@ -0,0 +1,121 @@
+#include "Ipc.h"
+#include <cstring>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/neutrino.h>
+
+int ipcChannelCreate()
+{
+    return ChannelCreate(0);
+}
+
+int ipcChannelDestroy(int chid)
+{
+    return ChannelDestroy(chid);
+}
+
+int ipcReceive(int chid, void* buf, size_t size, IpcPulse* pulse)
+{
+    // A pulse is written over the start of the buffer, so small buffers
+    // receive into a local one large enough to hold it
+    struct _pulse local;
+    bool small = size < sizeof(local);
+    void* target = small ? &local : buf;
+    size_t capacity = small ? sizeof(local) : size;
+
+    int rcvid = MsgReceive(chid, target, capacity, nullptr);
+    if (rcvid == 0) {
+        const struct _pulse* p = static_cast<const struct _pulse*>(target);
+        if (pulse) {
+            pulse->code = p->code;
+            pulse->value = p->value.sival_int;
+        }
+    } else if (rcvid > 0 && small) {
+        memcpy(buf, &local, size);
+    }
+    return rcvid;
+}
+
+long ipcRead(int rcvid, void* buf, size_t bytes, size_t offset)
+{
+    return MsgRead(rcvid, buf, bytes, offset);
+}
+
+int ipcReply(int rcvid, int status, const void* msg, size_t size)
+{
+    return MsgReply(rcvid, status, msg, size);
+}
+
+int ipcError(int rcvid, int err)
+{
+    return MsgError(rcvid, err);
+}
+
+int ipcConnect(pid_t pid, int chid)
+{
+    return ConnectAttach(0, pid, chid, _NTO_SIDE_CHANNEL, 0);
+}
+
+int ipcDisconnect(int coid)
+{
+    return ConnectDetach(coid);
+}
+
+int ipcSend(int coid, const void* msg, size_t size, void* reply, size_t replySize)
+{
+    return MsgSend(coid, msg, size, reply, replySize);
+}
+
+int ipcSendv(int coid, const IpcIov* iov, int parts, void* reply, size_t replySize)
+{
+    const int MAX_PARTS = 8;
+    if (parts < 0 || parts > MAX_PARTS) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    iov_t siov[MAX_PARTS];
+    for (int i = 0; i < parts; i++) {
+        SETIOV(&siov[i], iov[i].base, iov[i].len);
+    }
+    iov_t riov;
+    SETIOV(&riov, reply, replySize);
+    return MsgSendv(coid, siov, parts, &riov, reply ? 1 : 0);
+}
+
+int ipcSendPulse(int coid, int code, int value)
+{
+    return MsgSendPulse(coid, SIGEV_PULSE_PRIO_INHERIT, code, value);
+}
+
+int ipcTimerCreate(int chid, int code, int intervalMs)
+{
+    int coid = ConnectAttach(0, 0, chid, _NTO_SIDE_CHANNEL, 0);
+    if (coid == -1) {
+        return -1;
+    }
+
+    struct sigevent sev;
+    SIGEV_PULSE_INIT(&sev, coid, SIGEV_PULSE_PRIO_INHERIT, code, 0);
+    timer_t tid;
+    if (timer_create(CLOCK_MONOTONIC, &sev, &tid) == -1) {
+        int err = errno;
+        ConnectDetach(coid);
+        errno = err;
+        return -1;
+    }
+
+    struct itimerspec its;
+    its.it_value.tv_sec = intervalMs / 1000;
+    its.it_value.tv_nsec = (long)(intervalMs % 1000) * 1000000L;
+    its.it_interval = its.it_value;
+    if (timer_settime(tid, 0, &its, nullptr) == -1) {
+        int err = errno;
+        timer_delete(tid);
+        ConnectDetach(coid);
+        errno = err;
+        return -1;
+    }
+    return (int)tid;
+}
@@ -0,0 +1,143 @@
+#include "KinematicsEngine.h"
+#include <string>
+#include "utils.h"
+#include "EventLog.h"
+
+KinematicsEngine::KinematicsEngine() : nextEpoch(1) {
+}
+
+void KinematicsEngine::reserve(size_t n) {
+    ids.reserve(n);
+    x.reserve(n);  y.reserve(n);  z.reserve(n);
+    vx.reserve(n); vy.reserve(n); vz.reserve(n);
+    epochs.reserve(n);
+    indexById.reserve(n);
+}
+
+bool KinematicsEngine::addAircraft(int id, double px, double py, double pz,
+                                   double pvx, double pvy, double pvz) {
+    if (indexById.count(id)) {
+        return false;
+    }
+
+    indexById[id] = ids.size();
+    ids.push_back(id);
+    x.push_back(px);   y.push_back(py);   z.push_back(pz);
+    vx.push_back(pvx); vy.push_back(pvy); vz.push_back(pvz);
+    epochs.push_back(nextEpoch++);
+    return true;
+}
+
+bool KinematicsEngine::removeAircraft(int id) {
+    auto it = indexById.find(id);
+    if (it == indexById.end()) {
+        return false;
+    }
+
+    size_t i = it->second;
+    ids.erase(ids.begin() + i);
+    x.erase(x.begin() + i);   y.erase(y.begin() + i);   z.erase(z.begin() + i);
+    vx.erase(vx.begin() + i); vy.erase(vy.begin() + i); vz.erase(vz.begin() + i);
+    epochs.erase(epochs.begin() + i);
+
+    indexById.erase(it);
+    for (size_t k = i; k < ids.size(); k++) {
+        indexById[ids[k]] = k;
+    }
+    return true;
+}
+
+bool KinematicsEngine::setVelocity(int id, double pvx, double pvy, double pvz) {
+    auto it = indexById.find(id);
+    if (it == indexById.end()) {
+        return false;
+    }
+
+    size_t i = it->second;
+    vx[i] = pvx;
+    vy[i] = pvy;
+    vz[i] = pvz;
+    epochs[i] = nextEpoch++;
+    return true;
+}
+
+void KinematicsEngine::advance(double dt) {
+    if (dt <= 0.0) {
+        return;
+    }
+
+    const size_t n = ids.size();
+    for (size_t i = 0; i < n; i++) {
+        double newX = x[i] + vx[i] * dt;
+        double newY = y[i] + vy[i] * dt;
+        double newZ = z[i] + vz[i] * dt;
+
+        bool wasBounded = isPositionWithinBounds(x[i], y[i], z[i]);
+        bool willBeBounded = isPositionWithinBounds(newX, newY, newZ);
+
+        if (wasBounded && !willBeBounded) {
+            // Park the aircraft on the boundary it crossed, as Plane::updatePosition does
+            if (newX < AIRSPACE_X_MIN) x[i] = AIRSPACE_X_MIN;
+            else if (newX > AIRSPACE_X_MAX) x[i] = AIRSPACE_X_MAX;
+
+            if (newY < AIRSPACE_Y_MIN) y[i] = AIRSPACE_Y_MIN;
+            else if (newY > AIRSPACE_Y_MAX) y[i] = AIRSPACE_Y_MAX;
+
+            if (newZ < AIRSPACE_Z_MIN) z[i] = AIRSPACE_Z_MIN;
+            else if (newZ > AIRSPACE_Z_MAX) z[i] = AIRSPACE_Z_MAX;
+
+            vx[i] = vy[i] = vz[i] = 0.0;
+            epochs[i] = nextEpoch++;
+
+            LOG_PLANE(ids[i], LOG_WARNING, "Exiting airspace, now at boundary (", x[i], ",", y[i],
+                      ",", z[i], ") with zero velocity");
+            EVENT_LOG(EVSUB_RADAR, EVT_TRACK_STOPPED, ids[i], x[i], y[i], z[i]);
+        } else {
+            if (!wasBounded && willBeBounded) {
+                LOG_PLANE(ids[i], LOG_INFO, "Entering airspace");
+            }
+            x[i] = newX;
+            y[i] = newY;
+            z[i] = newZ;
+        }
+    }
+}
+
+size_t KinematicsEngine::removeStopped(std::vector<int>& removedIds) {
+    const size_t n = ids.size();
+    size_t out = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        bool outsideBounds = !isPositionWithinBounds(x[i], y[i], z[i]);
+        bool atBoundary = (
+            (vx[i] == 0 && vy[i] == 0 && vz[i] == 0) &&
+            (x[i] == AIRSPACE_X_MIN || x[i] == AIRSPACE_X_MAX ||
+             y[i] == AIRSPACE_Y_MIN || y[i] == AIRSPACE_Y_MAX ||
+             z[i] == AIRSPACE_Z_MIN || z[i] == AIRSPACE_Z_MAX)
+        );
+
+        if (outsideBounds || atBoundary) {
+            removedIds.push_back(ids[i]);
+            indexById.erase(ids[i]);
+            continue;
+        }
+
+        if (out != i) {
+            ids[out] = ids[i];
+            x[out] = x[i];   y[out] = y[i];   z[out] = z[i];
+            vx[out] = vx[i]; vy[out] = vy[i]; vz[out] = vz[i];
+            epochs[out] = epochs[i];
+            indexById[ids[out]] = out;
+        }
+        out++;
+    }
+
+    size_t removed = n - out;
+    if (removed > 0) {
+        ids.resize(out);
+        x.resize(out);  y.resize(out);  z.resize(out);
+        vx.resize(out); vy.resize(out); vz.resize(out);
+        epochs.resize(out);
+    }
+    return removed;
+}
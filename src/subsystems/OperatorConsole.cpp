@@ -6,11 +6,15 @@
 #include <queue>
 #include <atomic>
 #include <sstream>
-#include <sys/neutrino.h>
+#include <algorithm>
+#include "Ipc.h"
 #include <sys/stat.h>
 #include "utils.h"
 #include "shm_utils.h"
 
+// Alerts listed individually per batch; the rest are summarised in one line
+static const size_t MAX_RENDERED_ALERTS = 50;
+
 pthread_mutex_t OperatorConsole::mutex = PTHREAD_MUTEX_INITIALIZER;
 std::queue<OperatorConsoleResponseMessage> OperatorConsole::responseQueue;
 
@@ -50,11 +54,11 @@ void OperatorConsole::run()
 {
     ensureLogDirectories();
 
-    chid = ChannelCreate(0);
+    chid = ipcChannelCreate();
     
     if (chid == -1)
     {
-        logOperatorConsoleMessage("ChannelCreate failed: " + std::string(strerror(errno)), LOG_ERROR);
+        logOperatorConsoleMessage("Channel creation failed: " + std::string(strerror(errno)), LOG_ERROR);
         return;
     }
 
@@ -72,24 +76,29 @@ void OperatorConsole::run()
 
     stop = true;
     pthread_join(thr, nullptr);
-    ChannelDestroy(chid);
+    ipcChannelDestroy(chid);
 
     logOperatorConsoleMessage("OperatorConsole shutdown complete");
 }
 
 void OperatorConsole::listen()
 {
-    OperatorConsoleCommandMessage msg;
+    // Every message starts with systemCommandType
+    union {
+        OperatorConsoleCommandMessage command;
+        OperatorConsoleAlertBatchMessage alertBatch;
+    } buffer;
+    OperatorConsoleCommandMessage &msg = buffer.command;
     int rcvid;
 
     logOperatorConsoleMessage("Starting message processing loop");
 
     while (true)
     {
-        rcvid = MsgReceive(chid, &msg, sizeof(msg), nullptr);
+        rcvid = ipcReceive(chid, &buffer, sizeof(buffer), nullptr);
         if (rcvid == -1)
         {
-            logOperatorConsoleMessage("MsgReceive failed: " + std::string(strerror(errno)), LOG_ERROR);
+            logOperatorConsoleMessage("Receive failed: " + std::string(strerror(errno)), LOG_ERROR);
             continue;
         }
 
@@ -103,14 +112,14 @@ void OperatorConsole::listen()
             if (responseQueue.empty())
             {
                 resp.userCommandType = OPCON_USER_COMMAND_NO_COMMAND_AVAILABLE;
-                MsgReply(rcvid, EOK, &resp, sizeof(resp));
-                logOperatorConsoleMessage("No user commands available", LOG_DEBUG);
+                ipcReply(rcvid, EOK, &resp, sizeof(resp));
+                LOG_OPERATOR_CONSOLE(LOG_DEBUG, "No user commands available");
             }
             else
             {
                 resp = responseQueue.front();
                 responseQueue.pop();
-                MsgReply(rcvid, EOK, &resp, sizeof(resp));
+                ipcReply(rcvid, EOK, &resp, sizeof(resp));
 
                 std::string cmdTypeStr;
                 switch (resp.userCommandType)
@@ -159,25 +168,91 @@ void OperatorConsole::listen()
 
             OperatorConsoleResponseMessage r;
             r.userCommandType = OPCON_USER_COMMAND_NO_COMMAND_AVAILABLE;
-            MsgReply(rcvid, EOK, &r, sizeof(r));
+            ipcReply(rcvid, EOK, &r, sizeof(r));
+            break;
+        }
+
+        case OPCON_CONSOLE_COMMAND_ALERT_BATCH:
+        {
+            if (receiveAlertBatch(rcvid, buffer.alertBatch))
+            {
+                ipcReply(rcvid, EOK, nullptr, 0);
+                renderAlertBatch(buffer.alertBatch.frameTimestamp);
+            }
             break;
         }
 
         case COMMAND_EXIT_THREAD:
             logOperatorConsoleMessage("Received exit command");
-            MsgReply(rcvid, EOK, nullptr, 0);
+            ipcReply(rcvid, EOK, nullptr, 0);
             return;
 
         default:
             logOperatorConsoleMessage("Unknown system command: " +
                                           std::to_string(msg.systemCommandType),
                                       LOG_WARNING);
-            MsgError(rcvid, ENOSYS);
+            ipcError(rcvid, ENOSYS);
             break;
         }
     }
 }
 
+bool OperatorConsole::receiveAlertBatch(int rcvid, const OperatorConsoleAlertBatchMessage &msg)
+{
+    if (msg.numAlerts > MAX_ALERTS_PER_BATCH)
+    {
+        logOperatorConsoleMessage("Invalid alert batch size: " + std::to_string(msg.numAlerts),
+                                  LOG_ERROR);
+        ipcError(rcvid, EINVAL);
+        return false;
+    }
+
+    // The alerts follow the fixed batch header
+    alertBuffer.resize(msg.numAlerts);
+    long bytes = (long)(msg.numAlerts * sizeof(ConflictAlert));
+    if (bytes > 0 &&
+        ipcRead(rcvid, alertBuffer.data(), bytes, sizeof(OperatorConsoleAlertBatchMessage)) != bytes)
+    {
+        logOperatorConsoleMessage("Failed to read alert batch: " + std::string(strerror(errno)),
+                                  LOG_ERROR);
+        ipcError(rcvid, EBADMSG);
+        return false;
+    }
+    return true;
+}
+
+void OperatorConsole::renderAlertBatch(double frameTimestamp)
+{
+    if (alertBuffer.empty())
+    {
+        return;
+    }
+
+    // Most urgent first
+    std::stable_sort(alertBuffer.begin(), alertBuffer.end(),
+                     [](const ConflictAlert &a, const ConflictAlert &b) {
+                         return a.collisionTimeSeconds < b.collisionTimeSeconds;
+                     });
+
+    std::string text = "ALERT: " + std::to_string(alertBuffer.size()) +
+                       " predicted separation violation(s) at radar time " +
+                       std::to_string(frameTimestamp) + "s";
+
+    size_t shown = std::min(alertBuffer.size(), MAX_RENDERED_ALERTS);
+    for (size_t i = 0; i < shown; i++)
+    {
+        const ConflictAlert &a = alertBuffer[i];
+        text += "\n  Planes " + std::to_string(a.plane1) + " & " + std::to_string(a.plane2) +
+                " possible collision in " + std::to_string(a.collisionTimeSeconds) + "s";
+    }
+    if (shown < alertBuffer.size())
+    {
+        text += "\n  ... and " + std::to_string(alertBuffer.size() - shown) + " more";
+    }
+
+    logOperatorConsoleMessage(text, LOG_WARNING);
+}
+
 void *OperatorConsole::cinRead(void *param)
 {
     std::atomic_bool *stop = static_cast<std::atomic_bool *>(param);
@@ -273,6 +348,7 @@ void *OperatorConsole::cinRead(void *param)
                 r.userCommandType = OPCON_USER_COMMAND_SET_PLANE_VELOCITY;
                 r.planeNumber = planeId;
                 r.newVelocity = {vx, vy, vz};
+                r.issuedNs = monotonicNanos();
 
                 pthread_mutex_lock(&mutex);
                 responseQueue.push(r);
@@ -1,7 +1,6 @@
 #include "Plane.h"
 #include <iostream>
 #include <mutex>
-#include <unistd.h> 
 #include "utils.h"
 
 Plane::Plane(int pid, double px, double py, double pz,
@@ -9,11 +8,10 @@ Plane::Plane(int pid, double px, double py, double pz,
     : id(pid), 
       x(px), y(py), z(pz),
       vx(vx_), vy(vy_), vz(vz_), 
-      lastUpdateTime(0.0),
-      running(false)
+      lastUpdateTime(0.0)
 {
     if (!isPositionWithinBounds(x, y, z)) {
-        logPlaneMessage(id, "Started out-of-bounds, clamping to boundaries", LOG_WARNING);
+        LOG_PLANE(id, LOG_WARNING, "Started out-of-bounds, clamping to boundaries");
         
         // Clamp to boundaries
         if (x < AIRSPACE_X_MIN) x = AIRSPACE_X_MIN;
@@ -25,57 +23,15 @@ Plane::Plane(int pid, double px, double py, double pz,
         if (z < AIRSPACE_Z_MIN) z = AIRSPACE_Z_MIN;
         else if (z > AIRSPACE_Z_MAX) z = AIRSPACE_Z_MAX;
         
-        logPlaneMessage(id, "Position clamped to (" + 
-                           std::to_string(x) + "," + 
-                           std::to_string(y) + "," + 
-                           std::to_string(z) + ")");
+        LOG_PLANE(id, LOG_INFO, "Position clamped to (", x, ",", y, ",", z, ")");
     }
     
-    logPlaneMessage(id, "Plane initialized at (" + 
-                       std::to_string(x) + "," + 
-                       std::to_string(y) + "," + 
-                       std::to_string(z) + ") with velocity (" +
-                       std::to_string(vx) + "," + 
-                       std::to_string(vy) + "," + 
-                       std::to_string(vz) + ")");
+    LOG_PLANE(id, LOG_INFO, "Plane initialized at (", x, ",", y, ",", z, ") with velocity (", vx,
+              ",", vy, ",", vz, ")");
 }
 
 Plane::~Plane() {
-    stop();
-    logPlaneMessage(id, "Plane destroyed");
-}
-
-void Plane::start(double startTime) {
-    // Guard against restarting an already running plane.
-    if (running) {
-        logPlaneMessage(id, "Plane already running, start() ignored", LOG_DEBUG);
-        return;
-    }
-    running = true;
-    planeThread = std::thread(&Plane::runPlaneProcess, this, startTime);
-    logPlaneMessage(id, "Plane thread started at time " + std::to_string(startTime));
-}
-
-void Plane::stop() {
-    if (running) {
-        running = false;
-        if (planeThread.joinable()) {
-            planeThread.join();
-            logPlaneMessage(id, "Plane thread stopped");
-        }
-    }
-}
-
-void Plane::runPlaneProcess(double startTime) {
-    lastUpdateTime = startTime;
-    
-    logPlaneMessage(id, "Plane process running, starting at time " + std::to_string(startTime));
-    
-    while (running) {
-        updatePosition(lastUpdateTime + 1.0);
-        
-        usleep(1000000); // 1 second
-    }
+    LOG_PLANE(id, LOG_INFO, "Plane destroyed");
 }
 
 void Plane::updatePosition(double currentTime) {
@@ -98,9 +54,9 @@ void Plane::updatePosition(double currentTime) {
         std::lock_guard<std::mutex> lock(positionMutex);
         
         if (!wasBounded && willBeBounded) {
-            logPlaneMessage(id, "Entering airspace");
+            LOG_PLANE(id, LOG_INFO, "Entering airspace");
         } else if (wasBounded && !willBeBounded) {
-            logPlaneMessage(id, "Exiting airspace", LOG_WARNING);
+            LOG_PLANE(id, LOG_WARNING, "Exiting airspace");
             
             // Calculate intersection point with boundary
             double boundaryX = x, boundaryY = y, boundaryZ = z;
@@ -122,20 +78,14 @@ void Plane::updatePosition(double currentTime) {
             // Stop the plane at the boundary
             vx = vy = vz = 0.0;
             
-            logPlaneMessage(id, "Now at boundary (" + 
-                               std::to_string(x) + "," + 
-                               std::to_string(y) + "," + 
-                               std::to_string(z) + ") with zero velocity");
+            LOG_PLANE(id, LOG_INFO, "Now at boundary (", x, ",", y, ",", z, ") with zero velocity");
         } else {
             // Normal update within bounds
             x = newX;
             y = newY;
             z = newZ;
             
-            logPlaneMessage(id, "Position updated to (" + 
-                               std::to_string(x) + "," + 
-                               std::to_string(y) + "," + 
-                               std::to_string(z) + ")", LOG_DEBUG);
+            LOG_PLANE(id, LOG_DEBUG, "Position updated to (", x, ",", y, ",", z, ")");
         }
         
         lastUpdateTime = currentTime;
@@ -179,10 +129,7 @@ void Plane::setVelocity(double vx_, double vy_, double vz_) {
     vy = vy_;
     vz = vz_;
     
-    logPlaneMessage(id, "Velocity updated to (" + 
-                       std::to_string(vx) + "," + 
-                       std::to_string(vy) + "," + 
-                       std::to_string(vz) + ")");
+    LOG_PLANE(id, LOG_INFO, "Velocity updated to (", vx, ",", vy, ",", vz, ")");
 }
 
 void Plane::setPosition(double px, double py, double pz) {
@@ -191,8 +138,5 @@ void Plane::setPosition(double px, double py, double pz) {
     y = py;
     z = pz;
     
-    logPlaneMessage(id, "Position manually set to (" + 
-                       std::to_string(x) + "," + 
-                       std::to_string(y) + "," + 
-                       std::to_string(z) + ")");
+    LOG_PLANE(id, LOG_INFO, "Position manually set to (", x, ",", y, ",", z, ")");
 }
\ No newline at end of file
@@ -7,123 +7,253 @@
 #include <algorithm>
 #include "commandCodes.h"
 #include "utils.h"
+#include "EventLog.h"
 #include "shm_utils.h"
 
-Radar::Radar() {
-    logRadarMessage("Radar system initialized");
+Radar::Radar()
+    : lastUpdateTime(-1.0), frameSegment(logRadarMessage), uplinkSegment(logRadarMessage),
+      ackSegment(logRadarMessage), replaying(false) {
+    LOG_RADAR(LOG_INFO, "Radar system initialized");
 }
 
 Radar::~Radar() {
-    std::lock_guard<std::mutex> lock(planesMutex);
-    for (Plane* plane : trackedPlanes) {
-        plane->stop();
+    LOG_RADAR(LOG_INFO, "Radar system shutdown, all plane tracking stopped");
+}
+
+void Radar::trackPlane(Plane* p) {
+    if (!engine.addAircraft(p->getId(),
+                            p->getX(), p->getY(), p->getZ(),
+                            p->getVx(), p->getVy(), p->getVz())) {
+        LOG_RADAR(LOG_WARNING, "Plane ", p->getId(), " already tracked, ignoring add request");
+        return;
     }
-    trackedPlanes.clear();
-    logRadarMessage("Radar system shutdown, all plane tracking stopped");
+
+    LOG_RADAR(LOG_INFO, "Started tracking plane ", p->getId(), " at position (", p->getX(), ",",
+              p->getY(), ",", p->getZ(), ")");
 }
 
 void Radar::detectAircraft(std::vector<Plane*>& planes, double currentTime) {
     std::lock_guard<std::mutex> lock(planesMutex);
-    trackedPlanes.clear();
     
-    logRadarMessage("Detecting aircraft, found " + std::to_string(planes.size()));
+    LOG_RADAR(LOG_INFO, "Detecting aircraft, found ", planes.size());
     
+    engine.reserve(planes.size());
     for (Plane* p : planes) {
-        trackedPlanes.push_back(p);
-        p->start(currentTime);
-        
-        logRadarMessage("Added plane " + std::to_string(p->getId()) + 
-                       " at position (" + 
-                       std::to_string(p->getX()) + "," + 
-                       std::to_string(p->getY()) + "," + 
-                       std::to_string(p->getZ()) + ")");
+        trackPlane(p);
+    }
+    
+    if (lastUpdateTime < 0) {
+        lastUpdateTime = currentTime;
     }
 }
 
 void Radar::addPlane(Plane* plane, double currentTime) {
     std::lock_guard<std::mutex> lock(planesMutex);
     
-    auto it = std::find_if(trackedPlanes.begin(), trackedPlanes.end(), 
-                          [plane](Plane* p) { return p->getId() == plane->getId(); });
+    trackPlane(plane);
     
-    if (it == trackedPlanes.end()) {
-        trackedPlanes.push_back(plane);
-        // Start the plane's thread
-        plane->start(currentTime);
-        
-        logRadarMessage("Started tracking plane " + std::to_string(plane->getId()) + 
-                       " at position (" + 
-                       std::to_string(plane->getX()) + "," + 
-                       std::to_string(plane->getY()) + "," + 
-                       std::to_string(plane->getZ()) + ")");
-    } else {
-        logRadarMessage("Plane " + std::to_string(plane->getId()) + 
-                       " already tracked, ignoring add request", LOG_WARNING);
+    if (lastUpdateTime < 0) {
+        lastUpdateTime = currentTime;
     }
 }
 
 void Radar::removePlane(int planeId) {
     std::lock_guard<std::mutex> lock(planesMutex);
     
-    auto it = std::find_if(trackedPlanes.begin(), trackedPlanes.end(), 
-                          [planeId](Plane* p) { return p->getId() == planeId; });
-    
-    if (it != trackedPlanes.end()) {
-        trackedPlanes.erase(it);
-        logRadarMessage("Stopped tracking plane " + std::to_string(planeId));
+    if (engine.removeAircraft(planeId)) {
+        LOG_RADAR(LOG_INFO, "Stopped tracking plane ", planeId);
     } else {
-        logRadarMessage("Cannot remove plane " + std::to_string(planeId) + 
-                       ", not currently tracked", LOG_WARNING);
+        LOG_RADAR(LOG_WARNING, "Cannot remove plane ", planeId, ", not currently tracked");
     }
 }
 
 void Radar::update(double currentTime) {
     std::lock_guard<std::mutex> lock(planesMutex);
     
-    for (size_t i = 0; i < trackedPlanes.size();) {
-        Plane* plane = trackedPlanes[i];
-        
-        bool outsideBounds = !isPositionWithinBounds(plane->getX(), plane->getY(), plane->getZ());
-        bool atBoundary = (
-            (plane->getVx() == 0 && plane->getVy() == 0 && plane->getVz() == 0) && 
-            (plane->getX() == AIRSPACE_X_MIN || plane->getX() == AIRSPACE_X_MAX || 
-             plane->getY() == AIRSPACE_Y_MIN || plane->getY() == AIRSPACE_Y_MAX || 
-             plane->getZ() == AIRSPACE_Z_MIN || plane->getZ() == AIRSPACE_Z_MAX)
-        );
-        
-        if (outsideBounds || atBoundary) {
-            std::string reason = outsideBounds ? "left the airspace" : "reached boundary and stopped";
-            logRadarMessage("Plane " + std::to_string(plane->getId()) + " " + reason, LOG_WARNING);
-            trackedPlanes.erase(trackedPlanes.begin() + i);
-        } else {
-            i++; // Only increment if we didn't remove a plane
+    // Advance every aircraft by the same dt so the frame is one consistent instant
+    if (lastUpdateTime < 0) {
+        lastUpdateTime = currentTime;
+    }
+    engine.advance(currentTime - lastUpdateTime);
+    lastUpdateTime = currentTime;
+
+    removedIds.clear();
+    engine.removeStopped(removedIds);
+    for (int id : removedIds) {
+        LOG_RADAR(LOG_WARNING, "Plane ", id, " reached boundary and stopped");
+    }
+
+    // Commands received since the last tick take effect from this frame on
+    applyCommands();
+
+    const size_t n = engine.size();
+    if (n > 0) {
+        LOG_RADAR(LOG_DEBUG, "Updating radar data with ", n, " planes");
+    }
+
+    if (!publishFrame(currentTime)) {
+        LOG_RADAR(LOG_ERROR, "Failed to update radar data in shared memory");
+        return;
+    }
+
+    if (eventLogEnabled()) {
+        const std::vector<int>& ids = engine.getIds();
+        const std::vector<double>& x = engine.getX();
+        const std::vector<double>& y = engine.getY();
+        const std::vector<double>& z = engine.getZ();
+        eventLogWrite(EVSUB_RADAR, EVT_RADAR_FRAME, n,
+                      frameSegment.as<RadarFrameHeader>()->sequence.load(std::memory_order_relaxed));
+        for (size_t i = 0; i < n; i++) {
+            eventLogWrite(EVSUB_RADAR, EVT_TRACK_POSITION, ids[i], x[i], y[i], z[i]);
         }
     }
+}
 
-    RadarData data;
-    data.numPlanes = (int)std::min(trackedPlanes.size(), (size_t)MAX_PLANES);
-    
-    if (data.numPlanes > 0) {
-        logRadarMessage("Updating radar data with " + std::to_string(data.numPlanes) + " planes", LOG_DEBUG);
+void Radar::applyCommands() {
+    CommandRingHeader* uplink = openCommandRing(uplinkSegment, SHM_UPLINK);
+    if (!uplink) {
+        return;
     }
-    
-    for (int i = 0; i < data.numPlanes; i++) {
-        Plane* p = trackedPlanes[i];
-        data.positions[i] = { p->getId(), p->getX(), p->getY(), p->getZ(), time(nullptr) };
-        data.velocities[i] = { p->getId(), p->getVx(), p->getVy(), p->getVz(), time(nullptr) };
-    }
-
-    bool success = accessSharedMemory<RadarData>(
-        SHM_RADAR_DATA,
-        sizeof(RadarData),
-        O_RDWR,
-        false,
-        [&data](RadarData* rd) {
-            memcpy(rd, &data, sizeof(RadarData));
+    CommandRingHeader* acks = openCommandRing(ackSegment, SHM_COMMAND_ACKS);
+
+    Command cmd;
+    while (commandRingTryPop(uplink, cmd)) {
+        cmd.appliedNs = monotonicNanos();
+        cmd.status = applyCommand(cmd);
+        EVENT_LOG(EVSUB_RADAR, EVT_COMMAND_APPLIED, cmd.sequence, cmd.planeId, cmd.status,
+                  cmd.value[0], cmd.value[1], cmd.value[2]);
+
+        if (!acks || !commandRingPush(acks, cmd)) {
+            LOG_RADAR(LOG_WARNING, "Cannot acknowledge command #", cmd.sequence,
+                      ", acknowledgement ring unavailable or full");
         }
-    );
-    
-    if (!success) {
-        logRadarMessage("Failed to update radar data in shared memory", LOG_ERROR);
     }
-}
\ No newline at end of file
+}
+
+int Radar::applyCommand(const Command& cmd) {
+    if (replaying) {
+        LOG_RADAR(LOG_WARNING, "Command #", cmd.sequence, " for plane ", cmd.planeId,
+                  " ignored, recorded traffic is being replayed");
+        return CMD_STATUS_UNSUPPORTED;
+    }
+    if (cmd.code != CMD_VELOCITY) {
+        LOG_RADAR(LOG_WARNING, "Command #", cmd.sequence, " has unsupported code ", cmd.code);
+        return CMD_STATUS_UNSUPPORTED;
+    }
+
+    if (!engine.setVelocity(cmd.planeId, cmd.value[0], cmd.value[1], cmd.value[2])) {
+        LOG_RADAR(LOG_WARNING, "Command #", cmd.sequence, " targets plane ", cmd.planeId,
+                  ", which is not tracked");
+        return CMD_STATUS_UNKNOWN_AIRCRAFT;
+    }
+
+    LOG_RADAR(LOG_INFO, "Plane ", cmd.planeId, " velocity set to (", cmd.value[0], ",",
+              cmd.value[1], ",", cmd.value[2], ") by command #", cmd.sequence);
+    return CMD_STATUS_APPLIED;
+}
+
+bool Radar::ensureFrameCapacity(size_t n) {
+    if (!frameSegment.isOpen()) {
+        if (!frameSegment.open(SHM_RADAR_DATA, sizeof(RadarFrameHeader), O_RDWR, false)) {
+            return false;
+        }
+    }
+
+    uint32_t capacity = frameSegment.as<RadarFrameHeader>()->capacity;
+    if (capacity == 0 || capacity > MAX_RADAR_CAPACITY) {
+        return false;
+    }
+
+    if (n > capacity) {
+        // Grow the frame; readers notice the new capacity and remap
+        size_t grown = std::max(n, (size_t)capacity * 2);
+        uint32_t newCapacity = (uint32_t)std::min(grown, (size_t)MAX_RADAR_CAPACITY);
+        if (!frameSegment.resize(radarFrameSize(newCapacity))) {
+            return false;
+        }
+        frameSegment.as<RadarFrameHeader>()->capacity = newCapacity;
+        LOG_RADAR(LOG_WARNING, "Radar frame capacity grown from ", capacity, " to ", newCapacity,
+                  " tracks");
+        return true;
+    }
+
+    if (frameSegment.size() != radarFrameSize(capacity)) {
+        return frameSegment.remap(radarFrameSize(capacity));
+    }
+    return true;
+}
+
+bool Radar::publishFrame(double currentTime) {
+    const size_t n = engine.size();
+    if (!ensureFrameCapacity(n)) {
+        return false;
+    }
+
+    RadarFrameHeader* rh = frameSegment.as<RadarFrameHeader>();
+    uint32_t capacity = rh->capacity;
+    if (n > capacity) {
+        LOG_RADAR(LOG_WARNING, "Tracking ", n, " planes but radar frame capacity is ", capacity,
+                  ", publishing the first ", capacity);
+    }
+
+    const std::vector<int>& ids = engine.getIds();
+    const std::vector<double>& x = engine.getX();
+    const std::vector<double>& y = engine.getY();
+    const std::vector<double>& z = engine.getZ();
+    const std::vector<double>& vx = engine.getVx();
+    const std::vector<double>& vy = engine.getVy();
+    const std::vector<double>& vz = engine.getVz();
+    const std::vector<uint32_t>& epochs = engine.getEpochs();
+    uint32_t count = (uint32_t)std::min(n, (size_t)capacity);
+    time_t now = time(nullptr);
+
+    radarFrameBeginWrite(rh);
+    RadarTrack* tracks = radarFrameTracks(rh);
+    for (uint32_t i = 0; i < count; i++) {
+        tracks[i] = { ids[i], x[i], y[i], z[i], vx[i], vy[i], vz[i], now, epochs[i] };
+    }
+    rh->numPlanes = count;
+    rh->timestamp = currentTime;
+    rh->publishedNs = realtimeNanos();
+    rh->flags = 0;
+    radarFrameEndWrite(rh);
+    return true;
+}
+
+bool Radar::replayFrame(const HistoryFrame& frame) {
+    std::lock_guard<std::mutex> lock(planesMutex);
+
+    replaying = true;
+    applyCommands();
+
+    const size_t n = frame.size();
+    if (!ensureFrameCapacity(n)) {
+        LOG_RADAR(LOG_ERROR, "Failed to update radar data in shared memory");
+        return false;
+    }
+
+    RadarFrameHeader* rh = frameSegment.as<RadarFrameHeader>();
+    uint32_t capacity = rh->capacity;
+    if (n > capacity) {
+        LOG_RADAR(LOG_WARNING, "Recorded frame has ", n, " tracks but radar frame capacity is ",
+                  capacity, ", publishing the first ", capacity);
+    }
+
+    uint32_t count = (uint32_t)std::min(n, (size_t)capacity);
+
+    radarFrameBeginWrite(rh);
+    replayTracks.build(frame, radarFrameTracks(rh), count);
+    rh->numPlanes = count;
+    rh->timestamp = frame.simTime;
+    rh->publishedNs = frame.timeNs;
+    rh->flags = RADAR_FRAME_REPLAYED;
+    radarFrameEndWrite(rh);
+
+    if (eventLogEnabled()) {
+        eventLogWrite(EVSUB_RADAR, EVT_RADAR_FRAME, count, rh->sequence.load(std::memory_order_relaxed));
+        for (uint32_t i = 0; i < count; i++) {
+            eventLogWrite(EVSUB_RADAR, EVT_TRACK_POSITION, frame.ids[i], frame.x[i], frame.y[i], frame.z[i]);
+        }
+    }
+    return true;
+}
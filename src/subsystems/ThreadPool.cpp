@@ -0,0 +1,136 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : job(nullptr), remaining(0), generation(0), stopping(false)
+{
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+
+    for (size_t w = 0; w < threadCount; w++) {
+        queues.emplace_back(new WorkQueue());
+    }
+
+    // Worker 0 is whichever thread calls parallelFor()
+    for (size_t w = 1; w < threadCount; w++) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, w);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wakeCv.notify_all();
+
+    for (auto& t : threads) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t taskCount, const Task& fn)
+{
+    if (taskCount == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> jobLock(jobMutex);
+
+    if (threads.empty() || taskCount == 1) {
+        for (size_t t = 0; t < taskCount; t++) {
+            fn(t, 0);
+        }
+        return;
+    }
+
+    // Publish the job before any task becomes visible; workers only read
+    // it after popping a task under a queue mutex
+    job = &fn;
+    remaining.store(taskCount, std::memory_order_relaxed);
+
+    // Contiguous blocks keep neighbouring tasks on the same worker
+    const size_t workers = queues.size();
+    for (size_t w = 0; w < workers; w++) {
+        size_t begin = taskCount * w / workers;
+        size_t end = taskCount * (w + 1) / workers;
+        std::lock_guard<std::mutex> lock(queues[w]->mutex);
+        for (size_t t = begin; t < end; t++) {
+            queues[w]->tasks.push_back(t);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        generation++;
+    }
+    wakeCv.notify_all();
+
+    runTasks(0);
+
+    std::unique_lock<std::mutex> lock(stateMutex);
+    doneCv.wait(lock, [this]() { return remaining.load(std::memory_order_acquire) == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::workerLoop(size_t worker)
+{
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wakeCv.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        runTasks(worker);
+    }
+}
+
+void ThreadPool::runTasks(size_t worker)
+{
+    size_t task;
+    while (popLocal(worker, task) || steal(worker, task)) {
+        (*job)(task, worker);
+
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            doneCv.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::popLocal(size_t worker, size_t& task)
+{
+    WorkQueue& q = *queues[worker];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) {
+        return false;
+    }
+    task = q.tasks.back();
+    q.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t worker, size_t& task)
+{
+    const size_t workers = queues.size();
+    for (size_t k = 1; k < workers; k++) {
+        WorkQueue& q = *queues[(worker + k) % workers];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.tasks.empty()) {
+            task = q.tasks.front();
+            q.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
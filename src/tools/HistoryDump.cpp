@@ -0,0 +1,99 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "AirspaceHistory.h"
+
+/**
+ * atc-history: print frames from an airspace history (AirspaceHistory.h)
+ * in the layout of the former airspacelog.txt:
+ *
+ *   [2026-10-16 22:51:30.120] frame 42 t=41.0 tracks=2
+ *    Plane 1 => (14100.0,22050.0,5000.0) / vel(100.0,50.0,0.0)
+ *
+ * Usage: atc-history [--from TIME] [--to TIME] [--summary] [dir]
+ *
+ * TIME is local "YYYY-mm-dd HH:MM:SS[.fff]" or seconds since the epoch.
+ * --from seeks by binary search over the time index. --summary prints
+ * only the frame count, time span and size. The directory defaults to
+ * DEFAULT_AIRSPACE_HISTORY_PATH.
+ */
+
+static void usage() {
+    fprintf(stderr, "Usage: atc-history [--from TIME] [--to TIME] [--summary] [dir]\n"
+                    "  TIME: \"YYYY-mm-dd HH:MM:SS[.fff]\" (local) or seconds since the epoch\n");
+}
+
+int main(int argc, char* argv[]) {
+    std::string dir = DEFAULT_AIRSPACE_HISTORY_PATH;
+    int64_t from = INT64_MIN, to = INT64_MAX;
+    bool summary = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+            if (!parseHistoryTime(argv[++i], from)) {
+                usage();
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--to") == 0 && i + 1 < argc) {
+            if (!parseHistoryTime(argv[++i], to)) {
+                usage();
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--summary") == 0) {
+            summary = true;
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 2;
+        } else {
+            dir = argv[i];
+        }
+    }
+
+    AirspaceHistoryReader reader;
+    if (!reader.open(dir)) {
+        fprintf(stderr, "atc-history: %s is not an airspace history\n", dir.c_str());
+        return 1;
+    }
+
+    char timeText[64];
+    uint64_t ticks = reader.tickCount();
+    if (summary) {
+        uint64_t indexed = 0;
+        if (reader.blockCount() > 0) {
+            const HistoryBlockSummary& last = reader.block(reader.blockCount() - 1);
+            indexed = last.firstTick + last.ticks;
+        }
+        printf("%llu frames, %.1f MiB; %llu blocks indexed for atc-query, up to frame %llu\n",
+               (unsigned long long)ticks, reader.bytesUsed() / 1048576.0,
+               (unsigned long long)reader.blockCount(), (unsigned long long)indexed);
+        if (ticks > 0) {
+            formatHistoryTime(timeText, sizeof(timeText), reader.tick(0).timeNs);
+            printf("first %s\n", timeText);
+            formatHistoryTime(timeText, sizeof(timeText), reader.tick(ticks - 1).timeNs);
+            printf("last  %s\n", timeText);
+        }
+        return 0;
+    }
+
+    HistoryFrame frame;
+    uint64_t damaged = 0;
+    for (uint64_t i = reader.seek(from); i < ticks && reader.tick(i).timeNs <= to; i++) {
+        if (!reader.readFrame(i, frame)) {
+            damaged++;
+            continue;
+        }
+        formatHistoryTime(timeText, sizeof(timeText), frame.timeNs);
+        printf("[%s] frame %llu t=%.1f tracks=%zu\n", timeText,
+               (unsigned long long)(frame.sequence / 2), frame.simTime, frame.size());
+        for (size_t k = 0; k < frame.size(); k++) {
+            printf(" Plane %d => (%.1f,%.1f,%.1f) / vel(%.1f,%.1f,%.1f)\n", frame.ids[k],
+                   frame.x[k], frame.y[k], frame.z[k], frame.vx[k], frame.vy[k], frame.vz[k]);
+        }
+    }
+
+    if (damaged > 0) {
+        fprintf(stderr, "atc-history: %llu damaged frames skipped\n", (unsigned long long)damaged);
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "EventLog.h"
+
+/**
+ * atc-logdump: render a binary event log (EventLog.h) as text, one line
+ * per event in the order the slots were claimed:
+ *
+ *   [2026-10-16 22:51:30.123456789] [Radar] [DEBUG] track.position plane=3 x=... y=... z=...
+ *
+ * Usage: atc-logdump [--subsystem NAME] [--event NAME] [--level LEVEL] [--monotonic] [file]
+ *
+ * --monotonic prints raw CLOCK_MONOTONIC seconds instead of wall time.
+ * The file defaults to EVENT_LOG_DEFAULT_PATH.
+ */
+
+static const char* LEVEL_NAMES[] = { "DEBUG", "INFO", "WARNING", "ERROR" };
+
+static void usage() {
+    fprintf(stderr, "Usage: atc-logdump [--subsystem NAME] [--event NAME] [--level LEVEL] "
+                    "[--monotonic] [file]\n");
+}
+
+static int parseLevel(const char* name) {
+    for (int i = LOG_DEBUG; i <= LOG_ERROR; i++) {
+        if (strcasecmp(name, LEVEL_NAMES[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void formatTime(char* buf, size_t size, int64_t ns, const EventLogHeader* header, bool monotonic) {
+    if (monotonic) {
+        snprintf(buf, size, "%lld.%09lld", (long long)(ns / 1000000000LL), (long long)(ns % 1000000000LL));
+        return;
+    }
+    int64_t wall = header->createdRealtimeNs + (ns - header->createdMonotonicNs);
+    time_t seconds = (time_t)(wall / 1000000000LL);
+    struct tm local;
+    localtime_r(&seconds, &local);
+    size_t n = strftime(buf, size, "%Y-%m-%d %H:%M:%S", &local);
+    snprintf(buf + n, size - n, ".%09lld", (long long)(wall % 1000000000LL));
+}
+
+static void formatArg(std::string& out, const EventRecord& r, int i) {
+    char buf[64];
+    switch ((r.argTypes >> (2 * i)) & 3) {
+        case EVENT_ARG_INT:    snprintf(buf, sizeof(buf), "%lld", (long long)r.args[i].i); break;
+        case EVENT_ARG_UINT:   snprintf(buf, sizeof(buf), "%llu", (unsigned long long)r.args[i].u); break;
+        default:               snprintf(buf, sizeof(buf), "%f", r.args[i].d); break;
+    }
+    out += buf;
+}
+
+int main(int argc, char* argv[]) {
+    const char* path = EVENT_LOG_DEFAULT_PATH;
+    const char* subsystemFilter = nullptr;
+    const char* eventFilter = nullptr;
+    int minLevel = LOG_DEBUG;
+    bool monotonic = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--subsystem") == 0 && i + 1 < argc) {
+            subsystemFilter = argv[++i];
+        } else if (strcmp(argv[i], "--event") == 0 && i + 1 < argc) {
+            eventFilter = argv[++i];
+        } else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            minLevel = parseLevel(argv[++i]);
+            if (minLevel < 0) {
+                usage();
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--monotonic") == 0) {
+            monotonic = true;
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 2;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "atc-logdump: cannot open %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(EventLogHeader)) {
+        fprintf(stderr, "atc-logdump: %s is not an event log\n", path);
+        close(fd);
+        return 1;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        fprintf(stderr, "atc-logdump: cannot map %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    const EventLogHeader* header = static_cast<const EventLogHeader*>(addr);
+    if (header->magic != EVENT_LOG_MAGIC || header->recordSize != sizeof(EventRecord)) {
+        fprintf(stderr, "atc-logdump: %s is not an event log or has an unsupported version\n", path);
+        return 1;
+    }
+
+    uint64_t fileRecords = (st.st_size - sizeof(EventLogHeader)) / sizeof(EventRecord);
+    uint64_t count = header->next.load(std::memory_order_acquire);
+    if (count > header->capacity) {
+        count = header->capacity;
+    }
+    if (count > fileRecords) {
+        count = fileRecords;
+    }
+
+    const EventRecord* records = reinterpret_cast<const EventRecord*>(
+        static_cast<const char*>(addr) + sizeof(EventLogHeader));
+    uint64_t printed = 0, incomplete = 0;
+    std::string line;
+    char timeText[64];
+
+    for (uint64_t i = 0; i < count; i++) {
+        const EventRecord& r = records[i];
+        int64_t ns = r.timestampNs.load(std::memory_order_acquire);
+        if (ns == 0) {
+            incomplete++;
+            continue;
+        }
+        if (r.event >= EVT_COUNT || r.subsystem >= EVSUB_COUNT) {
+            incomplete++;
+            continue;
+        }
+        const EventInfo& info = EVENT_CATALOG[r.event];
+        const char* subsystem = EVENT_SUBSYSTEM_NAMES[r.subsystem];
+        if ((subsystemFilter && strcmp(subsystemFilter, subsystem) != 0) ||
+            (eventFilter && strcmp(eventFilter, info.name) != 0) ||
+            r.level < minLevel) {
+            continue;
+        }
+
+        formatTime(timeText, sizeof(timeText), ns, header, monotonic);
+        line = "[";
+        line += timeText;
+        line += "] [";
+        line += subsystem;
+        line += "] [";
+        line += LEVEL_NAMES[r.level <= LOG_ERROR ? r.level : LOG_INFO];
+        line += "] ";
+        line += info.name;
+        for (int a = 0; a < r.argCount && a < EVENT_MAX_ARGS; a++) {
+            line += ' ';
+            line += (a < info.argCount && info.argNames[a]) ? info.argNames[a] : "arg";
+            line += '=';
+            formatArg(line, r, a);
+        }
+        line += '\n';
+        fwrite(line.data(), 1, line.size(), stdout);
+        printed++;
+    }
+
+    fprintf(stderr, "atc-logdump: %llu of %llu events shown, %llu incomplete, %llu dropped (file full)\n",
+            (unsigned long long)printed, (unsigned long long)count,
+            (unsigned long long)incomplete,
+            (unsigned long long)header->dropped.load(std::memory_order_relaxed));
+    munmap(addr, st.st_size);
+    return 0;
+}